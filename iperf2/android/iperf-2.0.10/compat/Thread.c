@@ -166,6 +166,26 @@ void thread_start( struct thread_Settings* thread ) {
     }
 } // end thread_start
 
+/* -------------------------------------------------------------------
+ * Start the thread chained after this one.  Threads that share a
+ * runGroup count hand off once, when the last of them ends.
+ * ------------------------------------------------------------------- */
+static void thread_start_next( struct thread_Settings* thread ) {
+    int last = 1;
+
+    if ( thread->runNext == NULL ) {
+        return;
+    }
+    if ( thread->runGroup != NULL ) {
+        Condition_Lock( thread_sNum_cond );
+        last = (--(*thread->runGroup) == 0);
+        Condition_Unlock( thread_sNum_cond );
+    }
+    if ( last ) {
+        thread_start( thread->runNext );
+    }
+}
+
 /* -------------------------------------------------------------------
  * Stop the specified object's thread execution (if any) immediately.
  * Decrements thread count and resets the thread ID.
@@ -176,6 +196,11 @@ void thread_stop( struct thread_Settings* thread ) {
     // Make sure we have been started
     if ( ! thread_equalid( thread->mTID, thread_zeroid() ) ) {
 
+        // a thread that fails still hands off to the one chained after it
+        if ( thread_equalid( thread_getid(), thread->mTID ) ) {
+            thread_start_next( thread );
+        }
+
         // decrement thread count
         Condition_Lock( thread_sNum_cond );
         thread_sNum--;
@@ -268,17 +293,16 @@ thread_run_wrapper( void* paramPtr ) {
     pthread_detach(thread->mTID);
 #endif
 
+    // Check if we need to start up a thread after executing this one,
+    // before the count drops so thread_joinall() can't see it at zero
+    thread_start_next( thread );
+
     // decrement thread count and send condition signal
     Condition_Lock( thread_sNum_cond );
     thread_sNum--;
     Condition_Signal( &thread_sNum_cond );
     Condition_Unlock( thread_sNum_cond );
 
-    // Check if we need to start up a thread after executing this one
-    if ( thread->runNext != NULL ) {
-        thread_start( thread->runNext );
-    }
-
     // Destroy this thread object
     Settings_Destroy( thread );
 
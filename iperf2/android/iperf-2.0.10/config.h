@@ -40,14 +40,34 @@
    if you don't. */
 #define HAVE_DECL_IPV6_MULTICAST_HOPS 1
 
+/* Define to 1 if you have the declaration of `IPV6_RECVPKTINFO', and to 0 if
+   you don't. */
+#define HAVE_DECL_IPV6_RECVPKTINFO 1
+
 /* Define to 1 if you have the declaration of `IP_ADD_MEMBERSHIP', and to 0 if
    you don't. */
 #define HAVE_DECL_IP_ADD_MEMBERSHIP 1
 
+/* Define to 1 if you have the declaration of `IP_ADD_SOURCE_MEMBERSHIP', and
+   to 0 if you don't. */
+#define HAVE_DECL_IP_ADD_SOURCE_MEMBERSHIP 1
+
+/* Define to 1 if you have the declaration of `IP_PKTINFO', and to 0 if you
+   don't. */
+#define HAVE_DECL_IP_PKTINFO 1
+
+/* Define to 1 if you have the declaration of `MCAST_JOIN_SOURCE_GROUP', and
+   to 0 if you don't. */
+#define HAVE_DECL_MCAST_JOIN_SOURCE_GROUP 1
+
 /* Define to 1 if you have the declaration of `SIGALRM', and to 0 if you
    don't. */
 #define HAVE_DECL_SIGALRM 1
 
+/* Define to 1 if you have the declaration of `SO_BUSY_POLL', and to 0 if you
+   don't. */
+#define HAVE_DECL_SO_BUSY_POLL 1
+
 /* Define to 1 if you have the declaration of `SO_SNDTIMEO', and to 0 if you
    don't. */
 #define HAVE_DECL_SO_SNDTIMEO 1
@@ -92,8 +112,14 @@
 /* Define if libws2_32 exists. */
 /* #undef HAVE_LIBWS2_32 */
 
-/* Define to 1 if you have the <memory.h> header file. */
-#define HAVE_MEMORY_H 1
+/* Define to 1 if you have the <linux/io_uring.h> header file. */
+#define HAVE_LINUX_IO_URING_H 1
+
+/* Define to 1 if you have the <linux/perf_event.h> header file. */
+#define HAVE_LINUX_PERF_EVENT_H 1
+
+/* Define to 1 if you have the <linux/sockios.h> header file. */
+#define HAVE_LINUX_SOCKIOS_H 1
 
 /* Define to 1 if you have the `memset' function. */
 #define HAVE_MEMSET 1
@@ -113,6 +139,9 @@
 /* Define to 1 if you have the <netinet/in.h> header file. */
 #define HAVE_NETINET_IN_H 1
 
+/* Define to 1 if you have the <net/netmap_user.h> header file. */
+/* #undef HAVE_NET_NETMAP_USER_H */
+
 /* */
 #define HAVE_POSIX_THREAD 1
 
@@ -123,11 +152,14 @@
 #define HAVE_PTHREAD 1
 
 /* Define to 1 if you have the `pthread_cancel' function. */
-/* #undef HAVE_PTHREAD_CANCEL */
+#define HAVE_PTHREAD_CANCEL 1
 
 /* */
 #define HAVE_QUAD_SUPPORT 1
 
+/* Define to 1 if you have the `recvmmsg' function. */
+#define HAVE_RECVMMSG 1
+
 /* Define to 1 if you have the `sched_setscheduler' function. */
 #define HAVE_SCHED_SETSCHEDULER 1
 
@@ -152,6 +184,9 @@
 /* Define to 1 if you have the <stdint.h> header file. */
 #define HAVE_STDINT_H 1
 
+/* Define to 1 if you have the <stdio.h> header file. */
+#define HAVE_STDIO_H 1
+
 /* Define to 1 if you have the <stdlib.h> header file. */
 #define HAVE_STDLIB_H 1
 
@@ -194,6 +229,9 @@
 /* Define to 1 if you have the <syslog.h> header file. */
 #define HAVE_SYSLOG_H 1
 
+/* Define to 1 if you have the <sys/epoll.h> header file. */
+#define HAVE_SYS_EPOLL_H 1
+
 /* Define to 1 if you have the <sys/select.h> header file. */
 #define HAVE_SYS_SELECT_H 1
 
@@ -291,13 +329,16 @@
 /* The size of `void*', as computed by sizeof. */
 /* #undef SIZEOF_VOIDP */
 
-/* Define to 1 if you have the ANSI C header files. */
+/* Define to 1 if all of the C90 standard headers exist (not just the ones
+   required in a freestanding environment). This macro is provided for
+   backward compatibility; new code need not use it. */
 #define STDC_HEADERS 1
 
 /* Define 3rd arg of accept */
 #define Socklen_t socklen_t
 
-/* Define to 1 if you can safely include both <sys/time.h> and <time.h>. */
+/* Define to 1 if you can safely include both <sys/time.h> and <time.h>. This
+   macro is obsolete. */
 #define TIME_WITH_SYS_TIME 1
 
 /* Define to 1 if your <sys/time.h> declares `struct tm'. */
@@ -330,7 +371,7 @@
 /* */
 /* #undef false */
 
-/* Define to `int' if <sys/types.h> does not define. */
+/* Define as a signed integer type capable of holding a process identifier. */
 /* #undef pid_t */
 
 /* Define to `unsigned int' if <sys/types.h> does not define. */
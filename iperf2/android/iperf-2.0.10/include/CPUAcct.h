@@ -0,0 +1,125 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * CPUAcct.h
+ * -------------------------------------------------------------------
+ * Per thread CPU accounting (--cpu).  A traffic thread opens its
+ * accounting when it starts its report: its CPU clock, and where
+ * perf_event_open() is allowed, cycle, instruction, cache miss and
+ * context switch counters that follow the thread.  The reporter
+ * samples those at each interval report, so it costs the traffic
+ * thread nothing per packet.  The final report also has the thread's
+ * own getrusage(RUSAGE_THREAD) user and system split.
+ * ------------------------------------------------------------------- */
+
+#ifndef CPUACCT_H
+#define CPUACCT_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    CPUACCT_CYCLES = 0,
+    CPUACCT_INSTRUCTIONS,
+    CPUACCT_CACHEMISSES,
+    CPUACCT_CTXSWITCHES,
+    CPUACCT_COUNTERS
+};
+
+// what a report prints, deltas over its interval
+typedef struct CPUStats {
+    int sampled;
+    int counters;                   // cycles etc. are valid
+    int rusage;                     // the final report's RUSAGE_THREAD split
+    double cpuSecs;
+    uint64_t count[CPUACCT_COUNTERS];
+    double userSecs;
+    double sysSecs;
+    long nvcsw;
+    long nivcsw;
+} CPUStats;
+
+typedef struct CPUAcct {
+    clockid_t clock;
+    int fd[CPUACCT_COUNTERS];
+    int counters;
+    double firstSecs;
+    double lastSecs;
+    uint64_t first[CPUACCT_COUNTERS];
+    uint64_t last[CPUACCT_COUNTERS];
+    struct rusage start;
+    struct rusage end;
+    int ended;
+} CPUAcct;
+
+// called by the thread to be measured, NULL if it can't be
+CPUAcct* CPUAcct_Open( void );
+
+// called by the measured thread as it finishes
+void CPUAcct_End( CPUAcct *acct );
+
+/*
+ * Called by any thread, fills in stats since the last interval
+ * sample or, if total, since CPUAcct_Open().  A total doesn't start
+ * a new interval and includes the RUSAGE_THREAD split once
+ * CPUAcct_End() has been called.
+ */
+void CPUAcct_Sample( CPUAcct *acct, CPUStats *stats, int total );
+
+void CPUAcct_Close( CPUAcct *acct );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // CPUACCT_H
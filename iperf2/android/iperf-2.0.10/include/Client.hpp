@@ -56,6 +56,12 @@
 
 #include "Settings.hpp"
 #include "Timestamp.hpp"
+#include "TimeBuckets.h"
+#include "Netmap.h"
+#include "Payload.h"
+
+// --write-latency, longest wait for writability between end of test checks
+#define WRITELATENCY_WAIT_MSECS 100
 
 /* ------------------------------------------------------------------- */
 class Client {
@@ -75,6 +81,13 @@ public:
     // TCP version which supports rate limiting per -b
     void RunRateLimitedTCP( void );
 
+    // TCP version that stamps each write and paces them per
+    // TCP_NOTSENT_LOWAT, --write-latency
+    void RunWriteLatencyTCP( void );
+
+    // RunTCP() once per --sweep step on the same connection
+    void RunSweep( void );
+
     void InitiateServer();
 
     // UDP / TCP
@@ -82,16 +95,54 @@ public:
 
     void write_UDP_FIN( );
 
+    // write mBuf as one datagram, through the netmap port when open
+    int write_UDP_datagram( );
+
     // client connect
     void Connect( );
 
 private :
+    // the Run() send loop, one instance per settings combination
+    typedef void (Client::*SendLoopFn)( ReportStruct *reportstruct, char *readAt,
+					double delay_target, double delay_lower_bounds );
+    template <bool UDP, bool Seq64, bool Payload, bool Buckets, bool FileInput, bool TimeMode>
+    void SendLoop( ReportStruct *reportstruct, char *readAt, double delay_target,
+		   double delay_lower_bounds );
+    static const SendLoopFn send_loops[64];
+
     void HdrXchange(int flags);
+    // --warmup's end for the write loops without interval reports
+    bool WarmupStart( void );
+    bool WarmupOver( max_size_t totLen );
+    void ClockSyncReply(void);
+    // --payload, a UDP datagram slot per PAYLOAD_SLOTS window, headed
+    // like mBuf once the server has been told of the test
+    void PayloadSlots( void );
+    // the next TCP write's data, --payload walks the pool
+    char* WriteAt( void ) {
+	return (mPayload != NULL) ? mPayload + (mPayloadNext & (PAYLOAD_POOL - 1)) : mBuf;
+    }
+#ifdef HAVE_LINUX_IO_URING_H
+    // io_uring version of the RunTCP() write loop
+    bool RingWriteTCP( ReportStruct *reportstruct, max_size_t *totLen );
+#endif
+#ifdef HAVE_NET_NETMAP_USER_H
+    // netmap version of the Run() UDP write loop
+    bool NetmapWriteUDP( ReportStruct *reportstruct, double delay_target );
+#endif
 
 protected:
     thread_Settings *mSettings;
     char* mBuf;
+    char* mPayload;                 // --payload pool
+    char* mSlots;                   // --payload, UDP
+    max_size_t mPayloadNext;        // --payload, TCP stream offset of the next write
+    TimeBuckets *mBuckets;          // --time-buckets
+#ifdef HAVE_NET_NETMAP_USER_H
+    Netmap *mNetmap;                // --netmap
+#endif
     Timestamp mEndTime;
+    Timestamp mWarmupEnd;           // --warmup
     Timestamp lastPacketTime;
 }; // end class Client
 
@@ -0,0 +1,97 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * Fanout.h
+ * -------------------------------------------------------------------
+ * One client testing many servers (--targets).  The targets come
+ * from a file or an IPv4 CIDR range, each gets its own -P streams
+ * and SUM report, and at most --fanout streams run at once.  Totals
+ * per target and for the whole run are printed at the end.
+ * ------------------------------------------------------------------- */
+
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include "headers.h"
+#include "Settings.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FANOUT_MAX_TARGETS 65536
+// streams running at once
+#define FANOUT_DEFAULT     64
+
+struct ReporterData;
+
+/*
+ * Read the targets from spec, a file with one host per line (# starts
+ * a comment) or an a.b.c.d/n range.  Returns the number of targets,
+ * 0 on error.
+ */
+int Fanout_Load( const char *spec );
+
+const char* Fanout_Host( int target );
+
+/*
+ * Called by client_init() in place of the usual -P copies, sets up
+ * every target's streams and chains them onto the pool slots
+ */
+void Fanout_Init( thread_Settings *clients );
+
+// called by the reporter with a stream's final totals
+void Fanout_Account( struct ReporterData *stats );
+
+// called once all the threads are done
+void Fanout_Print( void );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // FANOUT_H
@@ -0,0 +1,135 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * IOUring.h
+ * -------------------------------------------------------------------
+ * A minimal io_uring wrapper (raw syscalls, no liburing) used by the
+ * client and server traffic loops.  One ring serves one socket.
+ * The socket is registered as a fixed file and a single buffer of
+ * depth * buflen bytes is registered, slot i of which is used by
+ * the i'th operation in flight.
+ * ------------------------------------------------------------------- */
+
+#ifndef IOURING_H
+#define IOURING_H
+
+#include "headers.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IOURING_DEFAULT_DEPTH 8
+#define IOURING_MAX_DEPTH     256
+
+/*
+ * Completion tags.  Reads and writes complete with their slot
+ * number, everything else has one of the bits below set
+ */
+#define IOURING_TAG_TIMEOUT   0x40000000
+#define IOURING_TAG_CANCEL    0x20000000
+#define IOURING_TAG_MASK      0x0000FFFF
+
+typedef struct IOUring {
+    int ring_fd;
+    int sock;
+    int depth;
+    int buflen;
+    int fixedfile;
+    int fixedbuf;
+    int inflight;
+    char *buf;
+    // submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sq_pending;
+    struct io_uring_sqe *sqes;
+    // completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    // mappings
+    void *sq_ring;
+    size_t sq_ring_sz;
+    void *cq_ring;
+    size_t cq_ring_sz;
+    size_t sqes_sz;
+    struct __kernel_timespec timeout;
+} IOUring;
+
+// slot buffer address
+#define IOUring_Slot( ring, slot ) ((ring)->buf + ((slot) * (ring)->buflen))
+
+// returns 0 on success, -1 (with errno set) if the caller should fall back
+int IOUring_Init( IOUring *ring, int sock, int depth, int buflen );
+void IOUring_Destroy( IOUring *ring );
+
+// queue (but don't submit) an operation
+void IOUring_PrepRead( IOUring *ring, int slot );
+void IOUring_PrepWrite( IOUring *ring, int slot, int offset, int len, int link );
+void IOUring_PrepTimeout( IOUring *ring, long usecs );
+void IOUring_PrepCancel( IOUring *ring, int slot );
+void IOUring_PrepCancelTimeout( IOUring *ring );
+
+// submit queued operations and wait for at least wait_nr completions
+int IOUring_Enter( IOUring *ring, int wait_nr );
+
+// pop one completion, returns 0 if the completion queue is empty
+int IOUring_Reap( IOUring *ring, unsigned *tag, int *res );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // HAVE_LINUX_IO_URING_H
+#endif // IOURING_H
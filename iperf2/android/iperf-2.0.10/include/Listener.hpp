@@ -58,6 +58,8 @@
 #include "Thread.h"
 #include "Settings.hpp"
 #include "Timestamp.hpp"
+#include "Netmap.h"
+#include "McastGroups.h"
 
 class Listener;
 
@@ -79,22 +81,37 @@ public:
 
     void McastJoin( );
 
+    // --mcast-groups, joins the channels not tried yet on mSock
+    int McastGroupsJoin( );
+
     void McastSetTTL( int val );
 
     void Accept( thread_Settings *server );
 
     void UDPSingleServer ();
 
+    // --mcast-groups, receives every channel in this thread
+    void McastGroupsServer( );
+
 protected:
     int mClients;
     char* mBuf;
     thread_Settings *mSettings;
     thread_Settings *server;
     Timestamp mEndTime;
+#ifdef HAVE_NET_NETMAP_USER_H
+    Netmap *mNetmap;                // --netmap
+#endif
+    int mJoined;                    // --mcast-groups channels tried
+    int mClosing;                   // --mcast-groups streams waiting on the reporter
 
 private:
     int ReadClientHeader(client_hdr *hdr);
-    int ClientHeaderAck(void);
+    int ClientHeaderAck(int ackflags);
+    int ClockSync(int peeklen);
+    void McastGroupsDatagram(struct msghdr *msg, int len, struct timeval *now, ReportStruct *reportstruct);
+    void McastGroupsStart(McastChannel *channel, iperf_sockaddr *peer, Socklen_t size_peer);
+    void McastGroupsEnd(McastChannel *channel, ReportStruct *reportstruct);
 }; // end class Listener
 
 #endif // LISTENER_H
@@ -137,6 +137,58 @@ extern const char report_bw_read_enhanced_format[];
 
 extern const char report_sum_bw_read_enhanced_format[];
 
+extern const char report_read_log2hist_format[];
+
+extern const char report_sum_read_log2hist_format[];
+
+extern const char report_read_log2bin[];
+
+extern const char report_tcpsample_header[];
+
+extern const char report_tcpsample_format[];
+
+extern const char report_clocksync[];
+
+extern const char report_clocksync_local[];
+
+extern const char report_timebuckets_header[];
+
+extern const char report_timebuckets_late[];
+
+extern const char report_timebuckets_format[];
+
+extern const char report_cpu_format[];
+
+extern const char report_cpu_counters[];
+
+extern const char report_cpu_rusage[];
+
+extern const char report_cpu_reporter[];
+
+extern const char report_cpu_reporter_counters[];
+
+extern const char report_write_latency_format[];
+
+extern const char report_sndq_format[];
+
+extern const char report_fanout_header[];
+
+extern const char report_fanout_format[];
+
+extern const char report_fanout_failed[];
+
+extern const char report_fanout_sum_format[];
+
+extern const char report_sweep_step[];
+
+extern const char report_sweep_header[];
+
+extern const char report_sweep_format[];
+
+extern const char report_sweep_rtt_format[];
+
+extern const char report_sweep_failed[];
+
 extern const char report_bw_write_enhanced_header[];
 
 extern const char report_bw_write_enhanced_format[];
@@ -163,6 +215,16 @@ extern const char report_sum_bw_jitter_loss_enhanced_format[];
 
 extern const char report_outoforder[];
 
+extern const char report_duplicates[];
+
+extern const char report_toolate[];
+
+extern const char report_mcast_joined[];
+
+extern const char report_reorder_log2hist_format[];
+
+extern const char report_payload_verify[];
+
 extern const char report_sum_outoforder[];
 
 extern const char report_peer[];
@@ -183,6 +245,10 @@ extern const char reportCSV_bw_format[];
 
 extern const char reportCSV_bw_jitter_loss_format[];
 
+extern const char reportCSV_cpu_format[];
+
+extern const char reportCSV_cpu_empty[];
+
 /* -------------------------------------------------------------------
  * warnings
  * ------------------------------------------------------------------- */
@@ -234,6 +300,52 @@ extern const char warn_len_too_small_peer_exchange[];
 extern const char warn_compat_and_peer_exchange[];
 
 extern const char warn_seqno_wrap[];
+
+extern const char warn_iouring_fallback[];
+
+extern const char warn_clocksync_failed[];
+
+extern const char warn_write_stamp_lost[];
+
+extern const char warn_netmap_open[];
+
+extern const char warn_netmap_mac[];
+
+extern const char warn_netmap_ipv6[];
+
+extern const char warn_netmap_len[];
+
+extern const char warn_netmap_fin[];
+
+extern const char warn_stats_shm[];
+
+extern const char warn_lwip_rtc[];
+
+extern const char warn_fanout_targets[];
+
+extern const char warn_fanout_max[];
+
+extern const char warn_fanout_mode[];
+
+extern const char warn_sweep_spec[];
+
+extern const char warn_sweep_mode[];
+
+extern const char warn_warmup_short[];
+
+extern const char warn_verify_no_payload[];
+
+extern const char warn_mcast_groups[];
+
+extern const char warn_mcast_entry[];
+
+extern const char warn_mcast_max[];
+
+extern const char warn_mcast_family[];
+
+extern const char warn_mcast_join[];
+
+extern const char warn_mcast_stray[];
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
@@ -0,0 +1,110 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * McastGroups.h
+ * -------------------------------------------------------------------
+ * One server receiving many multicast channels (--mcast-groups).
+ * A channel is a group (any source) or an SSM source and group, and
+ * all of them are joined by the listener on one socket, or a few
+ * when the kernel's per socket membership limit is reached.  The
+ * datagrams are told apart by their destination address, from
+ * IP_PKTINFO, and their sender, each channel running its own report
+ * off the listener's thread.
+ * ------------------------------------------------------------------- */
+
+#ifndef MCASTGROUPS_H
+#define MCASTGROUPS_H
+
+#include "headers.h"
+#include "Settings.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MCASTGROUPS_MAX_CHANNELS 65536
+// datagrams per recvmmsg() call
+#define MCASTGROUPS_BATCH        64
+// sockets the joins are spread over
+#define MCASTGROUPS_MAX_SOCKETS  256
+
+typedef struct McastChannel {
+    iperf_sockaddr group;
+    iperf_sockaddr source;          // SSM only
+    int ssm;
+    int sock;                       // joined on, INVALID_SOCKET if it failed
+    thread_Settings *server;        // the running stream's settings, else NULL
+    int closing;                    // FIN seen, waiting on the reporter
+    max_size_t stray;               // from senders other than the stream's
+    int next;                       // hash chain
+} McastChannel;
+
+/*
+ * Read the channels from spec, a file or a list of entries separated
+ * by commas or white space (# starts a comment in a file).  An entry
+ * is a group address or source@group for SSM.  Returns the number of
+ * channels, 0 on error.
+ */
+int McastGroups_Load( const char *spec );
+
+int McastGroups_Count( void );
+
+McastChannel* McastGroups_Channel( int channel );
+
+/*
+ * The channel a datagram to group from source belongs to, an SSM
+ * channel ahead of an any source one, NULL for none
+ */
+McastChannel* McastGroups_Lookup( iperf_sockaddr *group, iperf_sockaddr *source );
+
+// "group" or "source@group" for messages
+void McastGroups_Name( McastChannel *channel, char *name, int len );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // MCASTGROUPS_H
@@ -0,0 +1,211 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * Netmap.h
+ * -------------------------------------------------------------------
+ * A netmap data path for UDP traffic.  The sender builds one
+ * Ethernet/IPv4/UDP frame up front, copies it into every TX slot
+ * buffer once, and afterwards only patches the UDP_datagram header
+ * of the slots it hands to the kernel.  Whole rings are filled per
+ * NIOCTXSYNC.  The receiver walks the RX rings a batch at a time
+ * and picks out the test's datagrams by their UDP 4-tuple, reading
+ * them straight from the slot buffers.
+ * ------------------------------------------------------------------- */
+
+#ifndef NETMAP_H
+#define NETMAP_H
+
+#include "headers.h"
+
+#ifdef HAVE_NET_NETMAP_USER_H
+#include <net/netmap_user.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NETMAP_FRAME_HDRLEN  42   // ethernet + ipv4 + udp
+
+struct nm_desc;
+
+typedef struct Netmap {
+    struct nm_desc *desc;
+    struct netmap_if *nifp;
+    int fd;
+    uint16_t first_tx_ring, last_tx_ring, cur_tx_ring;
+    uint16_t first_rx_ring, last_rx_ring, cur_rx_ring;
+    uint16_t frame_len;             // bytes on the wire per datagram
+    u_char dst_mac[6];
+    u_char src_mac[6];
+    u_char *frame;                  // the prebuilt frame
+    // receive filter, network byte order
+    uint32_t saddr, daddr;
+    uint16_t sport, dport;
+} Netmap;
+
+/*
+ * Open a netmap port, e.g. netmap:eth0 or vale0:p1, optionally
+ * followed by ,<dst mac> (default broadcast).  Returns NULL on failure.
+ */
+Netmap* Netmap_Open( const char *portspec );
+void Netmap_Close( Netmap *nm );
+
+/*
+ * Build the frame from the connected socket's addresses and the
+ * payload (which starts with the UDP_datagram header), then stamp
+ * it into every TX slot.  IPv4 only, returns -1 if the frame
+ * can't be used.
+ */
+int Netmap_TxInit( Netmap *nm, iperf_sockaddr *local, iperf_sockaddr *peer,
+                   const char *payload, int len );
+
+// hand filled slots to the NIC, and wait (up to msecs) for free slots
+int Netmap_TxSync( Netmap *nm );
+int Netmap_TxWait( Netmap *nm, int msecs );
+
+// wait for the TX rings to drain, gives up after msecs
+void Netmap_TxDrain( Netmap *nm, int msecs );
+
+/*
+ * Claim the next free TX slot and return a pointer to its UDP
+ * payload, or NULL when every ring is full.  The slot goes out at
+ * the next Netmap_TxSync().  The pointer is only 2 byte aligned.
+ */
+static inline char* Netmap_TxNext( Netmap *nm ) {
+    while ( nm->cur_tx_ring <= nm->last_tx_ring ) {
+        struct netmap_ring *ring = NETMAP_TXRING( nm->nifp, nm->cur_tx_ring );
+        if ( !nm_ring_empty( ring ) ) {
+            uint32_t cur = ring->cur;
+            struct netmap_slot *slot = &ring->slot[cur];
+            slot->len = nm->frame_len;
+            ring->head = ring->cur = nm_ring_next( ring, cur );
+            return NETMAP_BUF( ring, slot->buf_idx ) + NETMAP_FRAME_HDRLEN;
+        }
+        nm->cur_tx_ring++;
+    }
+    return NULL;
+}
+
+/*
+ * Wait for the first datagram of a test sent to port, a datagram
+ * with a non-negative id.  Its payload is copied to buf, the
+ * addresses to peer and local, and the receive filter is set to
+ * its 4-tuple.  Returns the payload length or -1 (errno set).
+ */
+int Netmap_RxAccept( Netmap *nm, unsigned short port, char *buf, int len,
+                     iperf_sockaddr *peer, iperf_sockaddr *local );
+
+// sync the RX rings, waiting up to msecs (-1 forever) for traffic
+int Netmap_RxWait( Netmap *nm, int msecs );
+
+/*
+ * Return the UDP payload of a frame if it belongs to the test, i.e.
+ * is an unfragmented IPv4/UDP datagram matching the filter.
+ */
+static inline char* Netmap_RxMatch( Netmap *nm, char *frame, int framelen, int *len ) {
+    const u_char *ip = (const u_char*) frame + 14;
+    uint32_t addr;
+    uint16_t val;
+    int hl;
+
+    if ( framelen < NETMAP_FRAME_HDRLEN || frame[12] != 0x08 || frame[13] != 0x00 ||
+         (ip[0] >> 4) != 4 || ip[9] != IPPROTO_UDP || (ip[6] & 0x3F) != 0 || ip[7] != 0 )
+        return NULL;
+    hl = (ip[0] & 0x0F) << 2;
+    if ( framelen < 14 + hl + 8 )
+        return NULL;
+    memcpy( &addr, ip + 12, 4 );
+    if ( addr != nm->saddr )
+        return NULL;
+    memcpy( &addr, ip + 16, 4 );
+    if ( addr != nm->daddr )
+        return NULL;
+    memcpy( &val, ip + hl, 2 );
+    if ( val != nm->sport )
+        return NULL;
+    memcpy( &val, ip + hl + 2, 2 );
+    if ( val != nm->dport )
+        return NULL;
+    memcpy( &val, ip + hl + 4, 2 );
+    *len = ntohs( val ) - 8;
+    if ( *len < 0 || 14 + hl + 8 + *len > framelen )
+        return NULL;
+    return frame + 14 + hl + 8;
+}
+
+/*
+ * Return the payload of the next datagram of the test from the RX
+ * rings, or NULL once the rings are empty.  Other traffic is
+ * dropped.  The slot is released at the next Netmap_RxWait(), so the
+ * payload stays valid until then.  ts is the time of the ring's
+ * last sync, i.e. the batch arrival time.
+ */
+static inline char* Netmap_RxNext( Netmap *nm, int *len, struct timeval *ts ) {
+    while ( nm->cur_rx_ring <= nm->last_rx_ring ) {
+        struct netmap_ring *ring = NETMAP_RXRING( nm->nifp, nm->cur_rx_ring );
+        while ( !nm_ring_empty( ring ) ) {
+            uint32_t cur = ring->cur;
+            struct netmap_slot *slot = &ring->slot[cur];
+            char *payload;
+            ring->head = ring->cur = nm_ring_next( ring, cur );
+            payload = Netmap_RxMatch( nm, NETMAP_BUF( ring, slot->buf_idx ), slot->len, len );
+            if ( payload != NULL ) {
+                *ts = ring->ts;
+                return payload;
+            }
+        }
+        nm->cur_rx_ring++;
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // HAVE_NET_NETMAP_USER_H
+#endif // NETMAP_H
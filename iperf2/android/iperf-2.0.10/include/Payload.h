@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * Payload.h
+ * -------------------------------------------------------------------
+ * Generated payloads (--payload) and their check on the server
+ * (--verify).  Both ends build the same pool of bytes from a fixed
+ * seed, all zeros, a repeating pattern, incompressible PRNG output or
+ * PRNG output that deflates by about a given ratio.  TCP writes walk
+ * the pool as one endless stream, UDP datagrams take their payload
+ * from one of PAYLOAD_SLOTS windows into it picked by datagram ID, so
+ * the server knows what every byte should be without being sent it.
+ * ------------------------------------------------------------------- */
+
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include "headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// must be a power of two, the same on both ends
+#define PAYLOAD_POOL     (1 << 20)
+#define PAYLOAD_SLOTS    64
+// apart, the last slot's window still fits a 64K datagram
+#define PAYLOAD_STRIDE   9973
+// the compress ratio travels in the client header in hundredths
+#define PAYLOAD_RATIO_MAX 100
+
+enum {
+    kPayload_Default = 0,   // pattern() in the one buffer, not checkable
+    kPayload_Zeros,
+    kPayload_Pattern,
+    kPayload_Random,
+    kPayload_Compress
+};
+
+/*
+ * Parse "zeros", "pattern", "random" or "compress=<ratio>".  Returns
+ * the kPayload mode, 0 on error.
+ */
+int Payload_Parse( const char *spec, double *ratio );
+
+const char* Payload_Name( int mode );
+
+/*
+ * The pool for mode, PAYLOAD_POOL bytes followed by extra more that
+ * wrap around to its start so a write of up to extra bytes can start
+ * anywhere in it.  Free with Payload_Free().
+ */
+char* Payload_Pool( int mode, double ratio, int extra );
+
+void Payload_Free( char *pool );
+
+// where a UDP datagram's payload starts in the pool
+static inline max_size_t Payload_Slot( max_size_t id ) {
+    return (max_size_t) ((id % PAYLOAD_SLOTS) * PAYLOAD_STRIDE);
+}
+
+/*
+ * Compare len bytes read against the pool from stream offset pos on,
+ * wrapping at the pool's end.  Returns the number of bytes that
+ * differ.
+ */
+max_size_t Payload_Verify( const char *pool, max_size_t pos, const char *buf, long len );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // PAYLOAD_H
@@ -60,9 +60,16 @@ struct thread_Settings;
 struct server_hdr;
 
 #include "Settings.hpp"
+#include "CPUAcct.h"
+#include "SeqWindow.h"
 
 #define NUM_REPORT_STRUCTS 10000
+// --report-depth bounds, rings are pooled by power of two size class
+#define REPORT_DEPTH_MINLOG2 4
+#define REPORT_DEPTH_MAXLOG2 20
 #define NUM_MULTI_SLOTS    5
+// log2 read size bins, the last bin also holds reads of 8 MBytes or more
+#define READ_LOG2BINS      24
 // If the minimum latency exceeds the boundaries below
 // assume the clocks are not synched and suppress the
 // latency output. Units are seconds
@@ -102,6 +109,9 @@ typedef struct ReadStats {
     int bins[8];
     int totbins[8];
     int binsize;
+    // bin i counts reads of [2^i, 2^(i+1)) bytes
+    int log2bins[READ_LOG2BINS];
+    int totlog2bins[READ_LOG2BINS];
 } ReadStats;
 
 typedef struct WriteStats {
@@ -128,8 +138,31 @@ typedef struct ReportStruct {
     int errwrite;
     int emptyreport;
     int socket;
+    // successful writes folded into this one (--aggregate), 0 when
+    // it stands for a single read or write
+    int writeCnt;
 } ReportStruct;
 
+/*
+ * The compact ring entry, used by every report but the UDP server's,
+ * which needs each datagram's ID and send time.  The time is kept as
+ * a delta from the report's previous event and the reporter adds it
+ * back while decoding.
+ */
+#define REPORT_EVENT_EMPTY     0x1      // emptyreport
+#define REPORT_EVENT_ERRWRITE  0x2      // errwrite
+#define REPORT_EVENT_END       0x4      // packetID < 0, i.e. CloseReport()
+#define REPORT_EVENT_SECS      0x8      // delta is in seconds, not usecs
+// writeCnt rides in the flags above the bits
+#define REPORT_EVENT_CNTSHIFT  8
+#define REPORT_EVENT_MAXCNT    0xffffff
+
+typedef struct ReportEvent {
+    uint32_t delta;
+    uint32_t flags;
+    umax_size_t packetLen;
+} ReportEvent;
+
 
 /*
  * The type field of ReporterData is a bitmask
@@ -163,9 +196,17 @@ typedef struct Transfer_Info {
     double startTime;
     double endTime;
     double IPGsum;
+    double clockOffset;             // --clock-sync, client minus server clock
+    CPUStats cpu;                   // --cpu
+    SeqWindow *seqwin;              // --reorder-window
+    max_size_t cntDuplicate;        // --reorder-window
+    max_size_t cntTooLate;          // --reorder-window, behind the window
     // chars
     char   mFormat;                 // -f
     char   mEnhanced;               // -e
+    char   mCPU;                    // --cpu
+    char   mReadHist;               // --recv-mode
+    char   mTCPLatency;             // --write-latency, server
     u_char mTTL;                    // -T
     char   mUDP;
     char   mTCP;
@@ -189,6 +230,10 @@ typedef struct ReporterData {
     max_size_t lastError;
     max_size_t cntOutofOrder;
     max_size_t lastOutofOrder;
+    max_size_t cntDuplicate;
+    max_size_t lastDuplicate;
+    max_size_t cntTooLate;
+    max_size_t lastTooLate;
     max_size_t cntDatagrams;
     max_size_t lastDatagrams;
     max_size_t PacketID;
@@ -216,6 +261,20 @@ typedef struct ReporterData {
     // enums (which should be special int's)
     ThreadMode mThreadMode;         // -s or -c
     ReportMode mode;
+    int mTarget;                    // --targets entry + 1
+    int mSweepStep;                 // --sweep step + 1
+    double mWarmupSecs;             // --warmup #
+    max_size_t mWarmupBytes;        // --warmup #[kmgKMG]
+    // the counts when --warmup ended, left out of the final report
+    int warmedUp;
+    double warmupTime;
+    umax_size_t warmupTotal;
+    max_size_t warmupDatagrams;
+    max_size_t warmupError;
+    max_size_t warmupOutofOrder;
+    max_size_t warmupDuplicate;
+    max_size_t warmupTooLate;
+    CPUAcct *cpu;                   // --cpu, the agent thread's
     umax_size_t TotalLen;
     umax_size_t lastTotal;
     // doubles
@@ -240,14 +299,30 @@ typedef struct MultiHeader {
     Transfer_Info *data;
     Condition barrier;
     struct timeval startTime;
+    // the first stream's end of --warmup, the SUM's start
+    double warmupTime;
 } MultiHeader;
 
 typedef struct ReportHeader {
     int reporterindex;
     int agentindex;
+    // entries in the ring, and the pool size class it came from
+    int depth;
+    int poolclass;
+    // compact ring (data is NULL), the agent's and the reporter's
+    // running event times and the agent's socket
+    ReportEvent *events;
+    struct timeval eventTime;
+    struct timeval decodeTime;
+    int eventSocket;
+    // signaled when the reporter drains the final packet event,
+    // i.e. reporterindex goes to -1 (transfer reports only)
+    Condition completion;
     ReporterData report;
     ReportStruct *data;
     MultiHeader *multireport;
+    // --stats-shm slot, written by the reporter only
+    struct StatsShm_Stream *shm;
     struct ReportHeader *next;
 } ReportHeader;
 
@@ -263,9 +338,14 @@ void CloseReport( ReportHeader *agent, ReportStruct *packet );
 void EndReport( ReportHeader *agent );
 Transfer_Info* GetReport( ReportHeader *agent );
 void ReportServerUDP( struct thread_Settings *agent, struct server_hdr *server );
+void EncodeServerHdr( Transfer_Info *stats, struct server_hdr *hdr, int flags );
+void DecodeServerHdr( struct server_hdr *server, Transfer_Info *stats );
 void ReportSettings( struct thread_Settings *agent );
 void ReportConnections( struct thread_Settings *agent );
 void reporter_peerversion (struct thread_Settings *inSettings, int upper, int lower);
+int reporter_poll( void );
+// --cpu, the reporter thread's own use, once all the threads are done
+void reporter_print_cpu( void );
 
 extern report_connection connection_reports[];
 
@@ -0,0 +1,153 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * SeqWindow.h
+ * -------------------------------------------------------------------
+ * Sliding window of received UDP sequence numbers (--reorder-window).
+ * One bit per datagram ID in a power of two ring of 64 bit words
+ * tells a late datagram, one that fills a gap behind the highest ID
+ * seen, from a duplicate of one already received.  Advancing the
+ * window clears whole words at a time, so in order traffic costs a
+ * couple of word operations per datagram.  Late datagrams are binned
+ * by their log2 reorder distance, printed when the stream ends.
+ * ------------------------------------------------------------------- */
+
+#ifndef SEQWINDOW_H
+#define SEQWINDOW_H
+
+#include "headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEQWINDOW_DEFAULT   (1 << 16)
+#define SEQWINDOW_MIN       64
+#define SEQWINDOW_MAX       (1 << 24)
+#define SEQWINDOW_LOG2BINS  25
+
+enum {
+    kSeq_New = 0,           // beyond the highest ID so far
+    kSeq_Late,              // fills a gap inside the window
+    kSeq_Duplicate,         // already received
+    kSeq_TooLate            // behind the window, late or duplicate
+};
+
+typedef struct SeqWindow {
+    uint64_t *bits;
+    max_size_t top;                 // highest ID received
+    max_size_t mask;                // window size - 1
+    int started;
+    unsigned int hist[SEQWINDOW_LOG2BINS];  // late datagrams by log2(distance)
+} SeqWindow;
+
+// size is rounded up to a power of two within [MIN, MAX]
+SeqWindow* SeqWindow_Init( int size );
+
+void SeqWindow_Free( SeqWindow *win );
+
+// clear count bits from ID from on, wrapping at the window size
+static inline void SeqWindow_Clear( SeqWindow *win, max_size_t from, max_size_t count ) {
+    max_size_t pos = from & win->mask;
+    int off, n;
+
+    while ( count > 0 ) {
+	off = (int) (pos & 63);
+	n = 64 - off;
+	if ( n > count )
+	    n = (int) count;
+	win->bits[pos >> 6] &= ~((n == 64) ? ~(uint64_t) 0 : ((((uint64_t) 1 << n) - 1) << off));
+	count -= n;
+	pos = (pos + n) & win->mask;
+    }
+}
+
+/*
+ * Classifies datagram id, returns one of the kSeq values.  A late
+ * datagram's distance behind the highest ID is binned in hist.
+ */
+static inline int SeqWindow_Add( SeqWindow *win, max_size_t id ) {
+    max_size_t distance;
+    uint64_t *word, bit;
+    int bin;
+
+    if ( id == win->top + 1 && win->started ) {
+	// in order, the one bit to clear is the one being set
+	win->bits[(id & win->mask) >> 6] |= (uint64_t) 1 << (id & 63);
+	win->top = id;
+	return kSeq_New;
+    }
+    if ( id > win->top || !win->started ) {
+	if ( !win->started || id - win->top > win->mask ) {
+	    memset( win->bits, 0, (win->mask + 1) >> 3 );
+	} else {
+	    SeqWindow_Clear( win, win->top + 1, id - win->top );
+	}
+	win->bits[(id & win->mask) >> 6] |= (uint64_t) 1 << (id & 63);
+	win->top = id;
+	win->started = 1;
+	return kSeq_New;
+    }
+    distance = win->top - id;
+    if ( distance > win->mask )
+	return kSeq_TooLate;
+    word = &win->bits[(id & win->mask) >> 6];
+    bit = (uint64_t) 1 << (id & 63);
+    if ( *word & bit )
+	return kSeq_Duplicate;
+    *word |= bit;
+    for ( bin = 0, distance >>= 1; distance && bin < SEQWINDOW_LOG2BINS - 1; distance >>= 1 ) {
+	bin++;
+    }
+    win->hist[bin]++;
+    return kSeq_Late;
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // SEQWINDOW_H
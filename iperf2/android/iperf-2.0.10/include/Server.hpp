@@ -58,8 +58,16 @@
 #include "Settings.hpp"
 #include "util.h"
 #include "Timestamp.hpp"
+#include "TimeBuckets.h"
+#include "Netmap.h"
+#include "Payload.h"
 
 /* ------------------------------------------------------------------- */
+// --busy-poll with no spin budget, how often a spinning receive hands
+// back an empty read so the end time and interval reports are still
+// checked
+#define BUSYPOLL_YIELD_USECS   10000
+
 class Server {
 public:
     // stores server socket, port and TCP/UDP mode
@@ -77,9 +85,39 @@ public:
     static void Sig_Int( int inSigno );
 
 private:
+    // --busy-poll, set the socket up and the receive that spins
+    void BusyPollInit( void );
+    long BusyRecv( void *buf, int len, struct msghdr *message, int flags );
+    // --write-latency, post the client's write stamps found in a read
+    void ReadStamps( const char *buf, long len, ReportStruct *reportstruct );
+    // --verify, build the client's --payload pool, check reads against
+    // it and print the count of corrupted bytes
+    void PayloadInit( void );
+    void VerifyTCP( const char *buf, long len );
+    void VerifyUDP( max_size_t id, const char *buf, long len );
+    void PayloadEnd( const char *unit );
+#ifdef HAVE_LINUX_IO_URING_H
+    // io_uring versions of the RunTCP() and RunUDP() read loops
+    bool RingReadTCP( ReportStruct *reportstruct, max_size_t *totLen );
+    bool RingReadUDP( ReportStruct *reportstruct, max_size_t *totLen, int sorcvtimer );
+#endif
+#ifdef HAVE_NET_NETMAP_USER_H
+    // netmap version of the RunUDP() read loop
+    void NetmapReadUDP( ReportStruct *reportstruct, max_size_t *totLen, int sorcvtimer );
+#endif
     thread_Settings *mSettings;
     char* mBuf;
+    TimeBuckets *mBuckets;          // --time-buckets
     Timestamp mEndTime;
+    max_size_t mStreamOffset;       // --write-latency, bytes read so far
+    max_size_t mStampNext;          // --write-latency, stream offset of the next stamp
+    int mStampHave;                 // --write-latency, bytes of a stamp split across reads
+    tcp_write_stamp mStamp;
+    char* mPayload;                 // --verify, the client's --payload pool
+    max_size_t mPayloadNext;        // --verify, TCP stream offset of the next read
+    max_size_t mPayloadChecked;     // --verify, bytes compared
+    max_size_t mPayloadCorrupt;     // --verify, bytes that differed
+    max_size_t mPayloadBad;         // --verify, reads or datagrams with any
 
 }; // end class Server
 
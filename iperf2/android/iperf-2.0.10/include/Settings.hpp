@@ -72,6 +72,9 @@ extern "C" {
 /* Smallest report interval supported. Units is seconds */
 #define SMALLEST_INTERVAL 0.005
 
+// --busy-poll default SO_BUSY_POLL time, units microseconds
+#define BUSYPOLL_DEFAULT_USECS 50
+
 // server/client mode
 typedef enum ThreadMode {
     kMode_Unknown = 0,
@@ -103,6 +106,14 @@ typedef enum RateUnits {
     kRate_PPS
 } RateUnits;
 
+// TCP server read modes (--recv-mode)
+typedef enum RecvMode {
+    kRecv_Default = 0,
+    kRecv_WaitAll,
+    kRecv_LowAt,
+    kRecv_Adaptive
+} RecvMode;
+
 #include "Reporter.h"
 
 /*
@@ -127,6 +138,7 @@ typedef struct thread_Settings {
     MultiHeader*   multihdr;
     struct thread_Settings *runNow;
     struct thread_Settings *runNext;
+    int *runGroup;                  // streams sharing runNext still running
     // int's
     int mThreads;                   // -P
     int mTOS;                       // -S
@@ -188,7 +200,33 @@ typedef struct thread_Settings {
     Socklen_t size_local;
     nthread_t mTID;
     char* mCongestion;
+    char* mNetmapPort;              // --netmap
+    struct Netmap* mNetmap;         // --netmap, the server's port lent by the listener
+    char* mStatsShm;                // --stats-shm
     char peerversion[80];
+    int mRingDepth;                 // --io-uring
+    RecvMode mRecvMode;             // --recv-mode
+    int mRcvLowat;                  // --recv-mode lowat:#
+    int mSampleUsecs;               // --tcp-sample
+    int mBucketUsecs;               // --time-buckets
+    int mReportDepth;               // --report-depth
+    int mFanout;                    // --fanout
+    int mTarget;                    // --targets entry + 1, 0 for a plain -c
+    int mAffinity;                  // --affinity, CPU for the traffic threads
+    int mBusyPollUsecs;             // --busy-poll, SO_BUSY_POLL
+    int mBusySpinUsecs;             // --busy-poll #:#, spin before blocking, 0 never blocks
+    int mNotSentLowat;              // --write-latency, TCP_NOTSENT_LOWAT
+    max_size_t mStampOffset;        // --write-latency, stream bytes ahead of the first stamp
+    int mReorderWindow;             // --reorder-window
+    int mTrials;                    // --trials
+    double mSweepSettle;            // --sweep-settle (secs)
+    int mSweepStep;                 // --sweep step + 1, 0 for a plain run
+    double mWarmupSecs;             // --warmup #
+    max_size_t mWarmupBytes;        // --warmup #[kmgKMG]
+    int mPayload;                   // --payload, a kPayload mode
+    double mPayloadRatio;           // --payload compress=#
+    max_size_t mPayloadOffset;      // --payload, server, stream bytes ahead of the payload
+    double mClockOffset;            // --clock-sync, peer minus local clock (secs)
 #if defined( HAVE_WIN32_THREAD )
     HANDLE mHandle;
 #endif
@@ -240,6 +278,25 @@ typedef struct thread_Settings {
 #define FLAG_PEERVER        0x00000001
 #define FLAG_SEQNO64        0x00000002
 #define FLAG_REVERSE        0x00000004
+#define FLAG_IOURING        0x00000008
+#define FLAG_RECVMODE       0x00000010
+#define FLAG_TCPSAMPLE      0x00000020
+#define FLAG_TIMEBUCKETS    0x00000040
+#define FLAG_CLOCKSYNC      0x00000080
+#define FLAG_NETMAP         0x00000100
+#define FLAG_STATSSHM       0x00000200
+#define FLAG_AGGREGATE      0x00000400
+#define FLAG_FANOUT         0x00000800
+#define FLAG_CPUACCT        0x00001000
+#define FLAG_AFFINITY       0x00002000
+#define FLAG_BUSYPOLL       0x00004000
+#define FLAG_WRITELATENCY   0x00008000
+#define FLAG_REORDERWIN     0x00010000
+#define FLAG_MCASTGROUPS    0x00020000
+#define FLAG_SWEEP          0x00040000
+#define FLAG_WARMUP         0x00080000
+#define FLAG_PAYLOAD        0x00100000
+#define FLAG_VERIFY         0x00200000
 
 #define isBuflenSet(settings)      ((settings->flags & FLAG_BUFLENSET) != 0)
 #define isCompat(settings)         ((settings->flags & FLAG_COMPAT) != 0)
@@ -273,6 +330,25 @@ typedef struct thread_Settings {
 #define isPeerVerDetect(settings)       ((settings->flags_extend & FLAG_PEERVER) != 0)
 #define isSeqNo64b(settings)       ((settings->flags_extend & FLAG_SEQNO64) != 0)
 #define isReverse(settings)       ((settings->flags_extend & FLAG_REVERSE) != 0)
+#define isIOUring(settings)       ((settings->flags_extend & FLAG_IOURING) != 0)
+#define isRecvMode(settings)      ((settings->flags_extend & FLAG_RECVMODE) != 0)
+#define isTCPSample(settings)     ((settings->flags_extend & FLAG_TCPSAMPLE) != 0)
+#define isTimeBuckets(settings)   ((settings->flags_extend & FLAG_TIMEBUCKETS) != 0)
+#define isClockSync(settings)     ((settings->flags_extend & FLAG_CLOCKSYNC) != 0)
+#define isNetmap(settings)        ((settings->flags_extend & FLAG_NETMAP) != 0)
+#define isStatsShm(settings)      ((settings->flags_extend & FLAG_STATSSHM) != 0)
+#define isAggregate(settings)     ((settings->flags_extend & FLAG_AGGREGATE) != 0)
+#define isFanout(settings)        ((settings->flags_extend & FLAG_FANOUT) != 0)
+#define isCPUAcct(settings)       ((settings->flags_extend & FLAG_CPUACCT) != 0)
+#define isAffinity(settings)      ((settings->flags_extend & FLAG_AFFINITY) != 0)
+#define isBusyPoll(settings)      ((settings->flags_extend & FLAG_BUSYPOLL) != 0)
+#define isWriteLatency(settings)  ((settings->flags_extend & FLAG_WRITELATENCY) != 0)
+#define isReorderWin(settings)    ((settings->flags_extend & FLAG_REORDERWIN) != 0)
+#define isMcastGroups(settings)   ((settings->flags_extend & FLAG_MCASTGROUPS) != 0)
+#define isSweep(settings)         ((settings->flags_extend & FLAG_SWEEP) != 0)
+#define isWarmup(settings)        ((settings->flags_extend & FLAG_WARMUP) != 0)
+#define isPayload(settings)       ((settings->flags_extend & FLAG_PAYLOAD) != 0)
+#define isVerify(settings)        ((settings->flags_extend & FLAG_VERIFY) != 0)
 
 #define setBuflenSet(settings)     settings->flags |= FLAG_BUFLENSET
 #define setCompat(settings)        settings->flags |= FLAG_COMPAT
@@ -304,6 +380,25 @@ typedef struct thread_Settings {
 #define setPeerVerDetect(settings)      settings->flags_extend |= FLAG_PEERVER
 #define setSeqNo64b(settings)      settings->flags_extend |= FLAG_SEQNO64
 #define setReverse(settings)      settings->flags_extend |= FLAG_REVERSE
+#define setIOUring(settings)      settings->flags_extend |= FLAG_IOURING
+#define setRecvMode(settings)     settings->flags_extend |= FLAG_RECVMODE
+#define setTCPSample(settings)    settings->flags_extend |= FLAG_TCPSAMPLE
+#define setTimeBuckets(settings)  settings->flags_extend |= FLAG_TIMEBUCKETS
+#define setClockSync(settings)    settings->flags_extend |= FLAG_CLOCKSYNC
+#define setNetmap(settings)       settings->flags_extend |= FLAG_NETMAP
+#define setStatsShm(settings)     settings->flags_extend |= FLAG_STATSSHM
+#define setAggregate(settings)    settings->flags_extend |= FLAG_AGGREGATE
+#define setFanout(settings)       settings->flags_extend |= FLAG_FANOUT
+#define setCPUAcct(settings)      settings->flags_extend |= FLAG_CPUACCT
+#define setAffinity(settings)     settings->flags_extend |= FLAG_AFFINITY
+#define setBusyPoll(settings)     settings->flags_extend |= FLAG_BUSYPOLL
+#define setWriteLatency(settings) settings->flags_extend |= FLAG_WRITELATENCY
+#define setReorderWin(settings)   settings->flags_extend |= FLAG_REORDERWIN
+#define setMcastGroups(settings)  settings->flags_extend |= FLAG_MCASTGROUPS
+#define setSweep(settings)        settings->flags_extend |= FLAG_SWEEP
+#define setWarmup(settings)       settings->flags_extend |= FLAG_WARMUP
+#define setPayload(settings)      settings->flags_extend |= FLAG_PAYLOAD
+#define setVerify(settings)       settings->flags_extend |= FLAG_VERIFY
 
 #define unsetBuflenSet(settings)   settings->flags &= ~FLAG_BUFLENSET
 #define unsetCompat(settings)      settings->flags &= ~FLAG_COMPAT
@@ -335,6 +430,25 @@ typedef struct thread_Settings {
 #define unsetPeerVerDetect(settings)    settings->flags_extend &= ~FLAG_PEERVER
 #define unsetSeqNo64b(settings)    settings->flags_extend &= ~FLAG_SEQNO64
 #define unsetReverse(settings)    settings->flags_extend &= ~FLAG_REVERSE
+#define unsetIOUring(settings)    settings->flags_extend &= ~FLAG_IOURING
+#define unsetRecvMode(settings)   settings->flags_extend &= ~FLAG_RECVMODE
+#define unsetTCPSample(settings)  settings->flags_extend &= ~FLAG_TCPSAMPLE
+#define unsetTimeBuckets(settings)settings->flags_extend &= ~FLAG_TIMEBUCKETS
+#define unsetClockSync(settings)  settings->flags_extend &= ~FLAG_CLOCKSYNC
+#define unsetNetmap(settings)     settings->flags_extend &= ~FLAG_NETMAP
+#define unsetStatsShm(settings)   settings->flags_extend &= ~FLAG_STATSSHM
+#define unsetAggregate(settings)  settings->flags_extend &= ~FLAG_AGGREGATE
+#define unsetFanout(settings)     settings->flags_extend &= ~FLAG_FANOUT
+#define unsetCPUAcct(settings)    settings->flags_extend &= ~FLAG_CPUACCT
+#define unsetAffinity(settings)   settings->flags_extend &= ~FLAG_AFFINITY
+#define unsetBusyPoll(settings)   settings->flags_extend &= ~FLAG_BUSYPOLL
+#define unsetWriteLatency(settings) settings->flags_extend &= ~FLAG_WRITELATENCY
+#define unsetReorderWin(settings) settings->flags_extend &= ~FLAG_REORDERWIN
+#define unsetMcastGroups(settings) settings->flags_extend &= ~FLAG_MCASTGROUPS
+#define unsetSweep(settings)      settings->flags_extend &= ~FLAG_SWEEP
+#define unsetWarmup(settings)     settings->flags_extend &= ~FLAG_WARMUP
+#define unsetPayload(settings)    settings->flags_extend &= ~FLAG_PAYLOAD
+#define unsetVerify(settings)     settings->flags_extend &= ~FLAG_VERIFY
 
 /*
  * Messasge header flags
@@ -349,9 +463,14 @@ typedef struct thread_Settings {
 #define SEQNO64B              0x00000002
 #define REALTIME              0x00000004
 #define REVERSE               0x00000008
+#define CLOCKSYNC             0x00000010
+#define WRITELATENCY          0x00000020
+#define PAYLOAD               0x00000040
 
 #define HDRXACKMAX 2500000 // default 2.5 seconds, units microseconds
 #define HDRXACKMIN   10000 // default 10 ms, units microseconds
+#define CLOCKSYNC_PINGS      8 // timestamp exchanges per --clock-sync
+#define CLOCKSYNC_TIMEOUT 250000 // per exchange, units microseconds
 
 /*
  * Structures used for test messages which
@@ -361,7 +480,8 @@ typedef enum MsgType {
     CLIENTHDR = 0x1,
     CLIENTHDRACK,
     SERVERHDR,
-    SERVERHDRACK
+    SERVERHDRACK,
+    CLOCKSYNCMSG
 } MsgType;
 
 /*
@@ -445,7 +565,7 @@ typedef struct client_hdrext {
     int32_t flags;
     int32_t version_u;
     int32_t version_l;
-    int32_t reserved;
+    int32_t mPayload;
     int32_t mRate;
     int32_t mUDPRateUnits;
     int32_t mRealtime;
@@ -453,7 +573,7 @@ typedef struct client_hdrext {
     signed int flags       : 32;
     signed int version_u   : 32;
     signed int version_l   : 32;
-    signed int reserved    : 32;
+    signed int mPayload    : 32;
     signed int mRate      : 32;
     signed int mUDPRateUnits : 32;
     signed int mRealtime  : 32;
@@ -481,6 +601,53 @@ typedef struct client_hdr {
     client_hdrext extend;
 } client_hdr;
 
+/*
+ * NTP style timestamp exchange for --clock-sync.  The server
+ * sends t1 and the client echoes it back with its receive (t2)
+ * and send (t3) times, all in the sender's wall clock
+ */
+typedef struct clock_sync_msg {
+    hdr_typelen typelen;
+#ifdef HAVE_INT32_T
+    int32_t seqno;
+    u_int32_t t1_sec;
+    u_int32_t t1_usec;
+    u_int32_t t2_sec;
+    u_int32_t t2_usec;
+    u_int32_t t3_sec;
+    u_int32_t t3_usec;
+#else
+    signed int seqno       : 32;
+    unsigned int t1_sec    : 32;
+    unsigned int t1_usec   : 32;
+    unsigned int t2_sec    : 32;
+    unsigned int t2_usec   : 32;
+    unsigned int t3_sec    : 32;
+    unsigned int t3_usec   : 32;
+#endif
+} clock_sync_msg;
+
+/*
+ * --write-latency, leads each of the client's TCP writes.
+ * len is the write's length so the server can find the next
+ * stamp in the byte stream.
+ */
+typedef struct tcp_write_stamp {
+#ifdef HAVE_INT32_T
+    u_int32_t magic;
+    u_int32_t len;
+    u_int32_t tv_sec;
+    u_int32_t tv_usec;
+#else
+    unsigned int magic     : 32;
+    unsigned int len       : 32;
+    unsigned int tv_sec    : 32;
+    unsigned int tv_usec   : 32;
+#endif
+} tcp_write_stamp;
+
+#define WRITESTAMP_MAGIC 0x69505753
+
 /*
  * The server_hdr structure facilitates the server
  * report of jitter and loss on the client side.
@@ -585,6 +752,9 @@ void Settings_Copy( thread_Settings* from, thread_Settings** into );
 // free associated memory
 void Settings_Destroy( thread_Settings *mSettings );
 
+// protects the settings and report free lists
+extern Mutex poolCond;
+
 // parse settings from user's environment variables
 void Settings_ParseEnvironment( thread_Settings *mSettings );
 
@@ -0,0 +1,137 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * StatsShm.h
+ * -------------------------------------------------------------------
+ * --stats-shm publishes every stream's running totals to a shared
+ * memory file (e.g. /dev/shm/iperf) so monitors can sample them at any
+ * rate without parsing the reports.  The reporter thread writes a
+ * stream's slot after each pass over its packet events, the traffic
+ * threads never touch it.  Each slot is guarded by a seqlock: seq is
+ * odd while the reporter is writing, readers retry until they see the
+ * same even seq before and after their copy, which is what
+ * StatsShm_Snapshot() does.  A monitor only needs this header.
+ * ------------------------------------------------------------------- */
+
+#ifndef STATSSHM_H
+#define STATSSHM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATSSHM_MAGIC     0x69706632   // "ipf2"
+#define STATSSHM_VERSION   3
+#define STATSSHM_STREAMS   1024
+#define STATSSHM_LOG2BINS  24           // READ_LOG2BINS
+
+typedef struct StatsShm_Stream {
+    uint32_t seq;                   // seqlock, odd while being written
+    int32_t inuse;                  // 0 when the slot is free
+    int32_t transferID;             // the socket, may be 0 with -D
+    int32_t groupID;
+    int32_t threadMode;             // ThreadMode, client or server
+    int32_t udp;
+    double startTime;               // seconds since the epoch
+    double lastTime;                // the latest packet event
+    uint64_t bytes;
+    uint64_t packets;               // datagrams, or TCP reads/writes
+    uint64_t errors;                // lost datagrams, or TCP write errors
+    uint64_t outOfOrder;
+    double jitter;                  // seconds, UDP server
+    double transitMin;              // seconds, UDP server
+    double transitMax;
+    double transitMean;
+    uint64_t transitCnt;
+    // TCP server reads of [2^i, 2^(i+1)) bytes, --recv-mode
+    uint32_t readLog2Bins[STATSSHM_LOG2BINS];
+    // --cpu, the stream's thread so far
+    double cpuSecs;
+    uint64_t cycles;
+} StatsShm_Stream;
+
+typedef struct StatsShm {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t streams;               // STATSSHM_STREAMS
+    uint32_t streamSize;            // sizeof(StatsShm_Stream)
+    int32_t pid;
+    int32_t running;                // cleared when iperf exits
+    StatsShm_Stream stream[STATSSHM_STREAMS];
+} StatsShm;
+
+/*
+ * Copy a slot consistently, returns 0 if the slot is free
+ */
+static inline int StatsShm_Snapshot( const StatsShm_Stream *slot, StatsShm_Stream *copy ) {
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE );
+        memcpy( copy, (const void *) slot, sizeof(StatsShm_Stream) );
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    } while ( (seq & 1) != 0 || seq != __atomic_load_n( &slot->seq, __ATOMIC_RELAXED ) );
+    return copy->inuse != 0;
+}
+
+#ifndef STATSSHM_MONITOR
+struct ReportHeader;
+
+int StatsShm_Open( const char *path );
+void StatsShm_Close( void );
+StatsShm_Stream *StatsShm_Attach( struct ReportHeader *reporthdr );
+void StatsShm_Publish( StatsShm_Stream *slot, struct ReportHeader *reporthdr );
+void StatsShm_Detach( StatsShm_Stream *slot );
+#endif
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // STATSSHM_H
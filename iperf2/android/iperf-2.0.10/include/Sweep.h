@@ -0,0 +1,115 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * Sweep.h
+ * -------------------------------------------------------------------
+ * One client run over a matrix of settings (--sweep).  Every
+ * combination of the -Z, -w, -l and -P values listed is run --trials
+ * times on the same connections, a --sweep-settle pause apart, and
+ * the runs' bandwidths and RTTs are summed up in one table with
+ * their medians, percentiles and confidence intervals at the end.
+ * --trials without --sweep is the one combination the command line
+ * gives.
+ * ------------------------------------------------------------------- */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "headers.h"
+#include "Settings.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SWEEP_MAX_VALUES   64
+#define SWEEP_TRIALS_DEFAULT 3
+// secs
+#define SWEEP_SETTLE_DEFAULT 1.0
+
+struct ReporterData;
+
+/*
+ * Parse spec, whitespace or ; separated dimensions each a name, =
+ * and a comma separated list, e.g. "Z=cubic,bbr w=256K,4M P=1,4".
+ * Returns the number of dimensions, 0 on error.
+ */
+int Sweep_Load( const char *spec );
+
+/*
+ * Called once the command line is parsed, fills in the dimensions
+ * left out from the settings and sizes -P and -l for the largest
+ * combination.  Unsets --sweep if the test can't be swept.
+ */
+void Sweep_Init( thread_Settings *client );
+
+// the calling client thread's stream number, counting from 0
+int Sweep_Stream( void );
+
+/*
+ * Wait for every stream to finish the run before, then for the
+ * settle time.  Returns the step to run next, -1 when all are done.
+ */
+int Sweep_Wait( void );
+
+// a step's settings, a dimension left out comes back as 0 or NULL
+const char* Sweep_Congestion( int step );
+int Sweep_Window( int step );
+int Sweep_Length( int step );
+int Sweep_Streams( int step );
+
+// called by the reporter with a stream's final totals
+void Sweep_Account( struct ReporterData *stats );
+
+// called once all the threads are done
+void Sweep_Print( void );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // SWEEP_H
@@ -0,0 +1,109 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * TCPSampler.h
+ * -------------------------------------------------------------------
+ * Periodic TCP_INFO sampling (--tcp-sample).  One background thread
+ * polls every registered socket at a fixed period and records the
+ * congestion state into a per-stream ring which is printed as a
+ * time series when the stream stops.
+ * ------------------------------------------------------------------- */
+
+#ifndef TCPSAMPLER_H
+#define TCPSAMPLER_H
+
+#include "headers.h"
+
+#if defined(HAVE_POSIX_THREAD) && defined(HAVE_CLOCK_GETTIME) && \
+    defined(HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS) && !IPERF_USE_LWIP
+#define HAVE_TCP_SAMPLER 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TCPSAMPLE_DEFAULT_USECS 1000
+#define TCPSAMPLE_MIN_USECS     100
+#define TCPSAMPLE_DEFAULT_DEPTH 65536
+#define TCPSAMPLE_MAX_DEPTH     (1 << 22)
+
+typedef struct TCPSample {
+    uint32_t usecs;          // since the stream was registered
+    uint32_t cwnd;           // segments
+    uint32_t srtt;           // usecs
+    uint32_t rttvar;         // usecs
+    uint32_t inflight;       // bytes
+    uint32_t retrans;        // total retransmits
+    uint64_t pacing_rate;    // bytes/sec, 0 if the kernel doesn't say
+    uint64_t delivery_rate;  // bytes/sec, 0 if the kernel doesn't say
+} TCPSample;
+
+typedef struct TCPSampler {
+    int sock;
+    int period;              // usecs
+    int depth;
+    int failed;
+    unsigned long count;     // samples taken, ring keeps the last depth
+    struct timespec start;
+    TCPSample *ring;
+    struct TCPSampler *next;
+} TCPSampler;
+
+/*
+ * Start sampling sock every usecs, keeping the last depth samples
+ * (0 for the default).  Returns NULL if the ring can't be allocated.
+ */
+TCPSampler* TCPSampler_Start( int sock, int usecs, int depth );
+
+// stop sampling, print the time series and free the sampler
+void TCPSampler_Stop( TCPSampler *sampler );
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // HAVE_TCP_SAMPLER
+#endif // TCPSAMPLER_H
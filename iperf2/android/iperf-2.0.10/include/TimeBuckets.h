@@ -0,0 +1,118 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * TimeBuckets.h
+ * -------------------------------------------------------------------
+ * Fixed period throughput buckets (--time-buckets).  Each traffic
+ * thread adds its reads or writes straight into a preallocated array
+ * indexed by the time since the report start, so microbursts show up
+ * without the reporter thread or interval reports being involved.
+ * The populated buckets are printed when the stream ends.
+ * ------------------------------------------------------------------- */
+
+#ifndef TIMEBUCKETS_H
+#define TIMEBUCKETS_H
+
+#include "headers.h"
+#include "Settings.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMEBUCKETS_DEFAULT_USECS 100
+#define TIMEBUCKETS_MIN_USECS     1
+// used when the run length isn't known up front, 100 secs at 100 us
+#define TIMEBUCKETS_DEFAULT_COUNT 1000000
+#define TIMEBUCKETS_MAX_COUNT     (1 << 26)
+
+typedef struct TimeBucket {
+    uint64_t bytes;
+    uint32_t packets;
+} TimeBucket;
+
+typedef struct TimeBuckets {
+    int id;
+    int usecs;
+    long count;
+    long last;               // highest populated index
+    struct timeval start;
+    uint64_t lateBytes;      // beyond the end of the array
+    uint32_t latePackets;
+    TimeBucket *bucket;
+} TimeBuckets;
+
+/*
+ * Returns NULL unless --time-buckets was given.  Call after
+ * InitReport() so the buckets line up with the report start time.
+ */
+TimeBuckets* TimeBuckets_Init( thread_Settings *agent );
+
+// print the populated buckets and free everything
+void TimeBuckets_End( TimeBuckets *tb );
+
+// len bytes read or written at now, the caller's packet time
+static inline void TimeBuckets_Add( TimeBuckets *tb, long len, const struct timeval *now ) {
+    long ix;
+
+    ix = ((now->tv_sec - tb->start.tv_sec) * 1000000L +
+	  (now->tv_usec - tb->start.tv_usec)) / tb->usecs;
+    if ( ix >= 0 && ix < tb->count ) {
+	tb->bucket[ix].bytes += len;
+	tb->bucket[ix].packets++;
+	if ( ix > tb->last )
+	    tb->last = ix;
+    } else {
+	tb->lateBytes += len;
+	tb->latePackets++;
+    }
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // TIMEBUCKETS_H
@@ -60,6 +60,16 @@
 #ifdef HAVE_CONFIG_H
     #include "config.h"
 
+/* The lwIP builds (src/Makefile.am iperf-lwip*) compile with
+ * -DIPERF_USE_LWIP=1 and have no kernel socket under a descriptor,
+ * so no io_uring, netmap bypass or SO_BUSY_POLL.  Not in config.h,
+ * config.status would rewrite the #undefs */
+    #if IPERF_USE_LWIP
+        #undef HAVE_LINUX_IO_URING_H
+        #undef HAVE_NET_NETMAP_USER_H
+        #undef HAVE_DECL_SO_BUSY_POLL
+    #endif
+
 /* OSF1 (at least the system I use) needs extern C
  * around the <netdb.h> and <arpa/inet.h> files. */
     #if defined( SPECIAL_OSF1_EXTERN ) && defined( __cplusplus )
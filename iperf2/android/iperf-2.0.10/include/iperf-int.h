@@ -2,7 +2,7 @@
 #define _IPERF_INCLUDE_IPERF_INT_H 1
 #ifndef _GENERATED_STDINT_H
 #define _GENERATED_STDINT_H "iperf 2.0.10"
-/* generated using gnu compiler gcc (Ubuntu 5.4.0-6ubuntu1~16.04.4) 5.4.0 20160609 */
+/* generated using gnu compiler gcc (Debian 12.2.0-14+deb12u1) 12.2.0 */
 #define _STDINT_HAVE_STDINT_H 1
 #include <stdint.h>
 #endif
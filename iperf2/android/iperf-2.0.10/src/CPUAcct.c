@@ -0,0 +1,203 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * CPUAcct.c
+ * -------------------------------------------------------------------
+ * Per thread CPU accounting (--cpu), see CPUAcct.h
+ * ------------------------------------------------------------------- */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "headers.h"
+#include "CPUAcct.h"
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} cpuacct_events[CPUACCT_COUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+/*
+ * A counter on the calling thread, user and kernel time both as the
+ * kernel's share of the cost is the point.  The fd can be read from
+ * any thread.
+ */
+static int cpuacct_counter( int ix ) {
+    struct perf_event_attr attr;
+
+    memset( &attr, 0, sizeof(attr) );
+    attr.size = sizeof(attr);
+    attr.type = cpuacct_events[ix].type;
+    attr.config = cpuacct_events[ix].config;
+    attr.exclude_hv = 1;
+    return (int) syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+#endif
+
+static uint64_t cpuacct_read( CPUAcct *acct, int ix ) {
+    uint64_t value = 0;
+    if ( acct->fd[ix] >= 0 && read( acct->fd[ix], &value, sizeof(value) ) != sizeof(value) ) {
+	value = 0;
+    }
+    return value;
+}
+
+static double cpuacct_secs( CPUAcct *acct ) {
+    struct timespec t;
+    if ( clock_gettime( acct->clock, &t ) != 0 ) {
+	return acct->lastSecs;
+    }
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static double tvsecs( struct timeval *t ) {
+    return t->tv_sec + t->tv_usec / 1e6;
+}
+
+CPUAcct* CPUAcct_Open( void ) {
+    CPUAcct *acct = (CPUAcct *) calloc( 1, sizeof(CPUAcct) );
+    int ix;
+
+    if ( acct == NULL ) {
+	return NULL;
+    }
+#if defined(HAVE_POSIX_THREAD)
+    if ( pthread_getcpuclockid( pthread_self(), &acct->clock ) != 0 )
+#endif
+    {
+	// only good when sampled from this thread
+	acct->clock = CLOCK_THREAD_CPUTIME_ID;
+    }
+    for ( ix = 0; ix < CPUACCT_COUNTERS; ix++ ) {
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	acct->fd[ix] = cpuacct_counter( ix );
+	if ( acct->fd[ix] >= 0 )
+	    acct->counters++;
+#else
+	acct->fd[ix] = -1;
+#endif
+    }
+#ifdef RUSAGE_THREAD
+    getrusage( RUSAGE_THREAD, &acct->start );
+#endif
+    acct->firstSecs = acct->lastSecs = cpuacct_secs( acct );
+    for ( ix = 0; ix < CPUACCT_COUNTERS; ix++ ) {
+	acct->first[ix] = acct->last[ix] = cpuacct_read( acct, ix );
+    }
+    return acct;
+}
+
+void CPUAcct_End( CPUAcct *acct ) {
+#ifdef RUSAGE_THREAD
+    getrusage( RUSAGE_THREAD, &acct->end );
+    acct->ended = 1;
+#endif
+}
+
+void CPUAcct_Sample( CPUAcct *acct, CPUStats *stats, int total ) {
+    double secs = cpuacct_secs( acct );
+    int ix;
+
+    memset( stats, 0, sizeof(CPUStats) );
+    stats->sampled = 1;
+    stats->counters = (acct->counters == CPUACCT_COUNTERS);
+    if ( total ) {
+	stats->cpuSecs = secs - acct->firstSecs;
+    } else {
+	stats->cpuSecs = secs - acct->lastSecs;
+	acct->lastSecs = secs;
+    }
+    for ( ix = 0; ix < CPUACCT_COUNTERS; ix++ ) {
+	uint64_t value = cpuacct_read( acct, ix );
+	if ( total ) {
+	    stats->count[ix] = value - acct->first[ix];
+	} else {
+	    stats->count[ix] = value - acct->last[ix];
+	    acct->last[ix] = value;
+	}
+    }
+    if ( total && acct->ended ) {
+	stats->rusage = 1;
+	stats->userSecs = tvsecs( &acct->end.ru_utime ) - tvsecs( &acct->start.ru_utime );
+	stats->sysSecs = tvsecs( &acct->end.ru_stime ) - tvsecs( &acct->start.ru_stime );
+	stats->nvcsw = acct->end.ru_nvcsw - acct->start.ru_nvcsw;
+	stats->nivcsw = acct->end.ru_nivcsw - acct->start.ru_nivcsw;
+    }
+}
+
+void CPUAcct_Close( CPUAcct *acct ) {
+    int ix;
+
+    if ( acct == NULL ) {
+	return;
+    }
+    for ( ix = 0; ix < CPUACCT_COUNTERS; ix++ ) {
+	if ( acct->fd[ix] >= 0 )
+	    close( acct->fd[ix] );
+    }
+    free( acct );
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
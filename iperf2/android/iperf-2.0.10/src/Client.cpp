@@ -61,12 +61,23 @@
 #include "delay.h"
 #include "util.h"
 #include "Locale.h"
+#include "IOUring.h"
+#include "TCPSampler.h"
+#include "Netmap.h"
+#include "Sweep.h"
 #ifdef HAVE_SCHED_SETSCHEDULER
 #include <sched.h>
 #endif
 #ifdef HAVE_MLOCKALL
 #include <sys/mman.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_LINUX_SOCKIOS_H
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#endif
 #include "lwip_adap.h"
 /* -------------------------------------------------------------------
  * Store server hostname, optionally local hostname, and socket info.
@@ -75,6 +86,13 @@
 Client::Client( thread_Settings *inSettings ) {
     mSettings = inSettings;
     mBuf = NULL;
+    mPayload = NULL;
+    mSlots = NULL;
+    mPayloadNext = 0;
+    mBuckets = NULL;
+#ifdef HAVE_NET_NETMAP_USER_H
+    mNetmap = NULL;
+#endif
 
     if (isCompat(inSettings) && isPeerVerDetect(inSettings)) {
 	fprintf(stderr, "%s", warn_compat_and_peer_exchange);
@@ -98,6 +116,16 @@ Client::Client( thread_Settings *inSettings ) {
     mBuf = new char[((mSettings->mBufLen > SIZEOF_MAXHDRMSG) ? mSettings->mBufLen : SIZEOF_MAXHDRMSG)];
     FAIL_errno( mBuf == NULL, "No memory for buffer\n", mSettings );
     pattern( mBuf, ((mSettings->mBufLen > SIZEOF_MAXHDRMSG) ? mSettings->mBufLen : SIZEOF_MAXHDRMSG));
+    if ( isPayload( mSettings ) ) {
+	mPayload = Payload_Pool( mSettings->mPayload, mSettings->mPayloadRatio, mSettings->mBufLen );
+	if ( mPayload == NULL ) {
+	    unsetPayload( mSettings );
+	} else if ( isUDP( mSettings ) && mSettings->mBufLen > (int) SIZEOF_UDPCLIENTMSG ) {
+	    // the header exchange and the FIN datagrams go out of mBuf, as slot 0
+	    memcpy( mBuf + SIZEOF_UDPCLIENTMSG, mPayload + Payload_Slot( 0 ),
+		    mSettings->mBufLen - SIZEOF_UDPCLIENTMSG );
+	}
+    }
     if ( isFileInput( mSettings ) ) {
         if ( !isSTDIN( mSettings ) )
             Extractor_Initialize( mSettings->mFileName, mSettings->mBufLen, mSettings );
@@ -134,12 +162,70 @@ Client::~Client() {
         mSettings->mSock = INVALID_SOCKET;
     }
     DELETE_ARRAY( mBuf );
+    DELETE_ARRAY( mSlots );
+    Payload_Free( mPayload );
 } // end ~Client
 
+void Client::PayloadSlots( void ) {
+    int len = mSettings->mBufLen;
+    int k;
+
+    mSlots = new char[PAYLOAD_SLOTS * len];
+    for ( k = 0; k < PAYLOAD_SLOTS; k++ ) {
+	memcpy( mSlots + k * len, mBuf, SIZEOF_UDPCLIENTMSG );
+	memcpy( mSlots + k * len + SIZEOF_UDPCLIENTMSG, mPayload + Payload_Slot( k ),
+		len - SIZEOF_UDPCLIENTMSG );
+    }
+}
+
 // const double kSecs_to_usecs = 1e6;
 const double kSecs_to_nsecs = 1e9;
 const int    kBytes_to_Bits = 8;
 
+/*
+ * Cheap check of the clock against a deadline, an --aggregate
+ * interval boundary or a --targets stream's end time.  The coarse
+ * clock never runs ahead of gettimeofday() so once it's past the
+ * deadline the precise time is too.
+ */
+static inline bool clock_past( const struct timeval *deadline ) {
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_REALTIME_COARSE)
+    struct timespec now;
+    clock_gettime( CLOCK_REALTIME_COARSE, &now );
+    return (now.tv_sec > deadline->tv_sec ||
+	    (now.tv_sec == deadline->tv_sec && now.tv_nsec / 1000 >= deadline->tv_usec));
+#else
+    struct timeval now;
+    gettimeofday( &now, NULL );
+    return !timercmp( &now, deadline, < );
+#endif
+}
+
+static inline bool clock_past( Timestamp &deadline ) {
+    struct timeval t;
+    t.tv_sec = deadline.getSecs();
+    t.tv_usec = deadline.getUsecs();
+    return clock_past( &t );
+}
+
+/*
+ * With --warmup and no -i the write loops report nothing until the
+ * end, so they mark where the warm-up ends themselves
+ */
+bool Client::WarmupStart( void ) {
+    if ( !isWarmup( mSettings ) || mSettings->mInterval > 0 )
+	return false;
+    mWarmupEnd.setnow();
+    mWarmupEnd.add( mSettings->mWarmupSecs );
+    return true;
+}
+
+bool Client::WarmupOver( max_size_t totLen ) {
+    if ( mSettings->mWarmupSecs > 0 )
+	return clock_past( mWarmupEnd );
+    return totLen >= mSettings->mWarmupBytes;
+}
+
 // A version of the transmit loop that
 // supports TCP rate limiting using a token bucket
 void Client::RunRateLimitedTCP ( void ) {
@@ -170,26 +256,39 @@ void Client::RunRateLimitedTCP ( void ) {
 
     // InitReport handles Barrier for multiple Streams
     mSettings->reporthdr = InitReport( mSettings );
+    mBuckets = TimeBuckets_Init( mSettings );
     reportstruct = new ReportStruct;
     reportstruct->packetID = 0;
     reportstruct->emptyreport=0;
     reportstruct->socket = mSettings->mSock;
+    reportstruct->writeCnt = 0;
 
     lastPacketTime.setnow();
+    // --targets and --sweep streams run more than once or start at
+    // different times so they can't share the process' one interval
+    // timer, they watch the clock instead
+    bool endclock = mMode_Time && (isFanout( mSettings ) || isSweep( mSettings ));
     if ( mMode_Time ) {
 #ifdef HAVE_SETITIMER
-        int err;
-	memset (&it, 0, sizeof (it));
-	it.it_value.tv_sec = (int) (mSettings->mAmount / 100.0);
-	it.it_value.tv_usec = (int) (10000 * (mSettings->mAmount -
-                                     it.it_value.tv_sec * 100.0));
-	err = setitimer( ITIMER_REAL, &it, NULL );
-	FAIL_errno( err != 0, "setitimer", mSettings);
-#else
+	if ( !endclock ) {
+	    int err;
+	    memset (&it, 0, sizeof (it));
+	    it.it_value.tv_sec = (int) (mSettings->mAmount / 100.0);
+	    it.it_value.tv_usec = (int) (10000 * (mSettings->mAmount -
+					 it.it_value.tv_sec * 100.0));
+	    err = setitimer( ITIMER_REAL, &it, NULL );
+	    FAIL_errno( err != 0, "setitimer", mSettings);
+	}
+#endif
         mEndTime.setnow();
 	mEndTime.add( mSettings->mAmount / 100.0 );
-#endif
     }
+    // --warmup without interval reports, the writes until it's over
+    // go to the reporter as one so it can tell them from the rest
+    bool warmup = WarmupStart( );
+#ifdef HAVE_SETITIMER
+    bool stamp = (mBuckets != NULL) || (mSettings->mInterval > 0);
+#endif
     while (1) {
         // Read the next data block from
         // the file if it's file input
@@ -217,7 +316,7 @@ void Client::RunRateLimitedTCP ( void ) {
 	if (tokens >= 0) {
 	    // perform write
 	    reportstruct->errwrite=0;
-	    currLen = write( mSettings->mSock, mBuf, mSettings->mBufLen );
+	    currLen = write( mSettings->mSock, WriteAt( ), mSettings->mBufLen );
 	    if ( currLen < 0 ) {
 		reportstruct->errwrite=1;
 		currLen = 0;
@@ -235,27 +334,34 @@ void Client::RunRateLimitedTCP ( void ) {
 	    // Consume tokens per the transmit
 	    tokens -= currLen;
 	    totLen += currLen;
+	    mPayloadNext += currLen;
 
-#ifndef HAVE_SETITIMER
-	    // Get the time for so the loop can
-	    // end if the running time exceeds the requested
-	    gettimeofday( &(reportstruct->packetTime), NULL );
-# ifndef HAVE_CLOCK_GETTIME
-	    // leverage the packet gettimeofday reducing
-	    // these sys calls (which can be expensive)
-	    // time2 is used for the token bucket adjust
-	    time2 = reportstruct->packetTime.tv_sec + (reportstruct->packetTime.tv_usec / 1000000.0);
-# endif
-#endif
-	    if(mSettings->mInterval > 0) {
+	    // Get the time so the loop can end if the running time
+	    // exceeds the requested.  With the interval timer only the
+	    // buckets and interval reports need it, and share the one read
 #ifdef HAVE_SETITIMER
+	    if ( stamp )
+#endif
+	    {
 		gettimeofday( &(reportstruct->packetTime), NULL );
-# ifndef HAVE_CLOCK_GETTIME
+#ifndef HAVE_CLOCK_GETTIME
 		// leverage the packet gettimeofday reducing
 		// these sys calls (which can be expensive)
+		// time2 is used for the token bucket adjust
 		time2 = reportstruct->packetTime.tv_sec + (reportstruct->packetTime.tv_usec / 1000000.0);
-# endif
 #endif
+	    }
+	    if ( mBuckets != NULL )
+		TimeBuckets_Add( mBuckets, currLen, &reportstruct->packetTime );
+	    if ( warmup && WarmupOver( totLen ) ) {
+		gettimeofday( &(reportstruct->packetTime), NULL );
+		reportstruct->packetLen = totLen;
+		ReportPacket( mSettings->reporthdr, reportstruct );
+		totLen = 0;
+		warmup = false;
+	    }
+
+	    if(mSettings->mInterval > 0) {
 		reportstruct->packetLen = currLen;
 		ReportPacket( mSettings->reporthdr, reportstruct );
 	    }
@@ -274,6 +380,7 @@ void Client::RunRateLimitedTCP ( void ) {
 	}
 #ifdef HAVE_SETITIMER
 	if (sInterupted ||
+	    (endclock     &&  clock_past( mEndTime ))  ||
 	    (!mMode_Time  && (mSettings->mAmount <= 0 || !canRead)))
 	    break;
 #else
@@ -296,6 +403,165 @@ void Client::RunRateLimitedTCP ( void ) {
 
     DELETE_PTR( reportstruct );
     EndReport( mSettings->reporthdr );
+    TimeBuckets_End( mBuckets );
+    mBuckets = NULL;
+}
+
+/* -------------------------------------------------------------------
+ * A latency oriented version of the transmit loop, --write-latency.
+ * TCP_NOTSENT_LOWAT keeps the unsent part of the send queue short
+ * and each write waits for epoll to report the socket writable, so
+ * a write sits in the socket only briefly before it goes out.  Each
+ * write starts with a tcp_write_stamp for the server's write to read
+ * latency, and the send queue occupancy (SIOCOUTQ) is sampled ahead
+ * of every write and summarized at the end.
+ * ------------------------------------------------------------------- */
+void Client::RunWriteLatencyTCP( void ) {
+    int currLen, n, rc;
+    bool mMode_Time = isModeTime( mSettings );
+    tcp_write_stamp *stamp = (tcp_write_stamp *) mBuf;
+    int lowat = (mSettings->mNotSentLowat > 0) ? mSettings->mNotSentLowat : mSettings->mBufLen;
+    int sndqMin = 0, sndqMax = 0;
+    max_size_t sndqCnt = 0;
+    double sndqSum = 0;
+    struct timeval now;
+    ReportStruct *reportstruct = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+    int efd;
+#endif
+
+#ifdef TCP_NOTSENT_LOWAT
+    rc = setsockopt( mSettings->mSock, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+		     (char*) &lowat, sizeof(lowat));
+    WARN_errno( rc == SOCKET_ERROR, "setsockopt TCP_NOTSENT_LOWAT" );
+#else
+    fprintf( stderr, "WARNING: TCP_NOTSENT_LOWAT is not supported on this platform\n");
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+    if ( (efd = epoll_create1( 0 )) >= 0 ) {
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = EPOLLOUT;
+	ev.data.fd = mSettings->mSock;
+	if ( epoll_ctl( efd, EPOLL_CTL_ADD, mSettings->mSock, &ev ) < 0 ) {
+	    WARN_errno( 1, "epoll_ctl" );
+	    close( efd );
+	    efd = -1;
+	}
+    } else {
+	WARN_errno( 1, "epoll_create1" );
+    }
+#endif
+
+    // InitReport handles Barrier for multiple Streams
+    mSettings->reporthdr = InitReport( mSettings );
+    mBuckets = TimeBuckets_Init( mSettings );
+    reportstruct = new ReportStruct;
+    reportstruct->packetID = 0;
+    reportstruct->emptyreport=0;
+    reportstruct->socket = mSettings->mSock;
+    reportstruct->writeCnt = 0;
+
+    lastPacketTime.setnow();
+    if ( mMode_Time ) {
+        mEndTime.setnow();
+	mEndTime.add( mSettings->mAmount / 100.0 );
+    }
+    while ( !sInterupted &&
+	    (mMode_Time ? !clock_past( mEndTime ) : mSettings->mAmount > 0) ) {
+#ifdef HAVE_SYS_EPOLL_H
+	// wait on the low water mark, waking now and then for the end of a timed run
+	if ( efd >= 0 ) {
+	    rc = epoll_wait( efd, &ev, 1, WRITELATENCY_WAIT_MSECS );
+	    if ( rc < 0 && errno != EINTR ) {
+		WARN_errno( 1, "epoll_wait" );
+		break;
+	    }
+	    if ( rc <= 0 )
+		continue;
+	}
+#endif
+#ifdef SIOCOUTQ
+	{
+	    int sndq;
+	    if ( ioctl( mSettings->mSock, SIOCOUTQ, &sndq ) == 0 ) {
+		if ( sndqCnt == 0 || sndq < sndqMin )
+		    sndqMin = sndq;
+		if ( sndqCnt == 0 || sndq > sndqMax )
+		    sndqMax = sndq;
+		sndqSum += sndq;
+		sndqCnt++;
+	    }
+	}
+#endif
+#ifdef HAVE_CLOCK_GETTIME
+	{
+	    struct timespec t1;
+	    clock_gettime( CLOCK_REALTIME, &t1 );
+	    now.tv_sec = t1.tv_sec;
+	    now.tv_usec = t1.tv_nsec / 1000;
+	}
+#else
+	gettimeofday( &now, NULL );
+#endif
+	stamp->magic = htonl( WRITESTAMP_MAGIC );
+	stamp->len = htonl( mSettings->mBufLen );
+	stamp->tv_sec = htonl( now.tv_sec );
+	stamp->tv_usec = htonl( now.tv_usec );
+	// the server finds the next stamp by this one's length
+	// so a short write must be finished before the next
+	reportstruct->errwrite = 0;
+	currLen = 0;
+	while ( currLen < mSettings->mBufLen ) {
+	    n = write( mSettings->mSock, mBuf + currLen, mSettings->mBufLen - currLen );
+	    if ( n < 0 ) {
+		if ( (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) &&
+		     !sInterupted && !(mMode_Time && clock_past( mEndTime )) ) {
+		    continue;
+		}
+		if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+		    WARN_errno( 1, "write" );
+		}
+		reportstruct->errwrite = 1;
+		break;
+	    }
+	    currLen += n;
+	}
+	gettimeofday( &(reportstruct->packetTime), NULL );
+	if ( mBuckets != NULL && currLen > 0 )
+	    TimeBuckets_Add( mBuckets, currLen, &reportstruct->packetTime );
+	reportstruct->packetLen = currLen;
+	ReportPacket( mSettings->reporthdr, reportstruct );
+	if ( reportstruct->errwrite )
+	    break;
+	if ( !mMode_Time ) {
+	    /* mAmount may be unsigned, so don't let it underflow! */
+	    if( mSettings->mAmount >= (unsigned long) currLen ) {
+		mSettings->mAmount -= (unsigned long) currLen;
+	    } else {
+		mSettings->mAmount = 0;
+	    }
+	}
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    if ( efd >= 0 )
+	close( efd );
+#endif
+
+    // stop timing
+    gettimeofday( &(reportstruct->packetTime), NULL );
+    reportstruct->packetLen = 0;
+    CloseReport( mSettings->reporthdr, reportstruct );
+
+    DELETE_PTR( reportstruct );
+    EndReport( mSettings->reporthdr );
+    TimeBuckets_End( mBuckets );
+    mBuckets = NULL;
+    if ( sndqCnt > 0 ) {
+	printf( report_sndq_format, mSettings->mSock, sndqSum / sndqCnt,
+		sndqMin, sndqMax, sndqCnt, lowat );
+	fflush( stdout );
+    }
 }
 
 void Client::RunTCP( void ) {
@@ -311,10 +577,25 @@ void Client::RunTCP( void ) {
 
     // InitReport handles Barrier for multiple Streams
     mSettings->reporthdr = InitReport( mSettings );
+    mBuckets = TimeBuckets_Init( mSettings );
     reportstruct = new ReportStruct;
     reportstruct->packetID = 0;
     reportstruct->emptyreport=0;
     reportstruct->socket = mSettings->mSock;
+    reportstruct->writeCnt = 0;
+
+    /*
+     * With --aggregate the writes are counted here and handed to the
+     * reporter once per interval, or sooner on a write error
+     */
+    bool aggregate = isAggregate( mSettings ) && (mSettings->mInterval > 0) &&
+	(mSettings->reporthdr != NULL);
+    struct timeval aggNext = {0, 0};
+    umax_size_t aggLen = 0;
+    int aggCnt = 0;
+    if ( aggregate ) {
+	aggNext = mSettings->reporthdr->report.nextTime;
+    }
 
     lastPacketTime.setnow();
 
@@ -335,22 +616,43 @@ void Client::RunTCP( void ) {
      * the code path won't make any gettimeofday calls in the main loop
      * which are expensive syscalls.
      */
+    // --targets and --sweep streams run more than once or start at
+    // different times so they can't share the process' one interval
+    // timer, they watch the clock instead
+    bool endclock = mMode_Time && (isFanout( mSettings ) || isSweep( mSettings ));
     if ( mMode_Time ) {
 #ifdef HAVE_SETITIMER
-        int err;
-        struct itimerval it;
-	memset (&it, 0, sizeof (it));
-	it.it_value.tv_sec = (int) (mSettings->mAmount / 100.0);
-	it.it_value.tv_usec = (int) (10000 * (mSettings->mAmount -
-					      it.it_value.tv_sec * 100.0));
-	err = setitimer( ITIMER_REAL, &it, NULL );
-	FAIL_errno( err != 0, "setitimer", mSettings );
-#else
+	if ( !endclock ) {
+	    int err;
+	    struct itimerval it;
+	    memset (&it, 0, sizeof (it));
+	    it.it_value.tv_sec = (int) (mSettings->mAmount / 100.0);
+	    it.it_value.tv_usec = (int) (10000 * (mSettings->mAmount -
+						  it.it_value.tv_sec * 100.0));
+	    err = setitimer( ITIMER_REAL, &it, NULL );
+	    FAIL_errno( err != 0, "setitimer", mSettings );
+	}
+#endif
         mEndTime.setnow();
         mEndTime.add( mSettings->mAmount / 100.0 );
+    }
+    // --warmup without interval reports, the writes until it's over
+    // go to the reporter as one so it can tell them from the rest
+    bool warmup = WarmupStart( );
+#ifdef HAVE_SETITIMER
+    // without the interval timer every write reads the clock for the
+    // end of the test anyway, with it only the buckets and the per
+    // write interval reports need to, and they share the one read
+    bool stamp = (mBuckets != NULL) || (mSettings->mInterval > 0 && !aggregate);
 #endif
+    bool ringdone = false;
+#ifdef HAVE_LINUX_IO_URING_H
+    // the ring loop ends on the interval timer and writes mBuf only
+    if ( isIOUring( mSettings ) && !isFileInput( mSettings ) && !endclock && mPayload == NULL ) {
+	ringdone = RingWriteTCP( reportstruct, &totLen );
     }
-    while (1) {
+#endif
+    while ( !ringdone ) {
         // Read the next data block from
         // the file if it's file input
         if ( isFileInput( mSettings ) ) {
@@ -361,7 +663,7 @@ void Client::RunTCP( void ) {
 
         // perform write
 	reportstruct->errwrite=0;
-        currLen = write( mSettings->mSock, mBuf, mSettings->mBufLen );
+        currLen = write( mSettings->mSock, WriteAt( ), mSettings->mBufLen );
         if ( currLen < 0 ) {
 	    reportstruct->errwrite=1;
 	    currLen = 0;
@@ -378,13 +680,40 @@ void Client::RunTCP( void ) {
         }
 
 	totLen += currLen;
-#ifndef HAVE_SETITIMER
-	gettimeofday( &(reportstruct->packetTime), NULL );
+	mPayloadNext += currLen;
+#ifdef HAVE_SETITIMER
+	if ( stamp )
 #endif
-	if(mSettings->mInterval > 0) {
+	    gettimeofday( &(reportstruct->packetTime), NULL );
+	if ( mBuckets != NULL )
+	    TimeBuckets_Add( mBuckets, currLen, &reportstruct->packetTime );
+	if ( warmup && WarmupOver( totLen ) ) {
+	    gettimeofday( &(reportstruct->packetTime), NULL );
+	    reportstruct->packetLen = totLen;
+	    ReportPacket( mSettings->reporthdr, reportstruct );
+	    totLen = 0;
+	    warmup = false;
+	}
+	if ( aggregate ) {
+	    aggLen += currLen;
+	    if ( !reportstruct->errwrite )
+		aggCnt++;
+	    if ( reportstruct->errwrite || (aggCnt == REPORT_EVENT_MAXCNT) || clock_past( &aggNext ) ) {
 #ifdef HAVE_SETITIMER
-    	    gettimeofday( &(reportstruct->packetTime), NULL );
+		if ( !stamp )
+		    gettimeofday( &(reportstruct->packetTime), NULL );
 #endif
+		reportstruct->packetLen = aggLen;
+		reportstruct->writeCnt = aggCnt;
+		ReportPacket( mSettings->reporthdr, reportstruct );
+		reportstruct->writeCnt = 0;
+		aggLen = 0;
+		aggCnt = 0;
+		while ( !timercmp( &reportstruct->packetTime, &aggNext, < ) ) {
+		    TimeAdd( aggNext, mSettings->reporthdr->report.intervalTime );
+		}
+	    }
+	} else if(mSettings->mInterval > 0) {
             reportstruct->packetLen = currLen;
             ReportPacket( mSettings->reporthdr, reportstruct );
         }
@@ -399,6 +728,7 @@ void Client::RunTCP( void ) {
         }
 #ifdef HAVE_SETITIMER
 	if (sInterupted ||
+	    (endclock     &&  clock_past( mEndTime ))  ||
 	    (!mMode_Time  && (mSettings->mAmount <= 0 || !canRead)))
 	    break;
 #else
@@ -413,6 +743,14 @@ void Client::RunTCP( void ) {
     // stop timing
     gettimeofday( &(reportstruct->packetTime), NULL );
 
+    // hand over what's left of the last interval
+    if ( aggregate && (aggCnt > 0) ) {
+	reportstruct->errwrite = 0;
+	reportstruct->packetLen = aggLen;
+	reportstruct->writeCnt = aggCnt;
+	ReportPacket( mSettings->reporthdr, reportstruct );
+	reportstruct->writeCnt = 0;
+    }
     // if we're not doing interval reporting, report the entire transfer as one big packet
     if(0.0 == mSettings->mInterval) {
         reportstruct->packetLen = totLen;
@@ -422,8 +760,467 @@ void Client::RunTCP( void ) {
 
     DELETE_PTR( reportstruct );
     EndReport( mSettings->reporthdr );
+    TimeBuckets_End( mBuckets );
+    mBuckets = NULL;
+}
+
+/* -------------------------------------------------------------------
+ * The --sweep steps on the one connection.  The socket is retuned
+ * between steps and each step is a RunTCP() of its own, with its own
+ * report, which the reporter hands to Sweep_Account().  A stream the
+ * step has no use for sits it out but still waits at the barrier.
+ * ------------------------------------------------------------------- */
+
+void Client::RunSweep( void ) {
+    int stream = Sweep_Stream( );
+    max_size_t amount = mSettings->mAmount;
+    int step;
+
+    while ( (step = Sweep_Wait( )) >= 0 ) {
+	const char *congestion = Sweep_Congestion( step );
+	int window = Sweep_Window( step );
+
+	if ( stream >= Sweep_Streams( step ) )
+	    continue;
+#ifdef TCP_CONGESTION
+	if ( congestion != NULL ) {
+	    int rc = setsockopt( mSettings->mSock, IPPROTO_TCP, TCP_CONGESTION,
+				 congestion, strlen( congestion ) + 1 );
+	    if ( rc == SOCKET_ERROR ) {
+		fprintf( stderr, "Attempt to set '%s' congestion control failed: %s\n",
+			 congestion, strerror( errno ) );
+	    }
+	}
+#endif
+	if ( window > 0 ) {
+	    setsock_tcp_windowsize( mSettings->mSock, window, 1 );
+	}
+	mSettings->mBufLen = Sweep_Length( step );
+	mSettings->mAmount = amount;
+	mSettings->mSweepStep = step + 1;
+	if ( mSettings->mUDPRate > 0 )
+	    RunRateLimitedTCP();
+	else
+	    RunTCP();
+	// the connection was reported with the first step
+	setNoConnReport( mSettings );
+    }
+}
+
+#ifdef HAVE_LINUX_IO_URING_H
+/* -------------------------------------------------------------------
+ * The RunTCP() write loop using io_uring.  Up to mRingDepth writes
+ * are submitted as one IOSQE_IO_LINK chain so they hit the stream in
+ * order, and the chain is reaped before the next one is queued.  A
+ * short write ends the chain early; whatever it left unwritten leads
+ * the next chain.  A report is generated per completion.  Returns
+ * false if the ring can't be set up so the caller uses write() instead.
+ * ------------------------------------------------------------------- */
+bool Client::RingWriteTCP( ReportStruct *reportstruct, max_size_t *totLen ) {
+    IOUring ring;
+    unsigned tag;
+    int slot, res, ix, head = 0, queued = 0;
+    int *offset, *remain;
+    umax_size_t pending = 0;
+    bool running = true, cancelled, mMode_Time = isModeTime( mSettings );
+
+    if ( IOUring_Init( &ring, mSettings->mSock, mSettings->mRingDepth, mSettings->mBufLen ) < 0 ) {
+	fprintf( stderr, warn_iouring_fallback, mSettings->mSock, strerror( errno ) );
+	return false;
+    }
+    // the chain uses slots head, head+1, ... (mod depth)
+    offset = new int[ring.depth];
+    remain = new int[ring.depth];
+    for ( slot = 0; slot < ring.depth; slot++ ) {
+	pattern( IOUring_Slot( &ring, slot ), mSettings->mBufLen );
+    }
+    while ( running && !sInterupted ) {
+	for ( ; queued < ring.depth && (mMode_Time || mSettings->mAmount > pending); queued++ ) {
+	    slot = (head + queued) % ring.depth;
+	    offset[slot] = 0;
+	    remain[slot] = mSettings->mBufLen;
+	    pending += mSettings->mBufLen;
+	}
+	if ( queued == 0 )
+	    break;
+	for ( ix = 0; ix < queued; ix++ ) {
+	    slot = (head + ix) % ring.depth;
+	    IOUring_PrepWrite( &ring, slot, offset[slot], remain[slot], (ix < queued - 1) );
+	}
+	cancelled = false;
+	while ( ring.inflight > 0 ) {
+	    if ( IOUring_Enter( &ring, 1 ) < 0 ) {
+		if ( errno != EINTR ) {
+		    WARN_errno( 1, "io_uring_enter" );
+		    running = false;
+		    break;
+		}
+	    } else {
+		while ( IOUring_Reap( &ring, &tag, &res ) ) {
+		    if ( tag & IOURING_TAG_CANCEL )
+			continue;
+		    // a write ahead of it in the chain fell short, it's requeued below
+		    if ( res == -ECANCELED )
+			continue;
+		    slot = tag & IOURING_TAG_MASK;
+		    reportstruct->errwrite = 0;
+		    if ( res < 0 ) {
+			if ( res != -EAGAIN && res != -EINTR ) {
+			    errno = -res;
+			    WARN_errno( 1, "write" );
+			    running = false;
+			}
+			reportstruct->errwrite = 1;
+			res = 0;
+		    }
+		    offset[slot] += res;
+		    remain[slot] -= res;
+		    pending -= res;
+		    *totLen += res;
+#ifdef HAVE_SETITIMER
+		    if ( mBuckets != NULL || mSettings->mInterval > 0 )
+#endif
+			gettimeofday( &(reportstruct->packetTime), NULL );
+		    if ( mBuckets != NULL )
+			TimeBuckets_Add( mBuckets, res, &reportstruct->packetTime );
+#ifndef HAVE_SETITIMER
+		    if ( mMode_Time && mEndTime.before( reportstruct->packetTime ) )
+			running = false;
+#endif
+		    if ( mSettings->mInterval > 0 ) {
+			reportstruct->packetLen = res;
+			ReportPacket( mSettings->reporthdr, reportstruct );
+		    }
+		    if ( !mMode_Time ) {
+			/* mAmount may be unsigned, so don't let it underflow! */
+			if( mSettings->mAmount >= (unsigned long) res ) {
+			    mSettings->mAmount -= (unsigned long) res;
+			} else {
+			    mSettings->mAmount = 0;
+			}
+			if ( mSettings->mAmount <= 0 )
+			    running = false;
+		    }
+		}
+	    }
+	    // the alarm (or ^C) interrupts io_uring_enter, pull back whatever is still queued
+	    if ( (sInterupted || !running) && !cancelled ) {
+		for ( ix = 0; ix < queued; ix++ )
+		    IOUring_PrepCancel( &ring, (head + ix) % ring.depth );
+		cancelled = true;
+	    }
+	}
+	if ( ring.inflight > 0 )
+	    break;
+	// the chain runs in order, so what's unwritten is its tail
+	for ( ix = 0; ix < queued && remain[(head + ix) % ring.depth] == 0; ix++ )
+	    ;
+	head = (head + ix) % ring.depth;
+	queued -= ix;
+    }
+    delete [] offset;
+    delete [] remain;
+    IOUring_Destroy( &ring );
+    return true;
+}
+#endif
+
+#ifdef HAVE_NET_NETMAP_USER_H
+/* -------------------------------------------------------------------
+ * The Run() UDP write loop through a netmap port.  Each pass hands
+ * out the datagrams owed per -b, bounded by the free TX slots, and
+ * issues one NIOCTXSYNC.  Datagrams of a pass share its timestamp
+ * and are reported one by one so the reporter sees the same stream
+ * as from write().  Returns false if the port can't be used so the
+ * caller uses write() instead.
+ * ------------------------------------------------------------------- */
+bool Client::NetmapWriteUDP( ReportStruct *reportstruct, double delay_target ) {
+    UDP_datagram hdr;
+    Timestamp start;
+    char *slotbuf;
+    max_size_t sent = 0, due, firstID;
+    long elapsed;
+    int batch, ix;
+    bool running = true, mMode_Time = isModeTime( mSettings );
+
+    mNetmap = Netmap_Open( mSettings->mNetmapPort );
+    if ( mNetmap == NULL )
+	return false;
+    if ( Netmap_TxInit( mNetmap, &mSettings->local, &mSettings->peer, mBuf, mSettings->mBufLen ) != 0 ) {
+	Netmap_Close( mNetmap );
+	mNetmap = NULL;
+	return false;
+    }
+    memcpy( &hdr, mBuf, sizeof(hdr) );
+    start.setnow();
+    while ( running && !sInterupted ) {
+#ifdef HAVE_CLOCK_GETTIME
+	struct timespec t1;
+	clock_gettime(CLOCK_REALTIME, &t1);
+	reportstruct->packetTime.tv_sec = t1.tv_sec;
+	reportstruct->packetTime.tv_usec = (t1.tv_nsec + 500) / 1000L;
+#else
+	gettimeofday( &(reportstruct->packetTime), NULL );
+#endif
+	if ( mMode_Time && mEndTime.before( reportstruct->packetTime ) )
+	    break;
+	// datagrams owed per the offered load, sleep if none are
+	elapsed = -start.subUsec( reportstruct->packetTime );
+	due = (max_size_t) (elapsed * 1e3 / delay_target) + 1 - sent;
+	if ( due <= 0 ) {
+	    delay_loop( (unsigned long) (sent * delay_target / 1e3 - elapsed) + 1 );
+	    continue;
+	}
+	if ( !mMode_Time ) {
+	    max_size_t left = (mSettings->mAmount + mSettings->mBufLen - 1) / mSettings->mBufLen;
+	    if ( due > left )
+		due = left;
+	}
+	hdr.tv_sec  = htonl( reportstruct->packetTime.tv_sec );
+	hdr.tv_usec = htonl( reportstruct->packetTime.tv_usec );
+	firstID = reportstruct->packetID;
+	for ( batch = 0; batch < due; batch++ ) {
+	    if ( !isSeqNo64b( mSettings ) && (reportstruct->packetID & 0x80000000L) ) {
+		// seqno wrapped
+		fprintf( stderr, "%s", warn_seqno_wrap );
+		running = false;
+		break;
+	    }
+	    if ( (slotbuf = Netmap_TxNext( mNetmap )) == NULL )
+		break;
+	    hdr.id = htonl( (reportstruct->packetID & 0xFFFFFFFFL) );
+	    if ( isSeqNo64b( mSettings ) ) {
+		hdr.id2 = htonl( ((reportstruct->packetID & 0xFFFFFFFF00000000LL) >> 32) );
+	    }
+	    memcpy( slotbuf, &hdr, sizeof(hdr) );
+	    reportstruct->packetID++;
+	}
+	if ( batch == 0 ) {
+	    // every TX ring is full, wait for the NIC
+	    if ( running && Netmap_TxWait( mNetmap, 10 ) < 0 && errno != EINTR ) {
+		WARN_errno( 1, "netmap poll" );
+		running = false;
+	    }
+	    continue;
+	}
+	if ( Netmap_TxSync( mNetmap ) < 0 ) {
+	    WARN_errno( 1, "netmap txsync" );
+	    running = false;
+	}
+	sent += batch;
+
+	// report packets
+	reportstruct->packetID = firstID;
+	reportstruct->packetLen = (unsigned long) mSettings->mBufLen;
+	for ( ix = 0; ix < batch; ix++ ) {
+	    reportstruct->packetID++;
+	    ReportPacket( mSettings->reporthdr, reportstruct );
+	}
+	if ( mBuckets != NULL )
+	    TimeBuckets_Add( mBuckets, batch * mSettings->mBufLen, &reportstruct->packetTime );
+	if ( !mMode_Time ) {
+	    /* mAmount may be unsigned, so don't let it underflow! */
+	    if( mSettings->mAmount >= (unsigned long) (batch * mSettings->mBufLen) ) {
+		mSettings->mAmount -= (unsigned long) (batch * mSettings->mBufLen);
+	    } else {
+		mSettings->mAmount = 0;
+	    }
+	    if ( mSettings->mAmount <= 0 )
+		running = false;
+	}
+    }
+    Netmap_TxDrain( mNetmap, 1000 );
+    // leave the last header in mBuf for the FIN
+    memcpy( mBuf, &hdr, sizeof(hdr) );
+    return true;
+}
+#endif
+
+/*
+ * A datagram's send time, rounded to the usec from the finer clock
+ * where there is one
+ */
+static inline void send_time( struct timeval *now ) {
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec t1;
+    clock_gettime( CLOCK_REALTIME, &t1 );
+    now->tv_sec = t1.tv_sec;
+    now->tv_usec = (t1.tv_nsec + 500) / 1000L;
+#else
+    gettimeofday( now, NULL );
+#endif
 }
 
+/* -------------------------------------------------------------------
+ * The Run() send loop.  The settings it used to test on every
+ * datagram are template arguments instead, Run() picks the one
+ * instance that fits from send_loops[] and the loop itself only
+ * branches on what changes as it runs.
+ * ------------------------------------------------------------------- */
+
+template <bool UDP, bool Seq64, bool Payload, bool Buckets, bool FileInput, bool TimeMode>
+void Client::SendLoop( ReportStruct *reportstruct, char *readAt, double delay_target,
+		       double delay_lower_bounds ) {
+    char *buf = mBuf;
+    struct UDP_datagram* mBuf_UDP = (struct UDP_datagram*) mBuf;
+    const int sock = mSettings->mSock;
+    const int buflen = mSettings->mBufLen;
+    ReportHeader *reporthdr = mSettings->reporthdr;
+    double delay = 0;
+    double adjust = 0;
+    // Indicates if the stream is readable
+    bool canRead = true;
+    // Set this to > 0 so first loop iteration will delay the IPG
+    int currLen = 1;
+
+    do {
+
+        // Test case: drop 17 packets and send 2 out-of-order:
+        // sequence 51, 52, 70, 53, 54, 71, 72
+        //switch( datagramID ) {
+        //  case 53: datagramID = 70; break;
+        //  case 71: datagramID = 53; break;
+        //  case 55: datagramID = 71; break;
+        //  default: break;
+        //}
+	send_time( &reportstruct->packetTime );
+	if ( Payload ) {
+	    // the datagram's slot, or where the TCP stream is in the pool
+	    if ( UDP ) {
+		buf = mSlots + (reportstruct->packetID % PAYLOAD_SLOTS) * buflen;
+		mBuf_UDP = (struct UDP_datagram*) buf;
+	    } else {
+		buf = WriteAt( );
+	    }
+	}
+        if ( UDP ) {
+            // store datagram ID into buffer
+	    mBuf_UDP->id      = htonl((reportstruct->packetID & 0xFFFFFFFFL));
+	    if ( Seq64 ) {
+		mBuf_UDP->id2      = htonl(((reportstruct->packetID & 0xFFFFFFFF00000000LL) >> 32));
+	    }
+	    mBuf_UDP->tv_sec  = htonl(reportstruct->packetTime.tv_sec);
+	    mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
+	    reportstruct->packetID++;
+	    if ( !Seq64 && (reportstruct->packetID & 0x80000000L) ) {
+		// seqno wrapped
+		fprintf(stderr, "%s", warn_seqno_wrap);
+		break;
+	    }
+	    // Adjustment for the running delay
+	    // o measure how long the last loop iteration took
+	    // o calculate the delay adjust
+	    //   - If write succeeded, adjust = target IPG - the loop time
+	    //   - If write failed, adjust = the loop time
+	    // o then adjust the overall running delay
+	    // Note: adjust units are nanoseconds,
+	    //       packet timestamps are microseconds
+	    if (currLen > 0)
+		adjust = delay_target + \
+		    (1000.0 * lastPacketTime.subUsec( reportstruct->packetTime ));
+	    else
+		adjust = 1000.0 * lastPacketTime.subUsec( reportstruct->packetTime );
+
+	    lastPacketTime.set( reportstruct->packetTime.tv_sec,
+				reportstruct->packetTime.tv_usec );
+	    // Since linux nanosleep/busyloop can exceed delay
+	    // there are two possible equilibriums
+	    //  1)  Try to perserve inter packet gap
+	    //  2)  Try to perserve requested transmit rate
+	    // The latter seems preferred, hence use a running delay
+	    // that spans the life of the thread and constantly adjust.
+	    // A negative delay means the iperf app is behind.
+	    delay += adjust;
+	    // Don't let delay grow unbounded
+	    if (delay < delay_lower_bounds) {
+		delay = delay_target;
+	    }
+	}
+
+	// Read the next data block from
+	// the file if it's file input
+	if ( FileInput ) {
+	    Extractor_getNextDataBlock( readAt, mSettings );
+	    canRead = Extractor_canRead( mSettings ) != 0;
+	}
+
+	// perform write
+	currLen = write( sock, buf, buflen );
+	if ( currLen < 0 ) {
+	    reportstruct->errwrite = 1;
+	    reportstruct->packetID--;
+	    reportstruct->emptyreport=1;
+	    currLen = 0;
+	    if (
+#ifdef WIN32
+		(errno = WSAGetLastError()) != WSAETIMEDOUT &&
+		errno != WSAECONNREFUSED
+#else
+		errno != EAGAIN && errno != EWOULDBLOCK &&
+		errno != EINTR  && errno != ECONNREFUSED &&
+		errno != ENOBUFS
+#endif
+		) {
+		WARN_errno( 1, "write" );
+		break;
+	    }
+	}
+
+	if ( Payload && !UDP )
+	    mPayloadNext += currLen;
+
+	// report packets
+	reportstruct->packetLen = (unsigned long) currLen;
+	if ( Buckets && currLen > 0 )
+	    TimeBuckets_Add( mBuckets, currLen, &reportstruct->packetTime );
+	ReportPacket( reporthdr, reportstruct );
+
+	// Insert delay here only if the running delay is greater than 1 usec,
+	// otherwise don't delay and immediately continue with the next tx.
+	if ( UDP && delay >= 1000 ) {
+	    // Convert from nanoseconds to microseconds
+	    // and invoke the microsecond delay
+	    delay_loop((unsigned long) (delay / 1000));
+	}
+	if ( !TimeMode ) {
+	    /* mAmount may be unsigned, so don't let it underflow! */
+	    if( mSettings->mAmount >= (unsigned long) currLen ) {
+		mSettings->mAmount -= (unsigned long) currLen;
+	    } else {
+		mSettings->mAmount = 0;
+	    }
+	}
+
+    } while ( ! (sInterupted  ||
+                 (TimeMode   &&  mEndTime.before( reportstruct->packetTime ))  ||
+                 (!TimeMode  &&  0 >= mSettings->mAmount)) && canRead );
+}
+
+// a UDP or TCP, 64 bit ID, --payload group of eight send_loops[]
+#define SEND_LOOPS(udp, seq64, payload) \
+    &Client::SendLoop<udp, seq64, payload, false, false, false>, \
+    &Client::SendLoop<udp, seq64, payload, false, false, true>, \
+    &Client::SendLoop<udp, seq64, payload, false, true, false>, \
+    &Client::SendLoop<udp, seq64, payload, false, true, true>, \
+    &Client::SendLoop<udp, seq64, payload, true, false, false>, \
+    &Client::SendLoop<udp, seq64, payload, true, false, true>, \
+    &Client::SendLoop<udp, seq64, payload, true, true, false>, \
+    &Client::SendLoop<udp, seq64, payload, true, true, true>
+
+// indexed by UDP, 64 bit IDs, --payload, --time-buckets, file input
+// and -t, in that bit order
+const Client::SendLoopFn Client::send_loops[64] = {
+    SEND_LOOPS(false, false, false),
+    SEND_LOOPS(false, false, true),
+    // TCP has no IDs, Run() never picks these
+    SEND_LOOPS(false, false, false),
+    SEND_LOOPS(false, false, true),
+    SEND_LOOPS(true, false, false),
+    SEND_LOOPS(true, false, true),
+    SEND_LOOPS(true, true, false),
+    SEND_LOOPS(true, true, true)
+};
+
 /* -------------------------------------------------------------------
  * Send data using the connected UDP/TCP socket,
  * until a termination flag is reached.
@@ -432,11 +1229,8 @@ void Client::RunTCP( void ) {
 
 void Client::Run( void ) {
     struct UDP_datagram* mBuf_UDP = (struct UDP_datagram*) mBuf;
-    int currLen;
 
     double delay_target = 0;
-    double delay = 0;
-    double adjust = 0;
     double delay_lower_bounds;
 
     char* readAt = mBuf;
@@ -473,16 +1267,36 @@ void Client::Run( void ) {
 
 #if HAVE_THREAD
     if ( !isUDP( mSettings ) ) {
-	if (mSettings->mUDPRate > 0)
+#ifdef HAVE_TCP_SAMPLER
+	TCPSampler *sampler = NULL;
+	if ( isTCPSample( mSettings ) ) {
+	    // size the ring to hold the whole run when its length is known
+	    int depth = 0;
+	    if ( isModeTime( mSettings ) ) {
+		double samples = mSettings->mAmount * 1e4 / mSettings->mSampleUsecs;
+		depth = (samples < TCPSAMPLE_MAX_DEPTH) ? (int) samples + 16 : TCPSAMPLE_MAX_DEPTH;
+	    }
+	    sampler = TCPSampler_Start( mSettings->mSock, mSettings->mSampleUsecs, depth );
+	    WARN( sampler == NULL, "TCP_INFO sampler start failed" );
+	}
+#endif
+	if ( isSweep( mSettings ) )
+	    RunSweep();
+	else if ( isWriteLatency( mSettings ) )
+	    RunWriteLatencyTCP();
+	else if (mSettings->mUDPRate > 0)
 	    RunRateLimitedTCP();
 	else
 	    RunTCP();
+#ifdef HAVE_TCP_SAMPLER
+	if ( sampler != NULL )
+	    TCPSampler_Stop( sampler );
+#endif
 	return;
     }
 #endif
 
-    // Indicates if the stream is readable
-    bool canRead = true, mMode_Time = isModeTime( mSettings );
+    bool mMode_Time = isModeTime( mSettings );
 
     // setup termination variables
     if ( mMode_Time ) {
@@ -541,132 +1355,33 @@ void Client::Run( void ) {
 
     // InitReport handles Barrier for multiple Streams
     mSettings->reporthdr = InitReport( mSettings );
+    mBuckets = TimeBuckets_Init( mSettings );
     reportstruct = new ReportStruct;
     reportstruct->packetID = (isPeerVerDetect(mSettings)) ? 1 : 0;
     reportstruct->emptyreport=0;
     reportstruct->errwrite=0;
     reportstruct->socket = mSettings->mSock;
+    reportstruct->writeCnt = 0;
 
     // reportstruct->packetID = (0x80000000L - 3);
     lastPacketTime.setnow();
-    // Set this to > 0 so first loop iteration will delay the IPG
-    currLen = 1;
-
-    do {
-
-        // Test case: drop 17 packets and send 2 out-of-order:
-        // sequence 51, 52, 70, 53, 54, 71, 72
-        //switch( datagramID ) {
-        //  case 53: datagramID = 70; break;
-        //  case 71: datagramID = 53; break;
-        //  case 55: datagramID = 71; break;
-        //  default: break;
-        //}
-#ifdef HAVE_CLOCK_GETTIME
-	struct timespec t1;
-	clock_gettime(CLOCK_REALTIME, &t1);
-	reportstruct->packetTime.tv_sec = t1.tv_sec;
-	reportstruct->packetTime.tv_usec = (t1.tv_nsec + 500) / 1000L;
-#else
-        gettimeofday( &(reportstruct->packetTime), NULL );
-#endif
-        if (isUDP(mSettings)) {
-            // store datagram ID into buffer
-	    mBuf_UDP->id      = htonl((reportstruct->packetID & 0xFFFFFFFFL));
-	    if (isSeqNo64b(mSettings)) {
-		mBuf_UDP->id2      = htonl(((reportstruct->packetID & 0xFFFFFFFF00000000LL) >> 32));
-	    }
-	    mBuf_UDP->tv_sec  = htonl(reportstruct->packetTime.tv_sec);
-	    mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
-	    reportstruct->packetID++;
-	    if (!isSeqNo64b(mSettings) && (reportstruct->packetID & 0x80000000L)) {
-		// seqno wrapped
-		fprintf(stderr, "%s", warn_seqno_wrap);
-		break;
-	    }
-	    // Adjustment for the running delay
-	    // o measure how long the last loop iteration took
-	    // o calculate the delay adjust
-	    //   - If write succeeded, adjust = target IPG - the loop time
-	    //   - If write failed, adjust = the loop time
-	    // o then adjust the overall running delay
-	    // Note: adjust units are nanoseconds,
-	    //       packet timestamps are microseconds
-	    if (currLen > 0)
-		adjust = delay_target + \
-		    (1000.0 * lastPacketTime.subUsec( reportstruct->packetTime ));
-	    else
-		adjust = 1000.0 * lastPacketTime.subUsec( reportstruct->packetTime );
 
-	    lastPacketTime.set( reportstruct->packetTime.tv_sec,
-				reportstruct->packetTime.tv_usec );
-	    // Since linux nanosleep/busyloop can exceed delay
-	    // there are two possible equilibriums
-	    //  1)  Try to perserve inter packet gap
-	    //  2)  Try to perserve requested transmit rate
-	    // The latter seems preferred, hence use a running delay
-	    // that spans the life of the thread and constantly adjust.
-	    // A negative delay means the iperf app is behind.
-	    delay += adjust;
-	    // Don't let delay grow unbounded
-	    if (delay < delay_lower_bounds) {
-		delay = delay_target;
-	    }
-	}
-
-	// Read the next data block from
-	// the file if it's file input
-	if ( isFileInput( mSettings ) ) {
-	    Extractor_getNextDataBlock( readAt, mSettings );
-	    canRead = Extractor_canRead( mSettings ) != 0;
-	} else
-	    canRead = true;
-
-	// perform write
-	currLen = write( mSettings->mSock, mBuf, mSettings->mBufLen );
-	if ( currLen < 0 ) {
-	    reportstruct->errwrite = 1;
-	    reportstruct->packetID--;
-	    reportstruct->emptyreport=1;
-	    currLen = 0;
-	    if (
-#ifdef WIN32
-		(errno = WSAGetLastError()) != WSAETIMEDOUT &&
-		errno != WSAECONNREFUSED
-#else
-		errno != EAGAIN && errno != EWOULDBLOCK &&
-		errno != EINTR  && errno != ECONNREFUSED &&
-		errno != ENOBUFS
+    bool netmapdone = false;
+#ifdef HAVE_NET_NETMAP_USER_H
+    if ( isUDP( mSettings ) && isNetmap( mSettings ) && !isFileInput( mSettings ) ) {
+	netmapdone = NetmapWriteUDP( reportstruct, delay_target );
+    }
 #endif
-		) {
-		WARN_errno( 1, "write" );
-		break;
-	    }
-	}
-
-	// report packets
-	reportstruct->packetLen = (unsigned long) currLen;
-	ReportPacket( mSettings->reporthdr, reportstruct );
-
-	// Insert delay here only if the running delay is greater than 1 usec,
-	// otherwise don't delay and immediately continue with the next tx.
-	if ( delay >= 1000 ) {
-	    // Convert from nanoseconds to microseconds
-	    // and invoke the microsecond delay
-	    delay_loop((unsigned long) (delay / 1000));
-	}
-	if ( !mMode_Time ) {
-	    /* mAmount may be unsigned, so don't let it underflow! */
-	    if( mSettings->mAmount >= (unsigned long) currLen ) {
-		mSettings->mAmount -= (unsigned long) currLen;
-	    } else {
-		mSettings->mAmount = 0;
-	    }
-	}
-
-    } while ( ! (sInterupted  ||
-                 (mMode_Time   &&  mEndTime.before( reportstruct->packetTime ))  ||
-                 (!mMode_Time  &&  0 >= mSettings->mAmount)) && canRead );
+    if ( !netmapdone ) {
+	// the TCP loop has no datagram ID to number
+	bool seq64 = isUDP( mSettings ) && isSeqNo64b( mSettings );
+	if ( isUDP( mSettings ) && mPayload != NULL )
+	    PayloadSlots( );
+	SendLoopFn loop = send_loops[(isUDP( mSettings ) ? 32 : 0) + (seq64 ? 16 : 0) +
+				   ((mPayload != NULL) ? 8 : 0) + ((mBuckets != NULL) ? 4 : 0) +
+				   (isFileInput( mSettings ) ? 2 : 0) + (mMode_Time ? 1 : 0)];
+	(this->*loop)( reportstruct, readAt, delay_target, delay_lower_bounds );
+    }
 
     // stop timing
     gettimeofday( &(reportstruct->packetTime), NULL );
@@ -685,16 +1400,32 @@ void Client::Run( void ) {
 	} else {
 	    mBuf_UDP->id      = htonl(((reportstruct->packetID & 0xFFFFFFFFL) | 0x80000000L));
 	}
+        // with --payload the loop stamped the slots, not mBuf
+        mBuf_UDP->tv_sec = htonl( reportstruct->packetTime.tv_sec );
         mBuf_UDP->tv_usec = htonl( reportstruct->packetTime.tv_usec );
 
         if ( isMulticast( mSettings ) ) {
-            write(mSettings->mSock, mBuf, mSettings->mBufLen);
+            write_UDP_datagram( );
+#ifdef HAVE_NET_NETMAP_USER_H
+        } else if ( mNetmap != NULL ) {
+            // the server's ack can't come back through the port, don't wait for it
+            write_UDP_datagram( );
+            fprintf( stderr, warn_netmap_fin, mSettings->mSock );
+#endif
         } else {
             write_UDP_FIN( );
         }
     }
+#ifdef HAVE_NET_NETMAP_USER_H
+    if ( mNetmap != NULL ) {
+	Netmap_Close( mNetmap );
+	mNetmap = NULL;
+    }
+#endif
     DELETE_PTR( reportstruct );
     EndReport( mSettings->reporthdr );
+    TimeBuckets_End( mBuckets );
+    mBuckets = NULL;
 }
 // end Run
 
@@ -834,6 +1565,9 @@ void Client::HdrXchange(int flags) {
 	    if ((n = recvn(mSettings->mSock, (char *)&ack, sizeof(client_hdr_ack), 0)) == sizeof(client_hdr_ack)) {
 		if (ntohl(ack.typelen.type) == CLIENTHDRACK && ntohl(ack.typelen.length) == sizeof(client_hdr_ack)) {
 		    reporter_peerversion (mSettings, ntohl(ack.version_u), ntohl(ack.version_l));
+		    if ((ntohl(ack.flags) & CLOCKSYNC) != 0) {
+			ClockSyncReply();
+		    }
 		} else {
 		    sprintf(mSettings->peerversion, " (misformed server version)");
 		}
@@ -872,6 +1606,61 @@ void Client::HdrXchange(int flags) {
     }
 }
 
+/* -------------------------------------------------------------------
+ * Answer the server's --clock-sync timestamp exchanges, see
+ * Listener::ClockSync().  The header ack read timeout bounds each
+ * wait and any failure ends the exchange.
+ * ------------------------------------------------------------------- */
+void Client::ClockSyncReply( void ) {
+    clock_sync_msg msg;
+    struct timeval now;
+    int ix, n;
+
+    for (ix = 0; ix < CLOCKSYNC_PINGS; ix++) {
+	if (isUDP(mSettings)) {
+	    n = recv(mSettings->mSock, (char *)&msg, sizeof(msg), 0);
+	} else {
+	    n = recvn(mSettings->mSock, (char *)&msg, sizeof(msg), 0);
+	}
+	gettimeofday(&now, NULL);
+	if (n != sizeof(msg) || ntohl(msg.typelen.type) != CLOCKSYNCMSG) {
+	    break;
+	}
+	msg.t2_sec = htonl(now.tv_sec);
+	msg.t2_usec = htonl(now.tv_usec);
+	gettimeofday(&now, NULL);
+	msg.t3_sec = htonl(now.tv_sec);
+	msg.t3_usec = htonl(now.tv_usec);
+	if (send(mSettings->mSock, (const char *)&msg, sizeof(msg), 0) != sizeof(msg)) {
+	    WARN_errno(1, "send clock sync");
+	    break;
+	}
+    }
+}
+
+/* -------------------------------------------------------------------
+ * Write mBuf as a single datagram.  When the data went out through
+ * a netmap port so do the trailing datagrams, otherwise the server
+ * would see them arrive ahead of the traffic still in the TX rings.
+ * ------------------------------------------------------------------- */
+
+int Client::write_UDP_datagram( ) {
+#ifdef HAVE_NET_NETMAP_USER_H
+    if ( mNetmap != NULL ) {
+	char *slotbuf = Netmap_TxNext( mNetmap );
+	if ( slotbuf == NULL ) {
+	    errno = ENOBUFS;
+	    return -1;
+	}
+	// the rest of the payload was stamped into the slot by Netmap_TxInit()
+	memcpy( slotbuf, mBuf, sizeof(UDP_datagram) );
+	Netmap_TxSync( mNetmap );
+	return mSettings->mBufLen;
+    }
+#endif
+    return write( mSettings->mSock, mBuf, mSettings->mBufLen );
+}
+
 /* -------------------------------------------------------------------
  * Send a datagram on the socket. The datagram's contents should signify
  * a FIN to the application. Keep re-transmitting until an
@@ -890,7 +1679,7 @@ void Client::write_UDP_FIN( ) {
         count++;
 
         // write data
-        write( mSettings->mSock, mBuf, mSettings->mBufLen );
+        write_UDP_datagram( );
 	// decrement the packet count
 	//
 	// Note: a negative packet id is used to tell the server
@@ -0,0 +1,281 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * Fanout.cpp
+ * -------------------------------------------------------------------
+ * The --targets list and how its streams are scheduled.  Each target
+ * is a group of -P client threads started together, like a plain
+ * -c run.  The groups are dealt out over --fanout / -P pool slots
+ * and the next group on a slot is the runNext of every stream of the
+ * one before.  Those streams share a runGroup count so the next group
+ * starts when the last of them ends, and only the first group on
+ * each slot is started from main.
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "PerfSocket.hpp"
+#include "Locale.h"
+#include "util.h"
+#include "Fanout.h"
+
+typedef struct FanoutTarget {
+    char *host;
+    umax_size_t TotalLen;
+    double endTime;
+    int streams;
+} FanoutTarget;
+
+static FanoutTarget *fanout_targets = NULL;
+static int fanout_count = 0;
+static int fanout_alloc = 0;
+// per target, its streams still running
+static int *fanout_running = NULL;
+static struct timeval fanout_start;
+static char fanout_format = 'a';
+
+static int fanout_add( const char *host ) {
+    if ( fanout_count == FANOUT_MAX_TARGETS ) {
+	fprintf( stderr, warn_fanout_max, FANOUT_MAX_TARGETS );
+	return 0;
+    }
+    if ( fanout_count == fanout_alloc ) {
+	FanoutTarget *grown;
+	fanout_alloc = (fanout_alloc == 0) ? 64 : fanout_alloc * 2;
+	grown = (FanoutTarget *) realloc( fanout_targets, fanout_alloc * sizeof(FanoutTarget) );
+	if ( grown == NULL )
+	    return 0;
+	fanout_targets = grown;
+    }
+    memset( &fanout_targets[fanout_count], 0, sizeof(FanoutTarget) );
+    fanout_targets[fanout_count].host = new char[strlen( host ) + 1];
+    strcpy( fanout_targets[fanout_count].host, host );
+    fanout_count++;
+    return 1;
+}
+
+/*
+ * Every host address in an IPv4 range, leaving out the network and
+ * broadcast addresses unless it's a /31 or /32
+ */
+static int fanout_cidr( const char *spec ) {
+    char addr[INET_ADDRSTRLEN];
+    const char *slash = strchr( spec, '/' );
+    struct in_addr in;
+    uint32_t first, last, mask;
+    int prefix;
+
+    if ( slash == NULL || (slash - spec) >= (int) sizeof(addr) )
+	return 0;
+    memcpy( addr, spec, slash - spec );
+    addr[slash - spec] = '\0';
+    prefix = atoi( slash + 1 );
+    if ( inet_pton( AF_INET, addr, &in ) != 1 || prefix < 0 || prefix > 32 )
+	return 0;
+    mask = (prefix == 0) ? 0 : ~0U << (32 - prefix);
+    first = ntohl( in.s_addr ) & mask;
+    last = first | ~mask;
+    if ( prefix < 31 ) {
+	first++;
+	last--;
+    }
+    for ( uint32_t a = first; ; a++ ) {
+	in.s_addr = htonl( a );
+	inet_ntop( AF_INET, &in, addr, sizeof(addr) );
+	if ( !fanout_add( addr ) || a == last )
+	    break;
+    }
+    return fanout_count;
+}
+
+static int fanout_file( FILE *f ) {
+    char line[256];
+
+    while ( fgets( line, sizeof(line), f ) != NULL ) {
+	char *host = line;
+	char *end;
+	if ( (end = strchr( line, '#' )) != NULL )
+	    *end = '\0';
+	while ( isspace( (unsigned char) *host ) )
+	    host++;
+	for ( end = host; *end != '\0' && !isspace( (unsigned char) *end ); end++ )
+	    ;
+	*end = '\0';
+	if ( *host != '\0' && !fanout_add( host ) )
+	    break;
+    }
+    return fanout_count;
+}
+
+int Fanout_Load( const char *spec ) {
+    FILE *f = fopen( spec, "r" );
+
+    if ( f != NULL ) {
+	fanout_file( f );
+	fclose( f );
+    } else {
+	fanout_cidr( spec );
+    }
+    if ( fanout_count == 0 ) {
+	fprintf( stderr, warn_fanout_targets, spec );
+    }
+    return fanout_count;
+}
+
+const char* Fanout_Host( int target ) {
+    return fanout_targets[target].host;
+}
+
+void Fanout_Init( thread_Settings *clients ) {
+    thread_Settings *head = NULL;
+    thread_Settings *itr = NULL;
+    thread_Settings *started = NULL;
+    thread_Settings **slot;
+    int width;
+
+    if ( clients->mMode != kTest_Normal ) {
+	fprintf( stderr, "%s", warn_fanout_mode );
+	clients->mMode = kTest_Normal;
+    }
+    width = clients->mFanout / clients->mThreads;
+    if ( width < 1 )
+	width = 1;
+    if ( width > fanout_count )
+	width = fanout_count;
+    // the last group dealt to each slot
+    slot = new thread_Settings*[width];
+    fanout_running = new int[fanout_count];
+    gettimeofday( &fanout_start, NULL );
+    fanout_format = clients->mFormat;
+
+    for ( int t = 0; t < fanout_count; t++ ) {
+	// the settings passed in are the first target's first stream
+	if ( t == 0 ) {
+	    head = clients;
+	} else {
+	    Settings_Copy( clients, &head );
+	    unsetReport( head );
+	    DELETE_ARRAY( head->mHost );
+	    head->mHost = new char[strlen( fanout_targets[t].host ) + 1];
+	    strcpy( head->mHost, fanout_targets[t].host );
+	}
+	head->mTarget = t + 1;
+	fanout_running[t] = clients->mThreads;
+	head->runGroup = &fanout_running[t];
+	Mutex_Lock( &groupCond );
+	groupID--;
+	head->multihdr = InitMulti( head, groupID );
+	Mutex_Unlock( &groupCond );
+	// the target's other streams are started along with it
+	itr = head;
+	for ( int i = 1; i < clients->mThreads; i++ ) {
+	    Settings_Copy( head, &itr->runNow );
+	    unsetReport( itr->runNow );
+	    itr = itr->runNow;
+	    itr->runGroup = head->runGroup;
+	}
+	if ( t < width ) {
+	    if ( started != NULL )
+		started->runNow = head;
+	    started = itr;
+	} else {
+	    itr = slot[t % width];
+	    for ( int i = 0; i < clients->mThreads; i++, itr = itr->runNow )
+		itr->runNext = head;
+	}
+	slot[t % width] = head;
+    }
+    delete [] slot;
+}
+
+void Fanout_Account( ReporterData *stats ) {
+    FanoutTarget *target = &fanout_targets[stats->mTarget - 1];
+
+    target->TotalLen += stats->TotalLen;
+    if ( stats->info.endTime > target->endTime )
+	target->endTime = stats->info.endTime;
+    target->streams++;
+}
+
+void Fanout_Print( void ) {
+    char buffer[64];
+    umax_size_t total = 0;
+    struct timeval now;
+    double secs;
+    int done = 0;
+
+    if ( fanout_count == 0 )
+	return;
+    printf( "%s", report_fanout_header );
+    for ( int t = 0; t < fanout_count; t++ ) {
+	FanoutTarget *target = &fanout_targets[t];
+	if ( target->streams == 0 ) {
+	    printf( report_fanout_failed, target->host );
+	    continue;
+	}
+	byte_snprintf( buffer, sizeof(buffer)/2, (double) target->TotalLen,
+		       toupper( (int) fanout_format ) );
+	byte_snprintf( &buffer[sizeof(buffer)/2], sizeof(buffer)/2,
+		       (target->endTime > 0) ? target->TotalLen / target->endTime : 0.0,
+		       fanout_format );
+	printf( report_fanout_format, target->host, target->streams,
+		target->endTime, buffer, &buffer[sizeof(buffer)/2] );
+	total += target->TotalLen;
+	done++;
+    }
+    // the whole run's rate is over the wall clock, groups on a
+    // pool slot run one after another
+    gettimeofday( &now, NULL );
+    secs = TimeDifference( now, fanout_start );
+    byte_snprintf( buffer, sizeof(buffer)/2, (double) total, toupper( (int) fanout_format ) );
+    byte_snprintf( &buffer[sizeof(buffer)/2], sizeof(buffer)/2,
+		   (secs > 0) ? total / secs : 0.0, fanout_format );
+    printf( report_fanout_sum_format, done, fanout_count, secs, buffer,
+	    &buffer[sizeof(buffer)/2] );
+    fflush( stdout );
+}
@@ -0,0 +1,298 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * IOUring.c
+ * -------------------------------------------------------------------
+ * A minimal io_uring wrapper (raw syscalls, no liburing) used by the
+ * client and server traffic loops.  Anything that goes wrong during
+ * setup is returned to the caller which then falls back to the
+ * normal read()/write() loops.
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "IOUring.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+// the io_uring syscall numbers are common to all the generic syscall tables
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup    425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter    426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int IOUring_Init( IOUring *ring, int sock, int depth, int buflen ) {
+    struct io_uring_params p;
+    struct iovec iov;
+    int saved_errno;
+
+    memset( ring, 0, sizeof(IOUring) );
+    ring->ring_fd = -1;
+    if ( depth < 1 ) {
+	depth = 1;
+    } else if ( depth > IOURING_MAX_DEPTH ) {
+	depth = IOURING_MAX_DEPTH;
+    }
+    ring->sock = sock;
+    ring->depth = depth;
+    ring->buflen = buflen;
+
+    // room for a read/write plus a cancel per slot, a timeout and its removal
+    memset( &p, 0, sizeof(p) );
+    ring->ring_fd = (int) syscall( __NR_io_uring_setup, 2 * depth + 2, &p );
+    if ( ring->ring_fd < 0 ) {
+	return -1;
+    }
+    ring->sq_entries = p.sq_entries;
+    ring->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if ( p.features & IORING_FEAT_SINGLE_MMAP ) {
+	if ( ring->cq_ring_sz > ring->sq_ring_sz )
+	    ring->sq_ring_sz = ring->cq_ring_sz;
+	ring->cq_ring_sz = ring->sq_ring_sz;
+    }
+    ring->sq_ring = mmap( NULL, ring->sq_ring_sz, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING );
+    if ( ring->sq_ring == MAP_FAILED ) {
+	ring->sq_ring = NULL;
+	goto fail;
+    }
+    if ( p.features & IORING_FEAT_SINGLE_MMAP ) {
+	ring->cq_ring = ring->sq_ring;
+    } else {
+	ring->cq_ring = mmap( NULL, ring->cq_ring_sz, PROT_READ | PROT_WRITE,
+			      MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING );
+	if ( ring->cq_ring == MAP_FAILED ) {
+	    ring->cq_ring = NULL;
+	    goto fail;
+	}
+    }
+    ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *) mmap( NULL, ring->sqes_sz, PROT_READ | PROT_WRITE,
+					       MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES );
+    if ( ring->sqes == MAP_FAILED ) {
+	ring->sqes = NULL;
+	goto fail;
+    }
+    ring->sq_head  = (unsigned *) ((char *) ring->sq_ring + p.sq_off.head);
+    ring->sq_tail  = (unsigned *) ((char *) ring->sq_ring + p.sq_off.tail);
+    ring->sq_mask  = (unsigned *) ((char *) ring->sq_ring + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) ((char *) ring->sq_ring + p.sq_off.array);
+    ring->cq_head  = (unsigned *) ((char *) ring->cq_ring + p.cq_off.head);
+    ring->cq_tail  = (unsigned *) ((char *) ring->cq_ring + p.cq_off.tail);
+    ring->cq_mask  = (unsigned *) ((char *) ring->cq_ring + p.cq_off.ring_mask);
+    ring->cqes     = (struct io_uring_cqe *) ((char *) ring->cq_ring + p.cq_off.cqes);
+
+    if ( posix_memalign( (void **) &ring->buf, 4096, (size_t) depth * buflen ) != 0 ) {
+	ring->buf = NULL;
+	errno = ENOMEM;
+	goto fail;
+    }
+    // Registered buffers and files are optimizations only, e.g. a low
+    // RLIMIT_MEMLOCK on older kernels will fail the buffer registration
+    // in which case plain send/recv opcodes are used
+    iov.iov_base = ring->buf;
+    iov.iov_len = (size_t) depth * buflen;
+    if ( syscall( __NR_io_uring_register, ring->ring_fd, IORING_REGISTER_BUFFERS, &iov, 1 ) == 0 ) {
+	ring->fixedbuf = 1;
+    }
+    if ( syscall( __NR_io_uring_register, ring->ring_fd, IORING_REGISTER_FILES, &ring->sock, 1 ) == 0 ) {
+	ring->fixedfile = 1;
+    }
+    return 0;
+
+  fail:
+    saved_errno = errno;
+    IOUring_Destroy( ring );
+    errno = saved_errno;
+    return -1;
+}
+
+void IOUring_Destroy( IOUring *ring ) {
+    if ( ring->sqes != NULL ) {
+	munmap( ring->sqes, ring->sqes_sz );
+	ring->sqes = NULL;
+    }
+    if ( ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring ) {
+	munmap( ring->cq_ring, ring->cq_ring_sz );
+    }
+    ring->cq_ring = NULL;
+    if ( ring->sq_ring != NULL ) {
+	munmap( ring->sq_ring, ring->sq_ring_sz );
+	ring->sq_ring = NULL;
+    }
+    // closing the ring also drops the registered buffer and file
+    if ( ring->ring_fd >= 0 ) {
+	close( ring->ring_fd );
+	ring->ring_fd = -1;
+    }
+    if ( ring->buf != NULL ) {
+	free( ring->buf );
+	ring->buf = NULL;
+    }
+}
+
+/*
+ * Get the next free sqe, the tail is published immediately as
+ * the kernel only consumes entries from within io_uring_enter()
+ */
+static struct io_uring_sqe *IOUring_GetSqe( IOUring *ring, unsigned long long tag ) {
+    unsigned tail = *ring->sq_tail;
+    unsigned index;
+    struct io_uring_sqe *sqe;
+
+    if ( tail - __atomic_load_n( ring->sq_head, __ATOMIC_ACQUIRE ) >= ring->sq_entries ) {
+	// ring full, push what's queued to the kernel first
+	IOUring_Enter( ring, 0 );
+    }
+    index = tail & *ring->sq_mask;
+    sqe = &ring->sqes[index];
+    memset( sqe, 0, sizeof(struct io_uring_sqe) );
+    sqe->fd = -1;
+    sqe->user_data = tag;
+    ring->sq_array[index] = index;
+    __atomic_store_n( ring->sq_tail, tail + 1, __ATOMIC_RELEASE );
+    ring->sq_pending++;
+    ring->inflight++;
+    return sqe;
+}
+
+static void IOUring_PrepRW( IOUring *ring, int slot, int offset, int len, int fixed_op, int op, int flags ) {
+    struct io_uring_sqe *sqe = IOUring_GetSqe( ring, slot );
+    if ( ring->fixedfile ) {
+	sqe->fd = 0;
+	flags |= IOSQE_FIXED_FILE;
+    } else {
+	sqe->fd = ring->sock;
+    }
+    sqe->flags = flags;
+    sqe->addr = (unsigned long) (IOUring_Slot( ring, slot ) + offset);
+    sqe->len = len;
+    if ( ring->fixedbuf ) {
+	sqe->opcode = fixed_op;
+	sqe->buf_index = 0;
+    } else {
+	sqe->opcode = op;
+    }
+}
+
+void IOUring_PrepRead( IOUring *ring, int slot ) {
+    IOUring_PrepRW( ring, slot, 0, ring->buflen, IORING_OP_READ_FIXED, IORING_OP_RECV, 0 );
+}
+
+/*
+ * Writes len bytes of the slot starting at offset.  With link set
+ * the kernel won't start the next queued operation until this one
+ * completes in full; a short or failed write cancels the rest of
+ * the chain (-ECANCELED)
+ */
+void IOUring_PrepWrite( IOUring *ring, int slot, int offset, int len, int link ) {
+    IOUring_PrepRW( ring, slot, offset, len, IORING_OP_WRITE_FIXED, IORING_OP_SEND,
+		    (link ? IOSQE_IO_LINK : 0) );
+}
+
+// A timeout completes with -ETIME, used like SO_RCVTIMEO
+void IOUring_PrepTimeout( IOUring *ring, long usecs ) {
+    struct io_uring_sqe *sqe = IOUring_GetSqe( ring, IOURING_TAG_TIMEOUT );
+    ring->timeout.tv_sec = usecs / 1000000;
+    ring->timeout.tv_nsec = (usecs % 1000000) * 1000;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (unsigned long) &ring->timeout;
+    sqe->len = 1;
+}
+
+void IOUring_PrepCancel( IOUring *ring, int slot ) {
+    struct io_uring_sqe *sqe = IOUring_GetSqe( ring, IOURING_TAG_CANCEL | slot );
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = slot;
+}
+
+void IOUring_PrepCancelTimeout( IOUring *ring ) {
+    struct io_uring_sqe *sqe = IOUring_GetSqe( ring, IOURING_TAG_CANCEL | IOURING_TAG_TIMEOUT );
+    sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+    sqe->addr = IOURING_TAG_TIMEOUT;
+}
+
+int IOUring_Enter( IOUring *ring, int wait_nr ) {
+    int rc = (int) syscall( __NR_io_uring_enter, ring->ring_fd, ring->sq_pending, wait_nr,
+			    (wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0), NULL, 0 );
+    if ( rc < 0 ) {
+	return -1;
+    }
+    ring->sq_pending -= rc;
+    return rc;
+}
+
+int IOUring_Reap( IOUring *ring, unsigned *tag, int *res ) {
+    unsigned head = *ring->cq_head;
+    struct io_uring_cqe *cqe;
+
+    if ( head == __atomic_load_n( ring->cq_tail, __ATOMIC_ACQUIRE ) ) {
+	return 0;
+    }
+    cqe = &ring->cqes[head & *ring->cq_mask];
+    *tag = (unsigned) cqe->user_data;
+    *res = cqe->res;
+    __atomic_store_n( ring->cq_head, head + 1, __ATOMIC_RELEASE );
+    ring->inflight--;
+    return 1;
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+#endif // HAVE_LINUX_IO_URING_H
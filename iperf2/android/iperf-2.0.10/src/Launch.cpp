@@ -60,7 +60,27 @@
 #include "Listener.hpp"
 #include "Server.hpp"
 #include "PerfSocket.hpp"
+#include "Fanout.h"
 #include "lwip_adap.h"
+#ifdef HAVE_SCHED_SETSCHEDULER
+#include <sched.h>
+#endif
+
+/*
+ * Pin a traffic thread to the --affinity CPU, sched_setaffinity()
+ * with a zero pid applies to the calling thread only
+ */
+static void spawn_affinity( thread_Settings *thread ) {
+    if ( isAffinity( thread ) ) {
+#if HAVE_DECL_CPU_SET
+        cpu_set_t myset;
+        CPU_ZERO( &myset );
+        CPU_SET( thread->mAffinity, &myset );
+        WARN_errno( sched_setaffinity( 0, sizeof(myset), &myset ) != 0, "sched_setaffinity" );
+#endif
+    }
+}
+
 /*
  * listener_spawn is responsible for creating a Listener class
  * and launching the listener. It is provided as a means for
@@ -85,6 +105,7 @@ void listener_spawn( thread_Settings *thread ) {
 void server_spawn( thread_Settings *thread) {
     Server *theServer = NULL;
 
+    spawn_affinity( thread );
     // Start up the server
     theServer = new Server( thread );
 
@@ -105,6 +126,7 @@ void server_spawn( thread_Settings *thread) {
 void client_spawn( thread_Settings *thread ) {
     Client *theClient = NULL;
 
+    spawn_affinity( thread );
     //start up the client
     theClient = new Client( thread );
 
@@ -131,15 +153,24 @@ void client_init( thread_Settings *clients ) {
     setReport( clients );
     itr = clients;
 
+    if ( isFanout( clients ) ) {
+        Fanout_Init( clients );
+        return;
+    }
+
     // See if we need to start a listener as well
     Settings_GenerateListenerSettings( clients, &next );
 
     // Create a multiple report header to handle reporting the
-    // sum of multiple client threads
-    Mutex_Lock( &groupCond );
-    groupID--;
-    clients->multihdr = InitMulti( clients, groupID );
-    Mutex_Unlock( &groupCond );
+    // sum of multiple client threads, a --sweep step that runs
+    // fewer streams would never pass its barrier so the sweep
+    // sums its steps itself
+    if ( !isSweep( clients ) ) {
+        Mutex_Lock( &groupCond );
+        groupID--;
+        clients->multihdr = InitMulti( clients, groupID );
+        Mutex_Unlock( &groupCond );
+    }
 
 #ifdef HAVE_THREAD
     if ( next != NULL ) {
@@ -91,6 +91,11 @@ Listener::Listener( thread_Settings *inSettings ) {
 
     mClients = inSettings->mThreads;
     mBuf = NULL;
+#ifdef HAVE_NET_NETMAP_USER_H
+    mNetmap = NULL;
+#endif
+    mJoined = 0;
+    mClosing = 0;
     /*
      * These thread settings are stored in three places
      *
@@ -134,6 +139,9 @@ Listener::~Listener() {
         WARN_errno( rc == SOCKET_ERROR, "close" );
         mSettings->mSock = INVALID_SOCKET;
     }
+#ifdef HAVE_NET_NETMAP_USER_H
+    Netmap_Close( mNetmap );
+#endif
     DELETE_ARRAY( mBuf );
 } // end ~Listener
 
@@ -144,6 +152,10 @@ Listener::~Listener() {
  *          spawn a new Server thread.
  * ------------------------------------------------------------------- */
 void Listener::Run( void ) {
+    if ( isMcastGroups( mSettings ) ) {
+        McastGroupsServer( );
+        return;
+    }
 #if 0 // ifdef WIN32 removed to allow Windows to use multi-threaded UDP server
     if ( isUDP( mSettings ) && !isSingleUDP( mSettings ) ) {
         UDPSingleServer();
@@ -173,6 +185,14 @@ void Listener::Run( void ) {
             client = true;
             SockAddr_remoteAddr( mSettings );
         }
+#ifdef HAVE_NET_NETMAP_USER_H
+        if ( UDP && isNetmap( mSettings ) ) {
+            mNetmap = Netmap_Open( mSettings->mNetmapPort );
+            if ( mNetmap == NULL ) {
+                unsetNetmap( mSettings );
+            }
+        }
+#endif
         Settings_Copy( mSettings, &server );
         server->mThreadMode = kMode_Server;
 
@@ -280,6 +300,20 @@ sInterupted == SIGALRM
             Mutex_Unlock( &clients_mutex );
 
             // Start the server
+#ifdef HAVE_NET_NETMAP_USER_H
+            if ( server->mNetmap != NULL ) {
+                // the test owns the RX rings until it ends, so run it
+                // in this thread and pick up the next one afterwards
+                if ( server->runNow != NULL ) {
+                    thread_start( server->runNow );
+                }
+                server_spawn( server );
+                if ( server->runNext != NULL ) {
+                    thread_start( server->runNext );
+                }
+                Settings_Destroy( server );
+            } else
+#endif
 #if defined(WIN32) && defined(HAVE_THREAD)
             if ( UDP ) {
                 // WIN32 does bad UDP handling so run single threaded
@@ -375,8 +409,10 @@ void Listener::Listen( ) {
     }
 
 #ifndef WIN32
-    // if multicast, join the group
-    if ( SockAddr_isMulticast( &mSettings->local ) ) {
+    // if multicast, join the group, or the --mcast-groups channels
+    if ( isMcastGroups( mSettings ) ) {
+        McastGroupsJoin( );
+    } else if ( SockAddr_isMulticast( &mSettings->local ) ) {
         McastJoin( );
     }
 #endif
@@ -418,6 +454,130 @@ void Listener::McastJoin( ) {
 }
 // end McastJoin
 
+/* -------------------------------------------------------------------
+ * Joins one --mcast-groups channel on sock, with the default
+ * interface, an SSM channel by its source and group.
+ * ------------------------------------------------------------------- */
+
+static int mcast_join( int sock, McastChannel *channel ) {
+    int rc = SOCKET_ERROR;
+#ifdef HAVE_MULTICAST
+    if ( !SockAddr_isIPv6( &channel->group ) ) {
+        if ( !channel->ssm ) {
+            struct ip_mreq mreq;
+
+            memcpy( &mreq.imr_multiaddr, SockAddr_get_in_addr( &channel->group ),
+                    sizeof(mreq.imr_multiaddr));
+            mreq.imr_interface.s_addr = htonl( INADDR_ANY );
+            rc = setsockopt( sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*) &mreq, sizeof(mreq));
+        } else {
+#if HAVE_DECL_IP_ADD_SOURCE_MEMBERSHIP
+            struct ip_mreq_source mreq;
+
+            memcpy( &mreq.imr_multiaddr, SockAddr_get_in_addr( &channel->group ),
+                    sizeof(mreq.imr_multiaddr));
+            memcpy( &mreq.imr_sourceaddr, SockAddr_get_in_addr( &channel->source ),
+                    sizeof(mreq.imr_sourceaddr));
+            mreq.imr_interface.s_addr = htonl( INADDR_ANY );
+            rc = setsockopt( sock, IPPROTO_IP, IP_ADD_SOURCE_MEMBERSHIP, (char*) &mreq, sizeof(mreq));
+#else
+            errno = ENOPROTOOPT;
+#endif
+        }
+    }
+#ifdef HAVE_IPV6_MULTICAST
+      else if ( !channel->ssm ) {
+        struct ipv6_mreq mreq;
+
+        memcpy( &mreq.ipv6mr_multiaddr, SockAddr_get_in6_addr( &channel->group ),
+                sizeof(mreq.ipv6mr_multiaddr));
+        mreq.ipv6mr_interface = 0;
+        rc = setsockopt( sock, IPPROTO_IPV6, IPV6_ADD_MEMBERSHIP, (char*) &mreq, sizeof(mreq));
+    } else {
+#if HAVE_DECL_MCAST_JOIN_SOURCE_GROUP
+        // MLDv2, the protocol independent source filter API
+        struct group_source_req gsr;
+
+        memset( &gsr, 0, sizeof(gsr));
+        gsr.gsr_interface = 0;
+        memcpy( &gsr.gsr_group, &channel->group, sizeof(struct sockaddr_in6));
+        memcpy( &gsr.gsr_source, &channel->source, sizeof(struct sockaddr_in6));
+        rc = setsockopt( sock, IPPROTO_IPV6, MCAST_JOIN_SOURCE_GROUP, (char*) &gsr, sizeof(gsr));
+#else
+        errno = ENOPROTOOPT;
+#endif
+    }
+#endif
+#endif
+    return rc;
+}
+
+/* -------------------------------------------------------------------
+ * Joins the --mcast-groups channels on mSock, from the first one not
+ * tried yet.  A socket only holds so many memberships (Linux's
+ * net.ipv4.igmp_max_memberships, 20 by default), a join refused with
+ * ENOBUFS leaves the rest for the next socket.  Returns the number
+ * of channels joined.
+ * ------------------------------------------------------------------- */
+
+int Listener::McastGroupsJoin( ) {
+    int joined = 0;
+    int on = 1;
+    int rc;
+    char name[REPORT_ADDRLEN * 2 + 2];
+    bool v6 = SockAddr_isIPv6( &mSettings->local );
+
+    // each datagram's group comes with its packet info, the
+    // arrival time with its timestamp
+    if ( !v6 ) {
+#if HAVE_DECL_IP_PKTINFO
+        rc = setsockopt( mSettings->mSock, IPPROTO_IP, IP_PKTINFO, (char*) &on, sizeof(on));
+        WARN_errno( rc == SOCKET_ERROR, "IP_PKTINFO" );
+#endif
+#ifdef IP_MULTICAST_ALL
+        // only the groups joined on this very socket
+        int off = 0;
+        rc = setsockopt( mSettings->mSock, IPPROTO_IP, IP_MULTICAST_ALL, (char*) &off, sizeof(off));
+        WARN_errno( rc == SOCKET_ERROR, "IP_MULTICAST_ALL" );
+#endif
+    } else {
+#if HAVE_DECL_IPV6_RECVPKTINFO
+        rc = setsockopt( mSettings->mSock, IPPROTO_IPV6, IPV6_RECVPKTINFO, (char*) &on, sizeof(on));
+        WARN_errno( rc == SOCKET_ERROR, "IPV6_RECVPKTINFO" );
+#endif
+#ifdef IPV6_MULTICAST_ALL
+        int off = 0;
+        rc = setsockopt( mSettings->mSock, IPPROTO_IPV6, IPV6_MULTICAST_ALL, (char*) &off, sizeof(off));
+        WARN_errno( rc == SOCKET_ERROR, "IPV6_MULTICAST_ALL" );
+#endif
+    }
+#if HAVE_DECL_SO_TIMESTAMP
+    rc = setsockopt( mSettings->mSock, SOL_SOCKET, SO_TIMESTAMP, (char*) &on, sizeof(on));
+    WARN_errno( rc == SOCKET_ERROR, "SO_TIMESTAMP" );
+#endif
+    for ( ; mJoined < McastGroups_Count( ); mJoined++ ) {
+        McastChannel *channel = McastGroups_Channel( mJoined );
+
+        if ( SockAddr_isIPv6( &channel->group ) != v6 ) {
+            McastGroups_Name( channel, name, sizeof(name) );
+            fprintf( stderr, warn_mcast_family, name );
+            continue;
+        }
+        if ( mcast_join( mSettings->mSock, channel ) == SOCKET_ERROR ) {
+            if ( errno == ENOBUFS && joined > 0 ) {
+                break;
+            }
+            McastGroups_Name( channel, name, sizeof(name) );
+            fprintf( stderr, warn_mcast_join, name, strerror( errno ) );
+            continue;
+        }
+        channel->sock = mSettings->mSock;
+        joined++;
+    }
+    return joined;
+}
+// end McastGroupsJoin
+
 /* -------------------------------------------------------------------
  * Sets the Multicast TTL for outgoing packets.
  * ------------------------------------------------------------------- */
@@ -471,13 +631,39 @@ void Listener::Accept( thread_Settings *server ) {
 	    struct timeval timeout;
 	    timeout.tv_sec = mSettings->mAmount / 100;
 	    timeout.tv_usec = (mSettings->mAmount % 100) * 10000;
+	    int fd = mSettings->mSock;
+#ifdef HAVE_NET_NETMAP_USER_H
+	    if ( mNetmap != NULL ) {
+		fd = mNetmap->fd;
+	    }
+#endif
 	    fd_set set;
 	    FD_ZERO(&set);
-	    FD_SET(mSettings->mSock, &set);
-	    if (select( mSettings->mSock + 1, &set, NULL, NULL, &timeout) <= 0) {
+	    FD_SET(fd, &set);
+	    if (select( fd + 1, &set, NULL, NULL, &timeout) <= 0) {
 		break;
 	    }
 	}
+#ifdef HAVE_NET_NETMAP_USER_H
+	if ( isUDP( server ) && mNetmap != NULL ) {
+	    /* ------------------------------------------------------------------------
+	     * The test's datagrams bypass the socket, wait for the first one
+	     * on the netmap port.  The bound socket is handed over only to be
+	     * closed by the server.
+	     * ------------------------------------------------------------------- ----*/
+	    int rc = Netmap_RxAccept( mNetmap, mSettings->mPort, mBuf, mSettings->mBufLen,
+				      &server->peer, &server->local );
+	    if ( rc < 0 ) {
+		WARN_errno( errno != EINTR, "netmap poll" );
+		break;
+	    }
+	    server->size_peer = sizeof(struct sockaddr_in);
+	    server->size_local = sizeof(struct sockaddr_in);
+	    server->mSock = mSettings->mSock;
+	    server->mNetmap = mNetmap;
+	    continue;
+	}
+#endif
 	if ( isUDP( server ) ) {
 	    /* ------------------------------------------------------------------------
 	     * Do the equivalent of an accept() call for UDP sockets. This waits
@@ -524,6 +710,12 @@ void Listener::Accept( thread_Settings *server ) {
 	    WARN(1, "Failed setting socket to blocking mode");
 	}
     }
+#ifdef HAVE_NET_NETMAP_USER_H
+    // the local address came with the datagram
+    if ( server->mNetmap != NULL ) {
+	return;
+    }
+#endif
     server->size_local = sizeof(iperf_sockaddr);
     getsockname( server->mSock, (sockaddr*) &server->local, &server->size_local );
 } // end Accept
@@ -637,18 +829,7 @@ void Listener::UDPSingleServer( ) {
                         Transfer_Info *stats = GetReport( exist->server->reporthdr );
                         hdr = (server_hdr*) (UDP_Hdr+1);
 
-                        hdr->base.flags        = htonl( HEADER_VERSION1 );
-                        hdr->base.total_len1   = htonl( (long) (stats->TotalLen >> 32) );
-                        hdr->base.total_len2   = htonl( (long) (stats->TotalLen & 0xFFFFFFFF) );
-                        hdr->base.stop_sec     = htonl( (long) stats->endTime );
-                        hdr->base.stop_usec    = htonl( (long)((stats->endTime - (long)stats->endTime) \
-                                                          * rMillion));
-                        hdr->base.error_cnt    = htonl( stats->cntError );
-                        hdr->base.outorder_cnt = htonl( stats->cntOutofOrder );
-                        hdr->base.datagrams    = htonl( stats->cntDatagrams );
-                        hdr->base.jitter1      = htonl( (long) stats->jitter );
-                        hdr->base.jitter2      = htonl( (long) ((stats->jitter - (long)stats->jitter) \
-                                                           * rMillion) );
+                        EncodeServerHdr( stats, hdr, HEADER_VERSION1 );
                     }
                     EndReport( exist->server->reporthdr );
                     exist->server->reporthdr = NULL;
@@ -757,8 +938,329 @@ void Listener::UDPSingleServer( ) {
     Settings_Destroy( server );
 }
 
+#ifdef HAVE_RECVMMSG
+typedef struct mmsghdr iperf_mmsghdr;
+#else
+// without recvmmsg() the datagrams are read one recvmsg() at a time,
+// glibc may still declare struct mmsghdr so the fallback has its own name
+typedef struct iperf_mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+} iperf_mmsghdr;
+#endif
+
+static int mcast_recv( int sock, iperf_mmsghdr *msgs, int batch ) {
+#ifdef HAVE_RECVMMSG
+    return recvmmsg( sock, msgs, batch, MSG_DONTWAIT, NULL );
+#else
+    int rc = recvmsg( sock, &msgs[0].msg_hdr, MSG_DONTWAIT );
+    if ( rc < 0 ) {
+        return rc;
+    }
+    msgs[0].msg_len = rc;
+    return 1;
+#endif
+}
+
+/* -------------------------------------------------------------------
+ * Receives the --mcast-groups channels, all of them in this thread.
+ * Each readable socket gives up a batch of datagrams per call and
+ * each datagram goes to its channel's report.  A channel's stream
+ * starts with its first datagram and ends with the FIN, the channel
+ * then waits for the next stream.  The reporter thread does the per
+ * channel accounting, as it does for the UDP servers.
+ * ------------------------------------------------------------------- */
+
+void Listener::McastGroupsServer( ) {
+    int socks[MCASTGROUPS_MAX_SOCKETS];
+    int nsocks = 0;
+    int count = McastGroups_Count( );
+    int joined = 0;
+    int batch = MCASTGROUPS_BATCH;
+    int buflen = mSettings->mBufLen;
+    // room for the packet info and the timestamp
+    const int ctrllen = 128;
+    bool mMode_Time = isServerModeTime( mSettings ) && !isDaemon( mSettings );
+    struct timeval tick, nextTick, now;
+
+    // spread the channels the first socket couldn't take over more
+    socks[nsocks++] = mSettings->mSock;
+    while ( mJoined < count && nsocks < MCASTGROUPS_MAX_SOCKETS ) {
+        mSettings->mSock = INVALID_SOCKET;
+        Listen( );
+        socks[nsocks++] = mSettings->mSock;
+    }
+    mSettings->mSock = socks[0];
+    for ( int i = 0; i < count; i++ ) {
+        if ( McastGroups_Channel( i )->sock != INVALID_SOCKET ) {
+            joined++;
+        }
+    }
+    printf( report_mcast_joined, joined, count, nsocks );
+    fflush( stdout );
+
+#ifndef HAVE_RECVMMSG
+    batch = 1;
+#endif
+    char *bufs = new char[batch * buflen];
+    char *ctrl = new char[batch * ctrllen];
+    iperf_sockaddr *peers = new iperf_sockaddr[batch];
+    struct iovec *iov = new struct iovec[batch];
+    iperf_mmsghdr *msgs = new iperf_mmsghdr[batch];
+    ReportStruct *reportstruct = new ReportStruct;
+    memset( reportstruct, 0, sizeof(ReportStruct) );
+    memset( msgs, 0, batch * sizeof(iperf_mmsghdr) );
+    for ( int i = 0; i < batch; i++ ) {
+        iov[i].iov_base = bufs + i * buflen;
+        iov[i].iov_len = buflen;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &peers[i];
+    }
+
+    // silent channels get an empty report every interval so their
+    // interval reports, and losses, still come out
+    if ( mSettings->mInterval > 0.0 ) {
+        tick.tv_sec = (long) mSettings->mInterval;
+        tick.tv_usec = (long) ((mSettings->mInterval - tick.tv_sec) * rMillion);
+    } else {
+        tick.tv_sec = 1;
+        tick.tv_usec = 0;
+    }
+    gettimeofday( &nextTick, NULL );
+    TimeAdd( nextTick, tick );
+    if ( mMode_Time ) {
+        mEndTime.setnow();
+        mEndTime.add( mSettings->mAmount / 100.0 );
+    }
+
+    while ( sInterupted == 0 ) {
+        fd_set set;
+        int maxfd = 0;
+        struct timeval timeout = tick;
+
+        FD_ZERO( &set );
+        for ( int s = 0; s < nsocks; s++ ) {
+            FD_SET( socks[s], &set );
+            if ( socks[s] > maxfd ) {
+                maxfd = socks[s];
+            }
+        }
+        int rc = select( maxfd + 1, &set, NULL, NULL, &timeout );
+        if ( rc == SOCKET_ERROR ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            WARN_errno( 1, "select" );
+            break;
+        }
+        for ( int s = 0; rc > 0 && s < nsocks; s++ ) {
+            if ( !FD_ISSET( socks[s], &set ) ) {
+                continue;
+            }
+            for ( int i = 0; i < batch; i++ ) {
+                msgs[i].msg_hdr.msg_namelen = sizeof(iperf_sockaddr);
+                msgs[i].msg_hdr.msg_control = ctrl + i * ctrllen;
+                msgs[i].msg_hdr.msg_controllen = ctrllen;
+            }
+            int n = mcast_recv( socks[s], msgs, batch );
+            if ( n < 0 ) {
+                WARN_errno( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR, "recvmmsg" );
+                continue;
+            }
+            // the time for datagrams without a timestamp
+            gettimeofday( &now, NULL );
+            for ( int i = 0; i < n; i++ ) {
+                McastGroupsDatagram( &msgs[i].msg_hdr, msgs[i].msg_len, &now, reportstruct );
+            }
+        }
+
+        gettimeofday( &now, NULL );
+        if ( mMode_Time && mEndTime.before( now ) ) {
+            break;
+        }
+        if ( mClosing > 0 ) {
+            // the reporter is done with the streams it has the final
+            // report of, so ending them here won't block
+            for ( int i = 0; i < count && mClosing > 0; i++ ) {
+                McastChannel *channel = McastGroups_Channel( i );
+                if ( channel->closing &&
+                     (channel->server->reporthdr == NULL ||
+                      channel->server->reporthdr->reporterindex == -1) ) {
+                    McastGroupsEnd( channel, reportstruct );
+                }
+            }
+        }
+        if ( mSettings->mInterval > 0.0 && TimeDifference( now, nextTick ) >= 0.0 ) {
+            reportstruct->emptyreport = 1;
+            reportstruct->packetID = 0;
+            reportstruct->packetLen = 0;
+            reportstruct->packetTime = now;
+            for ( int i = 0; i < count; i++ ) {
+                McastChannel *channel = McastGroups_Channel( i );
+                if ( channel->server != NULL && !channel->closing ) {
+                    ReportPacket( channel->server->reporthdr, reportstruct );
+                }
+            }
+            reportstruct->emptyreport = 0;
+            TimeAdd( nextTick, tick );
+            if ( TimeDifference( now, nextTick ) >= 0.0 ) {
+                nextTick = now;
+                TimeAdd( nextTick, tick );
+            }
+        }
+    }
+
+    // end the streams still running
+    gettimeofday( &reportstruct->packetTime, NULL );
+    for ( int i = 0; i < count; i++ ) {
+        McastChannel *channel = McastGroups_Channel( i );
+        if ( channel->server != NULL ) {
+            McastGroupsEnd( channel, reportstruct );
+        }
+        if ( channel->stray > 0 ) {
+            char name[REPORT_ADDRLEN * 2 + 2];
+            McastGroups_Name( channel, name, sizeof(name) );
+            fprintf( stderr, warn_mcast_stray, name, channel->stray );
+        }
+    }
+    for ( int s = 1; s < nsocks; s++ ) {
+        int rc = close( socks[s] );
+        WARN_errno( rc == SOCKET_ERROR, "close" );
+    }
+    DELETE_PTR( reportstruct );
+    DELETE_ARRAY( msgs );
+    DELETE_ARRAY( iov );
+    DELETE_ARRAY( peers );
+    DELETE_ARRAY( ctrl );
+    DELETE_ARRAY( bufs );
+}
+// end McastGroupsServer
+
+/* -------------------------------------------------------------------
+ * Hands a --mcast-groups datagram to its channel's report, the
+ * channel found from the destination address and the sender.
+ * Datagrams for no channel, say unicast ones to the port, are
+ * dropped, as are an any source channel's from a second sender while
+ * a stream runs.
+ * ------------------------------------------------------------------- */
+
+void Listener::McastGroupsDatagram( struct msghdr *msg, int len, struct timeval *now,
+                                    ReportStruct *reportstruct ) {
+    iperf_sockaddr group;
+    iperf_sockaddr *peer = (iperf_sockaddr*) msg->msg_name;
+    UDP_datagram *mBuf_UDP = (UDP_datagram*) msg->msg_iov->iov_base;
+    struct cmsghdr *cmsg;
+    McastChannel *channel;
+    bool fin;
+
+    memset( &group, 0, sizeof(group) );
+    reportstruct->packetTime = *now;
+    for ( cmsg = CMSG_FIRSTHDR( msg ); cmsg != NULL; cmsg = CMSG_NXTHDR( msg, cmsg ) ) {
+#if HAVE_DECL_IP_PKTINFO
+        if ( cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO ) {
+            struct in_pktinfo *info = (struct in_pktinfo*) CMSG_DATA( cmsg );
+            ((struct sockaddr*) &group)->sa_family = AF_INET;
+            ((struct sockaddr_in*) &group)->sin_addr = info->ipi_addr;
+        }
+#endif
+#if HAVE_DECL_IPV6_RECVPKTINFO
+        if ( cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO ) {
+            struct in6_pktinfo *info = (struct in6_pktinfo*) CMSG_DATA( cmsg );
+            ((struct sockaddr*) &group)->sa_family = AF_INET6;
+            ((struct sockaddr_in6*) &group)->sin6_addr = info->ipi6_addr;
+        }
+#endif
+#if HAVE_DECL_SO_TIMESTAMP
+        if ( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP &&
+             cmsg->cmsg_len == CMSG_LEN(sizeof(struct timeval)) ) {
+            memcpy( &reportstruct->packetTime, CMSG_DATA( cmsg ), sizeof(struct timeval) );
+        }
+#endif
+    }
+    if ( ((struct sockaddr*) &group)->sa_family == 0 || len < (int) sizeof(UDP_datagram) ||
+         (channel = McastGroups_Lookup( &group, peer )) == NULL ) {
+        return;
+    }
+
+    // the datagram ID, negative for the FIN
+    if ( isSeqNo64b( mSettings ) ) {
+        reportstruct->packetID = (((max_size_t) (ntohl(mBuf_UDP->id2)) << 32) | ntohl(mBuf_UDP->id));
+        fin = (reportstruct->packetID & 0x8000000000000000LL) != 0;
+        reportstruct->packetID &= 0x7FFFFFFFFFFFFFFFLL;
+    } else {
+        reportstruct->packetID = ntohl( mBuf_UDP->id );
+        fin = (reportstruct->packetID & 0x80000000L) != 0;
+        reportstruct->packetID &= 0x7FFFFFFFL;
+    }
+
+    if ( channel->server != NULL && channel->closing ) {
+        if ( fin ) {
+            return;
+        }
+        // the next stream came before the reporter was done with the last
+        McastGroupsEnd( channel, reportstruct );
+    }
+    if ( channel->server == NULL ) {
+        // the tail end of a stream this server didn't see start
+        if ( fin ) {
+            return;
+        }
+        // like a UDP server's first datagram, it isn't counted, the
+        // client counts its FIN instead
+        McastGroupsStart( channel, peer, msg->msg_namelen );
+        return;
+    } else if ( !SockAddr_are_Equal( (struct sockaddr*) peer, (struct sockaddr*) &channel->server->peer ) ) {
+        channel->stray++;
+        return;
+    }
+
+    reportstruct->sentTime.tv_sec = ntohl( mBuf_UDP->tv_sec );
+    reportstruct->sentTime.tv_usec = ntohl( mBuf_UDP->tv_usec );
+    reportstruct->packetLen = len;
+    ReportPacket( channel->server->reporthdr, reportstruct );
+    if ( fin ) {
+        CloseReport( channel->server->reporthdr, reportstruct );
+        channel->closing = 1;
+        mClosing++;
+    }
+}
+// end McastGroupsDatagram
+
+void Listener::McastGroupsStart( McastChannel *channel, iperf_sockaddr *peer, Socklen_t size_peer ) {
+    thread_Settings *stream = NULL;
+
+    Settings_Copy( mSettings, &stream );
+    stream->mThreadMode = kMode_Server;
+    stream->peer = *peer;
+    stream->size_peer = size_peer;
+    stream->local = channel->group;
+    SockAddr_setPort( &stream->local, mSettings->mPort );
+    stream->size_local = SockAddr_get_sizeof_sockaddr( &stream->local );
+    // the transfer ID, there's no socket of its own
+    Mutex_Lock( &groupCond );
+    groupID--;
+    stream->mSock = -groupID;
+    Mutex_Unlock( &groupCond );
+    stream->reporthdr = InitReport( stream );
+    channel->server = stream;
+}
+
+void Listener::McastGroupsEnd( McastChannel *channel, ReportStruct *reportstruct ) {
+    if ( channel->closing ) {
+        channel->closing = 0;
+        mClosing--;
+    } else {
+        CloseReport( channel->server->reporthdr, reportstruct );
+    }
+    EndReport( channel->server->reporthdr );
+    Settings_Destroy( channel->server );
+    channel->server = NULL;
+}
+
 int Listener::ReadClientHeader(client_hdr *hdr ) {
     int flags = 0;
+    int peeklen = 0;
     if (isUDP(mSettings)) {
 	flags = ntohl(hdr->base.flags);
     } else {
@@ -803,23 +1305,48 @@ int Listener::ReadClientHeader(client_hdr *hdr ) {
 		flags = 0;
 		return -1;
 	    }
+	    peeklen = len;
 	}
     }
     if ((flags & HEADER_EXTEND) != 0 ) {
+	int clocksync = (ntohl(hdr->extend.flags) & CLOCKSYNC) != 0;
 	reporter_peerversion(server, ntohl(hdr->extend.version_u), ntohl(hdr->extend.version_l));
+	if (clocksync && SockAddr_Hostare_Equal((sockaddr*) &server->local, (sockaddr*) &server->peer)) {
+	    // same host, both ends read the same clock
+	    clocksync = 0;
+	    server->mClockOffset = 0;
+	    strncat(server->peerversion, report_clocksync_local,
+		    sizeof(server->peerversion) - strlen(server->peerversion) - 1);
+	}
 	//  Extended header successfully read. Ack the client with our version info now
-	ClientHeaderAck();
+	ClientHeaderAck(clocksync ? CLOCKSYNC : 0);
+	if (clocksync) {
+	    peeklen += ClockSync(peeklen) * sizeof(clock_sync_msg);
+	}
+	if (!isUDP(server) && (ntohl(hdr->extend.flags) & WRITELATENCY) != 0) {
+	    // the stamped writes follow the peeked messages in the stream
+	    setWriteLatency(server);
+	    server->mStampOffset = peeklen;
+	}
+	if ((ntohl(hdr->extend.flags) & PAYLOAD) != 0) {
+	    int payload = ntohl(hdr->extend.mPayload);
+	    setPayload(server);
+	    server->mPayload = (payload >> 24) & 0xff;
+	    server->mPayloadRatio = (payload & 0xffffff) / 100.0;
+	    // a TCP payload follows the peeked messages in the stream
+	    server->mPayloadOffset = isUDP(server) ? 0 : peeklen;
+	}
     }
     return 1;
 }
 
-int Listener::ClientHeaderAck(void) {
+int Listener::ClientHeaderAck(int ackflags) {
     client_hdr_ack ack;
     int sotimer = 0;
     int optflag;
     ack.typelen.type  = htonl(CLIENTHDRACK);
     ack.typelen.length = htonl(sizeof(client_hdr_ack));
-    ack.flags = 0;
+    ack.flags = htonl(ackflags);
     ack.reserved1 = 0;
     ack.reserved2 = 0;
     ack.version_u = htonl(IPERF_VERSION_MAJORHEX);
@@ -871,3 +1398,86 @@ int Listener::ClientHeaderAck(void) {
     }
     return rc;
 }
+
+/* -------------------------------------------------------------------
+ * Estimate the client's clock offset for the latency calculations
+ * (--clock-sync).  Run CLOCKSYNC_PINGS NTP style exchanges right
+ * after the header ack and keep the offset from the one with the
+ * smallest round trip, i.e. the least queueing.  Any timeout ends
+ * the exchange, the client gives up on its side the same way.
+ *
+ * TCP replies are peeked, like the client header, so the server
+ * thread still reads them as part of the traffic.  Returns the
+ * number of replies read.
+ * ------------------------------------------------------------------- */
+int Listener::ClockSync(int peeklen) {
+    clock_sync_msg msg;
+    struct timeval t1, t2, t3, t4;
+    double delay, offset = 0, best = -1;
+    int ix, n, rc, want;
+    char *peekbuf = NULL;
+#ifdef WIN32
+    DWORD timeout = CLOCKSYNC_TIMEOUT / 1000;
+#else
+    struct timeval timeout;
+    timeout.tv_sec = CLOCKSYNC_TIMEOUT / 1000000;
+    timeout.tv_usec = CLOCKSYNC_TIMEOUT % 1000000;
+#endif
+    if ((rc = setsockopt( server->mSock, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout))) < 0 ) {
+	WARN_errno( rc < 0, "setsockopt SO_RCVTIMEO");
+    }
+    if (!isUDP(server)) {
+	peekbuf = new char[peeklen + CLOCKSYNC_PINGS * sizeof(clock_sync_msg)];
+    }
+    for (ix = 0; ix < CLOCKSYNC_PINGS; ix++) {
+	memset(&msg, 0, sizeof(msg));
+	msg.typelen.type = htonl(CLOCKSYNCMSG);
+	msg.typelen.length = htonl(sizeof(clock_sync_msg));
+	msg.seqno = htonl(ix);
+	gettimeofday(&t1, NULL);
+	msg.t1_sec = htonl(t1.tv_sec);
+	msg.t1_usec = htonl(t1.tv_usec);
+	if (send(server->mSock, (const char*)&msg, sizeof(msg), 0) != sizeof(msg)) {
+	    WARN_errno(1, "send clock sync");
+	    break;
+	}
+	if (isUDP(server)) {
+	    n = recv(server->mSock, (char *)&msg, sizeof(msg), 0);
+	} else {
+	    want = peeklen + (ix + 1) * sizeof(msg);
+	    n = recv(server->mSock, peekbuf, want, MSG_PEEK | MSG_WAITALL);
+	    if (n == want) {
+		memcpy(&msg, peekbuf + want - sizeof(msg), sizeof(msg));
+		n = sizeof(msg);
+	    }
+	}
+	gettimeofday(&t4, NULL);
+	if (n != sizeof(msg) || ntohl(msg.typelen.type) != CLOCKSYNCMSG || (int) ntohl(msg.seqno) != ix) {
+	    break;
+	}
+	t2.tv_sec = ntohl(msg.t2_sec);
+	t2.tv_usec = ntohl(msg.t2_usec);
+	t3.tv_sec = ntohl(msg.t3_sec);
+	t3.tv_usec = ntohl(msg.t3_usec);
+	delay = TimeDifference(t4, t1) - TimeDifference(t3, t2);
+	if (best < 0 || delay < best) {
+	    best = delay;
+	    offset = (TimeDifference(t2, t1) + TimeDifference(t3, t4)) / 2;
+	}
+    }
+    DELETE_ARRAY(peekbuf);
+    // back to the blocking reads the server thread expects
+    memset(&timeout, 0, sizeof(timeout));
+    if ((rc = setsockopt( server->mSock, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout))) < 0 ) {
+	WARN_errno( rc < 0, "setsockopt SO_RCVTIMEO");
+    }
+    if (best < 0) {
+	fprintf(stderr, warn_clocksync_failed, server->mSock);
+	return ix;
+    }
+    server->mClockOffset = offset;
+    n = strlen(server->peerversion);
+    snprintf(server->peerversion + n, sizeof(server->peerversion) - n, report_clocksync,
+	     offset * 1e3, best * 1e3, ix);
+    return ix;
+}
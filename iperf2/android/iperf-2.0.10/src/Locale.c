@@ -59,6 +59,7 @@
 #include "config.win32.h"
 #endif
 #endif
+#include "headers.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -88,10 +89,26 @@ Client/Server:\n\
 #ifdef HAVE_SEQNO64b
 "      --udp-counters-64bit use 64 bit sequence numbers with UDP\n"
 #endif
+#ifdef HAVE_LINUX_IO_URING_H
+"      --io-uring[=#]       use io_uring for socket reads/writes keeping # in flight (default 8)\n"
+#endif
+"      --time-buckets[=#]   count traffic in # usec buckets (default 100) and print them at the end\n"
+#ifdef HAVE_NET_NETMAP_USER_H
+"      --netmap <port>      send or receive UDP through a netmap port, e.g. netmap:eth0 or vale0:p1\n"
+"                           (a client may append ,<dst mac>, default broadcast)\n"
+#endif
+"      --stats-shm <file>   publish running stream totals to <file> (in /dev/shm if no path)\n"
+"      --cpu                report each stream's and the reporter's CPU use, and cycles where perf allows\n"
+"      --report-depth #     packet events each stream can queue for the reporter (default 10000)\n"
+"      --warmup #[kmgKMG]   leave the first # secs, or # bytes if given a k/m/g suffix, out of each\n"
+"                           stream's final report\n"
 "  -w, --window    #[KM]    TCP window size (socket buffer size)\n"
 #ifdef HAVE_SCHED_SETSCHEDULER
 "  -z, --realtime           request realtime scheduler\n"
 #endif
+#if HAVE_DECL_CPU_SET
+"      --affinity #         pin the traffic threads to CPU #\n"
+#endif
 "  -B, --bind      <host>   bind to <host>, an interface or multicast address\n\
   -C, --compatibility      for use with older versions does not sent extra msgs\n\
   -M, --mss       #        set TCP maximum segment size (MTU - 40 bytes)\n\
@@ -107,6 +124,16 @@ Server specific:\n\
 "  -R, --remove             remove service in win32\n"
 #endif
 "  -V, --ipv6_domain        Enable IPv6 reception by setting the domain and socket to AF_INET6 (Can receive on both IPv4 and IPv6)\n"
+"      --recv-mode <mode>   TCP read mode: normal, waitall, lowat[:#], adaptive (adds a log2 read size histogram)\n"
+"      --reorder-window[=#] UDP, track the last # datagram IDs (default 64K, max 16M) to tell late datagrams\n"
+"                           from duplicates, with a log2 reorder distance histogram\n"
+"      --mcast-groups <list> UDP, join every group or SSM source@group in a file or comma separated\n"
+"                           list, reporting each channel without a thread per channel\n"
+#if HAVE_DECL_SO_BUSY_POLL
+"      --busy-poll[=#[:#]]  spin on non-blocking reads with SO_BUSY_POLL # usecs (default 50), blocking\n"
+"                           after :# usecs of empty reads (default never), best with -z and --affinity\n"
+#endif
+"      --verify             check a --payload client's data byte for byte and count the corrupted bytes\n"
 ;
 
 const char usage_long2[] = "\
@@ -125,10 +152,26 @@ Client specific:\n\
 #ifndef WIN32
 "  -R, --reverse            reverse the test (client receives, server sends)\n"
 #endif
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+"      --tcp-sample[=#]     sample TCP_INFO every # usecs (default 1000) and print the time series at the end\n"
+#endif
+"      --aggregate          with -i and TCP, report the writes once per interval instead of per write\n"
+"      --targets <list>     test every host in a file (one per line) or an a.b.c.d/n range, -P streams each\n"
+"      --fanout #           streams running at once with --targets (default 64)\n"
 "  -T, --ttl       #        time-to-live, for multicast (default 1)\n\
   -V, --ipv6_domain        Set the domain to IPv6 (send packets over IPv6)\n\
   -X, --peer-detect        perform server version detection and version exchange\n\
-  -Z, --linux-congestion <algo>  set TCP congestion control algorithm (Linux only)\n\
+      --clock-sync         estimate the clock offset to the server to correct latencies (implies -X)\n"
+"      --write-latency[=#]  TCP, stamp each write for the server's write to read latency, waiting per\n"
+"                           TCP_NOTSENT_LOWAT # bytes (default -l), and sample the send queue (implies -X)\n"
+"      --sweep <spec>       TCP, run the test once per combination of -Z, -w, -l and -P values, e.g.\n"
+"                           \"Z=cubic,bbr w=256K,4M l=128K P=1,4\", reusing the connections\n"
+"      --trials #           TCP, run the test # times on the same connections and summarize the runs'\n"
+"                           median, 10th/90th percentiles and 95% CI (default 3 with --sweep)\n"
+"      --sweep-settle #     seconds idle between --sweep or --trials runs (default 1)\n"
+"      --payload <mode>     send zeros, pattern, random or compress=<ratio> data the server can --verify\n"
+"                           (implies -X)\n"
+"  -Z, --linux-congestion <algo>  set TCP congestion control algorithm (Linux only)\n\
 \n\
 Miscellaneous:\n\
   -x, --reportexclude [CDMSV]   exclude C(connection) D(data) M(multicast) S(settings) V(server) reports\n\
@@ -253,6 +296,86 @@ const char report_bw_read_enhanced_format[] =
 const char report_sum_bw_read_enhanced_format[] =
 "[SUM] %4.2f-%4.2f sec  %ss  %ss/sec  %d    %d:%d:%d:%d:%d:%d:%d:%d\n";
 
+const char report_read_log2hist_format[] =
+"[%3d] %4.2f-%4.2f sec  %.1f reads/MByte  log2(bytes)=reads:";
+
+const char report_sum_read_log2hist_format[] =
+"[SUM] %4.2f-%4.2f sec  %.1f reads/MByte  log2(bytes)=reads:";
+
+const char report_read_log2bin[] =
+" %d=%d";
+
+const char report_tcpsample_header[] =
+"[%3d] TCP_INFO every %d us, %lu samples (%lu overwritten)\n\
+[ ID]    Time(s)   Cwnd  SRTT(us) RTTvar(us)  Inflight Retrans   Pacing(bps) Delivery(bps)\n";
+
+const char report_tcpsample_format[] =
+"[%3d] %10.6f %6u %9u %10u %9u %7u %13"PRIu64" %13"PRIu64"\n";
+
+const char report_clocksync[] =
+" (clock offset %.3f ms, rtt %.3f ms, %d samples)";
+
+const char report_clocksync_local[] =
+" (clock offset 0, same host)";
+
+const char report_timebuckets_header[] =
+"[%3d] %d us buckets, %ld of %ld populated, peak %.0f bits/sec at %.6f sec\n\
+[ ID]    Time(s)  Packets        Bytes\n";
+
+const char report_timebuckets_late[] =
+"[%3d] %u packets, %"PRIu64" bytes past the end of the bucket array\n";
+
+const char report_timebuckets_format[] =
+"[%3d] %10.6f %8u %12"PRIu64"\n";
+
+const char report_cpu_format[] =
+"[%3d] %4.1f-%4.1f sec  CPU %5.1f%%";
+
+const char report_cpu_counters[] =
+"  %.2f cycles/byte  %.0f cycles/pkt  %.2f IPC  %"PRIu64" cache-misses  %"PRIu64" csw";
+
+const char report_cpu_rusage[] =
+"  user %.3f sys %.3f sec  %ld/%ld vol/invol csw";
+
+const char report_cpu_reporter[] =
+"[RPT] reporter thread  %4.1f sec  CPU %5.1f%%";
+
+const char report_cpu_reporter_counters[] =
+"  %"PRIu64" cycles  %"PRIu64" csw";
+
+const char report_write_latency_format[] =
+"[%3d] %4.2f-%4.2f sec  write-read latency %.3f/%.3f/%.3f/%.3f ms (avg/min/max/stdev) %"PRIdMAX" writes\n";
+
+const char report_sndq_format[] =
+"[%3d] send queue %.0f/%d/%d bytes (avg/min/max) over %"PRIdMAX" writes, TCP_NOTSENT_LOWAT %d\n";
+
+const char report_fanout_header[] =
+"[TGT] Target                   Streams  Interval     Transfer     Bandwidth\n";
+
+const char report_fanout_format[] =
+"[TGT] %-24s %7d  0.0-%4.1f sec  %ss  %ss/sec\n";
+
+const char report_fanout_failed[] =
+"[TGT] %-24s       0  no stream completed\n";
+
+const char report_fanout_sum_format[] =
+"[ALL] %d of %d targets  0.0-%4.1f sec  %ss  %ss/sec\n";
+
+const char report_sweep_step[] =
+"[SWP] run %d of %d: -Z %s -w %s -l %s -P %d\n";
+
+const char report_sweep_header[] =
+"[SWP] Congestion  Window  Length  Streams  Runs  Mean +/- 95% CI                    Median          P10             P90\n";
+
+const char report_sweep_format[] =
+"[SWP] %-10s  %6s  %6s  %7d  %4d  %ss/sec +/- %ss/sec  %ss/sec  %ss/sec  %ss/sec\n";
+
+const char report_sweep_rtt_format[] =
+"[SWP] %-10s  %6s  %6s  %7d  %4d  %7.3f ms RTT +/- %7.3f ms RTT  %7.3f ms RTT  %7.3f ms RTT  %7.3f ms RTT\n";
+
+const char report_sweep_failed[] =
+"[SWP] %-10s  %6s  %6s  %7d     0  no run completed\n";
+
 #ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
 const char report_bw_write_enhanced_header[] =
 "[ ID] Interval        Transfer    Bandwidth       Write/Err  Rtry    Cwnd/RTT\n";
@@ -302,6 +425,21 @@ const char report_bw_jitter_loss_suppress_enhanced_format[] =
 const char report_outoforder[] =
 "[%3d] %4.2f-%4.2f sec  %d datagrams received out-of-order\n";
 
+const char report_duplicates[] =
+"[%3d] %4.2f-%4.2f sec  %"PRIdMAX" duplicate datagrams received\n";
+
+const char report_toolate[] =
+"[%3d] %4.2f-%4.2f sec  %"PRIdMAX" datagrams received behind the reorder window\n";
+
+const char report_mcast_joined[] =
+"Joined %d of %d multicast channels on %d socket(s)\n";
+
+const char report_reorder_log2hist_format[] =
+"[%3d] %4.2f-%4.2f sec  reorder window %"PRIdMAX"  log2(distance)=late datagrams:";
+
+const char report_payload_verify[] =
+"[%3d] %s payload verified: %"PRIdMAX" bytes, %"PRIdMAX" corrupted in %"PRIdMAX" %s\n";
+
 const char report_sum_outoforder[] =
 "[SUM] %4.2f-%4.2f sec  %d datagrams received out-of-order\n";
 
@@ -355,6 +493,13 @@ const char reportCSV_bw_jitter_loss_format[] =
 "%s,%s,%d,%.1f-%.1f,%d,%d,%.3f,%d,%d,%.3f,%d\n";
 #endif //WIN32
 #endif //HAVE_QUAD_SUPPORT
+
+// --cpu: CPU %, cycles, instructions, cache misses, context switches
+const char reportCSV_cpu_format[] =
+"%s,%.1f,%"PRIu64",%"PRIu64",%"PRIu64",%"PRIu64"\n";
+
+const char reportCSV_cpu_empty[] =
+"%s,,,,,\n";
 /* -------------------------------------------------------------------
  * warnings
  * ------------------------------------------------------------------- */
@@ -433,6 +578,75 @@ const char warn_compat_and_peer_exchange[] =
 const char warn_seqno_wrap[] =
 "WARNING: Client UDP sequence number wrapped, suggest --udp-counters-64bit on both client and server\n";
 
+const char warn_iouring_fallback[] =
+"[%3d] WARNING: io_uring setup failed (%s), using read()/write()\n";
+
+const char warn_clocksync_failed[] =
+"[%3d] WARNING: clock sync exchange failed, latencies are not corrected\n";
+
+const char warn_write_stamp_lost[] =
+"[%3d] WARNING: lost the client's write stamps, latencies stop here\n";
+
+const char warn_netmap_open[] =
+"WARNING: netmap open of %s failed (%s), using the socket\n";
+
+const char warn_netmap_mac[] =
+"WARNING: netmap destination mac '%s' not understood, using broadcast\n";
+
+const char warn_netmap_ipv6[] =
+"WARNING: netmap data path supports IPv4 only, using the socket\n";
+
+const char warn_netmap_len[] =
+"WARNING: netmap datagram length %d exceeds the port's %d, using the socket\n";
+
+const char warn_netmap_fin[] =
+"[%3d] WARNING: netmap can't wait for the server's ack of the last datagram, no server report\n";
+
+const char warn_stats_shm[] =
+"WARNING: can't create stats file %s (%s)\n";
+
+const char warn_lwip_rtc[] =
+"WARNING: the lwIP run-to-completion build runs plain IPv4 TCP tests only\n";
+
+const char warn_fanout_targets[] =
+"WARNING: no targets in %s, option ignored\n";
+
+const char warn_fanout_max[] =
+"WARNING: only the first %d targets are used\n";
+
+const char warn_fanout_mode[] =
+"WARNING: --targets runs one way tests only, -d and -r ignored\n";
+
+const char warn_sweep_spec[] =
+"WARNING: bad --sweep dimension %s, expected Z=, w=, l= or P= and a comma separated list\n";
+
+const char warn_sweep_mode[] =
+"WARNING: --sweep and --trials run one way TCP tests from a plain -c only, option ignored\n";
+
+const char warn_warmup_short[] =
+"[%3d] WARNING: the stream ended within --warmup, all of it is reported\n";
+
+const char warn_verify_no_payload[] =
+"[%3d] WARNING: the client sent no --payload, nothing to verify\n";
+
+const char warn_mcast_groups[] =
+"WARNING: no multicast channels in %s, option ignored\n";
+
+const char warn_mcast_entry[] =
+"WARNING: %s is not a multicast group or source@group, entry ignored\n";
+
+const char warn_mcast_max[] =
+"WARNING: only the first %d multicast channels are used\n";
+
+const char warn_mcast_family[] =
+"WARNING: channel %s is not in the listener's address family (see -V), not joined\n";
+
+const char warn_mcast_join[] =
+"WARNING: can't join channel %s (%s)\n";
+
+const char warn_mcast_stray[] =
+"WARNING: channel %s ignored %"PRIdMAX" datagrams from senders other than its stream's\n";
+
 
 #ifdef __cplusplus
 } /* end extern "C" */
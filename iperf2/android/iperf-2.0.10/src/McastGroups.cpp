@@ -0,0 +1,265 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * McastGroups.cpp
+ * -------------------------------------------------------------------
+ * The --mcast-groups channel list and the lookup of a datagram's
+ * channel.  The channels are hashed on their group address, an SSM
+ * group's sources sharing its chain, so the per datagram lookup
+ * stays flat however many channels the server joins.
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "SocketAddr.h"
+#include "Locale.h"
+#include "util.h"
+#include "McastGroups.h"
+
+static McastChannel *mcast_channels = NULL;
+static int mcast_count = 0;
+static int mcast_alloc = 0;
+static int *mcast_hash = NULL;
+static int mcast_mask = 0;
+
+/*
+ * Fill in addr from a numeric IPv4 or IPv6 address, returns 0 if
+ * it isn't one
+ */
+static int mcast_addr( const char *text, iperf_sockaddr *addr ) {
+    memset( addr, 0, sizeof(iperf_sockaddr) );
+    if ( inet_pton( AF_INET, text, &((struct sockaddr_in*) addr)->sin_addr ) == 1 ) {
+	((struct sockaddr*) addr)->sa_family = AF_INET;
+	return 1;
+    }
+#ifdef HAVE_IPV6
+    if ( inet_pton( AF_INET6, text, &((struct sockaddr_in6*) addr)->sin6_addr ) == 1 ) {
+	((struct sockaddr*) addr)->sa_family = AF_INET6;
+	return 1;
+    }
+#endif
+    return 0;
+}
+
+static unsigned mcast_hashaddr( iperf_sockaddr *addr ) {
+    const unsigned char *p;
+    unsigned h = 2166136261U;
+    int len;
+
+#ifdef HAVE_IPV6
+    if ( SockAddr_isIPv6( addr ) ) {
+	p = (const unsigned char*) SockAddr_get_in6_addr( addr );
+	len = sizeof(struct in6_addr);
+    } else
+#endif
+    {
+	p = (const unsigned char*) SockAddr_get_in_addr( addr );
+	len = sizeof(struct in_addr);
+    }
+    while ( len-- > 0 ) {
+	h = (h ^ *p++) * 16777619U;
+    }
+    return h;
+}
+
+static McastChannel* mcast_find( iperf_sockaddr *group, iperf_sockaddr *source, int ssm ) {
+    for ( int i = 0; i < mcast_count; i++ ) {
+	McastChannel *ch = &mcast_channels[i];
+	if ( ch->ssm == ssm &&
+	     SockAddr_Hostare_Equal( (struct sockaddr*) &ch->group, (struct sockaddr*) group ) &&
+	     (!ssm || SockAddr_Hostare_Equal( (struct sockaddr*) &ch->source, (struct sockaddr*) source )) ) {
+	    return ch;
+	}
+    }
+    return NULL;
+}
+
+static int mcast_add( const char *entry ) {
+    char text[REPORT_ADDRLEN * 2 + 2];
+    iperf_sockaddr group, source;
+    const char *at = strchr( entry, '@' );
+    int ssm = (at != NULL);
+
+    if ( strlen( entry ) >= sizeof(text) ) {
+	fprintf( stderr, warn_mcast_entry, entry );
+	return 1;
+    }
+    strcpy( text, entry );
+    if ( ssm ) {
+	text[at - entry] = '\0';
+	if ( !mcast_addr( text, &source ) || !mcast_addr( text + (at - entry) + 1, &group ) ||
+	     ((struct sockaddr*) &source)->sa_family != ((struct sockaddr*) &group)->sa_family ) {
+	    fprintf( stderr, warn_mcast_entry, entry );
+	    return 1;
+	}
+    } else if ( !mcast_addr( text, &group ) ) {
+	fprintf( stderr, warn_mcast_entry, entry );
+	return 1;
+    }
+    if ( !SockAddr_isMulticast( &group ) ) {
+	fprintf( stderr, warn_mcast_entry, entry );
+	return 1;
+    }
+    // the list is read once, at startup, a linear search is fine
+    if ( mcast_find( &group, &source, ssm ) != NULL ) {
+	return 1;
+    }
+    if ( mcast_count == MCASTGROUPS_MAX_CHANNELS ) {
+	fprintf( stderr, warn_mcast_max, MCASTGROUPS_MAX_CHANNELS );
+	return 0;
+    }
+    if ( mcast_count == mcast_alloc ) {
+	McastChannel *grown;
+	mcast_alloc = (mcast_alloc == 0) ? 64 : mcast_alloc * 2;
+	grown = (McastChannel *) realloc( mcast_channels, mcast_alloc * sizeof(McastChannel) );
+	if ( grown == NULL )
+	    return 0;
+	mcast_channels = grown;
+    }
+    McastChannel *ch = &mcast_channels[mcast_count++];
+    memset( ch, 0, sizeof(McastChannel) );
+    ch->group = group;
+    if ( ssm ) {
+	ch->source = source;
+    }
+    ch->ssm = ssm;
+    ch->sock = INVALID_SOCKET;
+    return 1;
+}
+
+// entries are separated by white space or commas
+static int mcast_line( char *line ) {
+    char *entry = strtok( line, ", \t\r\n" );
+
+    while ( entry != NULL ) {
+	if ( !mcast_add( entry ) )
+	    return 0;
+	entry = strtok( NULL, ", \t\r\n" );
+    }
+    return 1;
+}
+
+static void mcast_index( void ) {
+    int size = 16;
+
+    while ( size < 2 * mcast_count ) {
+	size <<= 1;
+    }
+    mcast_hash = new int[size];
+    mcast_mask = size - 1;
+    for ( int i = 0; i < size; i++ ) {
+	mcast_hash[i] = -1;
+    }
+    for ( int i = 0; i < mcast_count; i++ ) {
+	unsigned bucket = mcast_hashaddr( &mcast_channels[i].group ) & mcast_mask;
+	mcast_channels[i].next = mcast_hash[bucket];
+	mcast_hash[bucket] = i;
+    }
+}
+
+int McastGroups_Load( const char *spec ) {
+    FILE *f = fopen( spec, "r" );
+    char line[1024];
+
+    if ( f != NULL ) {
+	while ( fgets( line, sizeof(line), f ) != NULL ) {
+	    char *end;
+	    if ( (end = strchr( line, '#' )) != NULL )
+		*end = '\0';
+	    if ( !mcast_line( line ) )
+		break;
+	}
+	fclose( f );
+    } else {
+	char *list = new char[strlen( spec ) + 1];
+	strcpy( list, spec );
+	mcast_line( list );
+	DELETE_ARRAY( list );
+    }
+    if ( mcast_count == 0 ) {
+	fprintf( stderr, warn_mcast_groups, spec );
+    } else {
+	mcast_index( );
+    }
+    return mcast_count;
+}
+
+int McastGroups_Count( void ) {
+    return mcast_count;
+}
+
+McastChannel* McastGroups_Channel( int channel ) {
+    return &mcast_channels[channel];
+}
+
+McastChannel* McastGroups_Lookup( iperf_sockaddr *group, iperf_sockaddr *source ) {
+    McastChannel *any = NULL;
+
+    for ( int i = mcast_hash[mcast_hashaddr( group ) & mcast_mask]; i >= 0; i = mcast_channels[i].next ) {
+	McastChannel *ch = &mcast_channels[i];
+	if ( !SockAddr_Hostare_Equal( (struct sockaddr*) &ch->group, (struct sockaddr*) group ) )
+	    continue;
+	if ( !ch->ssm ) {
+	    any = ch;
+	} else if ( SockAddr_Hostare_Equal( (struct sockaddr*) &ch->source, (struct sockaddr*) source ) ) {
+	    return ch;
+	}
+    }
+    return any;
+}
+
+void McastGroups_Name( McastChannel *channel, char *name, int len ) {
+    char group[REPORT_ADDRLEN];
+
+    SockAddr_getHostAddress( &channel->group, group, sizeof(group) );
+    if ( channel->ssm ) {
+	char source[REPORT_ADDRLEN];
+	SockAddr_getHostAddress( &channel->source, source, sizeof(source) );
+	snprintf( name, len, "%s@%s", source, group );
+    } else {
+	snprintf( name, len, "%s", group );
+    }
+}
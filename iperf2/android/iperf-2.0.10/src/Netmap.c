@@ -0,0 +1,342 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * Netmap.c
+ * -------------------------------------------------------------------
+ * Open a netmap port and prepare its rings for iperf's UDP traffic.
+ * The frame layout follows pkt-gen's initialize_packet(): the
+ * headers are written once and the IPv4 checksum is computed once.
+ * The UDP checksum is left zero since the payload changes per
+ * datagram.  RX rings are asked to timestamp each sync.
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+
+#ifdef HAVE_NET_NETMAP_USER_H
+#define NETMAP_WITH_LIBS
+#include <net/netmap_user.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include "Netmap.h"
+#include "Locale.h"
+
+/* -------------------------------------------------------------------
+ * Parse a colon separated mac address, returns 0 on success
+ * ------------------------------------------------------------------- */
+static int netmap_parsemac( const char *str, u_char *mac ) {
+    unsigned int b[6];
+    int i;
+    if ( sscanf( str, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5] ) != 6 )
+        return -1;
+    for ( i = 0; i < 6; i++ ) {
+        if ( b[i] > 0xFF )
+            return -1;
+        mac[i] = (u_char) b[i];
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------
+ * Use the NIC's own address as the source mac for netmap:<if>
+ * ports.  VALE ports and pipes have no hardware address and
+ * keep zeros.
+ * ------------------------------------------------------------------- */
+static void netmap_hwaddr( const char *port, u_char *mac ) {
+#ifdef SIOCGIFHWADDR
+    struct ifreq ifr;
+    size_t len;
+    int s;
+
+    if ( strncmp( port, "netmap:", 7 ) != 0 )
+        return;
+    port += 7;
+    // strip any ring selection suffix, e.g. eth0-1 or eth0^
+    len = strcspn( port, "-*^{}/@" );
+    if ( len == 0 || len >= sizeof(ifr.ifr_name) )
+        return;
+    memset( &ifr, 0, sizeof(ifr) );
+    memcpy( ifr.ifr_name, port, len );
+    s = socket( AF_INET, SOCK_DGRAM, 0 );
+    if ( s < 0 )
+        return;
+    if ( ioctl( s, SIOCGIFHWADDR, &ifr ) == 0 )
+        memcpy( mac, ifr.ifr_hwaddr.sa_data, 6 );
+    close( s );
+#endif
+}
+
+/* -------------------------------------------------------------------
+ * Internet checksum over the IPv4 header, see RFC 1071
+ * ------------------------------------------------------------------- */
+static uint16_t netmap_ipsum( const u_char *hdr, int len ) {
+    uint32_t sum = 0;
+    int i;
+    for ( i = 0; i < len; i += 2 )
+        sum += (hdr[i] << 8) | hdr[i + 1];
+    while ( sum >> 16 )
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return htons( (uint16_t) ~sum );
+}
+
+Netmap* Netmap_Open( const char *portspec ) {
+    Netmap *nm;
+    char *port;
+    char *mac;
+    int r;
+
+    nm = (Netmap*) calloc( 1, sizeof(Netmap) );
+    if ( nm == NULL )
+        return NULL;
+    memset( nm->dst_mac, 0xFF, sizeof(nm->dst_mac) );
+
+    port = strdup( portspec );
+    if ( port == NULL ) {
+        free( nm );
+        return NULL;
+    }
+    if ( (mac = strchr( port, ',' )) != NULL ) {
+        *mac++ = '\0';
+        if ( netmap_parsemac( mac, nm->dst_mac ) != 0 ) {
+            fprintf( stderr, warn_netmap_mac, mac );
+            memset( nm->dst_mac, 0xFF, sizeof(nm->dst_mac) );
+        }
+    }
+    netmap_hwaddr( port, nm->src_mac );
+
+    nm->desc = nm_open( port, NULL, 0, NULL );
+    if ( nm->desc == NULL ) {
+        fprintf( stderr, warn_netmap_open, port, strerror( errno ) );
+        free( port );
+        free( nm );
+        return NULL;
+    }
+    free( port );
+    nm->nifp = nm->desc->nifp;
+    nm->fd = nm->desc->fd;
+    nm->first_tx_ring = nm->desc->first_tx_ring;
+    nm->last_tx_ring = nm->desc->last_tx_ring;
+    nm->cur_tx_ring = nm->first_tx_ring;
+    nm->first_rx_ring = nm->desc->first_rx_ring;
+    nm->last_rx_ring = nm->desc->last_rx_ring;
+    nm->cur_rx_ring = nm->first_rx_ring;
+    for ( r = nm->first_rx_ring; r <= nm->last_rx_ring; r++ )
+        NETMAP_RXRING( nm->nifp, r )->flags |= NR_TIMESTAMP;
+    return nm;
+}
+
+void Netmap_Close( Netmap *nm ) {
+    if ( nm == NULL )
+        return;
+    nm_close( nm->desc );
+    free( nm->frame );
+    free( nm );
+}
+
+int Netmap_TxInit( Netmap *nm, iperf_sockaddr *local, iperf_sockaddr *peer,
+                   const char *payload, int len ) {
+    struct sockaddr_in *src = (struct sockaddr_in*) local;
+    struct sockaddr_in *dst = (struct sockaddr_in*) peer;
+    u_char *eh, *ip, *udp;
+    uint16_t val;
+    int r;
+
+    if ( src->sin_family != AF_INET || dst->sin_family != AF_INET ) {
+        fprintf( stderr, "%s", warn_netmap_ipv6 );
+        return -1;
+    }
+    nm->frame_len = NETMAP_FRAME_HDRLEN + len;
+    if ( nm->frame_len > NETMAP_TXRING( nm->nifp, nm->first_tx_ring )->nr_buf_size ) {
+        fprintf( stderr, warn_netmap_len, len,
+                 NETMAP_TXRING( nm->nifp, nm->first_tx_ring )->nr_buf_size - NETMAP_FRAME_HDRLEN );
+        return -1;
+    }
+    nm->frame = (u_char*) calloc( 1, nm->frame_len );
+    if ( nm->frame == NULL )
+        return -1;
+
+    // ethernet
+    eh = nm->frame;
+    memcpy( eh, nm->dst_mac, 6 );
+    memcpy( eh + 6, nm->src_mac, 6 );
+    val = htons( 0x0800 );
+    memcpy( eh + 12, &val, 2 );
+
+    // ipv4, don't fragment, the sockets' addresses
+    ip = eh + 14;
+    ip[0] = 0x45;
+    val = htons( 20 + 8 + len );
+    memcpy( ip + 2, &val, 2 );
+    val = htons( 0x4000 );
+    memcpy( ip + 6, &val, 2 );
+    ip[8] = 64;
+    ip[9] = IPPROTO_UDP;
+    memcpy( ip + 12, &src->sin_addr, 4 );
+    memcpy( ip + 16, &dst->sin_addr, 4 );
+    val = netmap_ipsum( ip, 20 );
+    memcpy( ip + 10, &val, 2 );
+
+    // udp, no checksum
+    udp = ip + 20;
+    memcpy( udp, &src->sin_port, 2 );
+    memcpy( udp + 2, &dst->sin_port, 2 );
+    val = htons( 8 + len );
+    memcpy( udp + 4, &val, 2 );
+
+    memcpy( udp + 8, payload, len );
+
+    // stamp the frame into every TX slot, later only the
+    // UDP_datagram header gets rewritten
+    for ( r = nm->first_tx_ring; r <= nm->last_tx_ring; r++ ) {
+        struct netmap_ring *ring = NETMAP_TXRING( nm->nifp, r );
+        uint32_t i;
+        for ( i = 0; i < ring->num_slots; i++ ) {
+            memcpy( NETMAP_BUF( ring, ring->slot[i].buf_idx ), nm->frame, nm->frame_len );
+            ring->slot[i].len = nm->frame_len;
+        }
+    }
+    return 0;
+}
+
+int Netmap_TxSync( Netmap *nm ) {
+    nm->cur_tx_ring = nm->first_tx_ring;
+    return ioctl( nm->fd, NIOCTXSYNC, NULL );
+}
+
+int Netmap_TxWait( Netmap *nm, int msecs ) {
+    struct pollfd pfd;
+    pfd.fd = nm->fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    nm->cur_tx_ring = nm->first_tx_ring;
+    return poll( &pfd, 1, msecs );
+}
+
+void Netmap_TxDrain( Netmap *nm, int msecs ) {
+    int r, pending;
+    do {
+        Netmap_TxSync( nm );
+        pending = 0;
+        for ( r = nm->first_tx_ring; r <= nm->last_tx_ring; r++ ) {
+            if ( nm_tx_pending( NETMAP_TXRING( nm->nifp, r ) ) )
+                pending = 1;
+        }
+        if ( pending )
+            usleep( 1000 );
+    } while ( pending && msecs-- > 0 );
+}
+
+int Netmap_RxWait( Netmap *nm, int msecs ) {
+    struct pollfd pfd;
+    pfd.fd = nm->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    nm->cur_rx_ring = nm->first_rx_ring;
+    return poll( &pfd, 1, msecs );
+}
+
+int Netmap_RxAccept( Netmap *nm, unsigned short port, char *buf, int len,
+                     iperf_sockaddr *peer, iperf_sockaddr *local ) {
+    struct sockaddr_in *src = (struct sockaddr_in*) peer;
+    struct sockaddr_in *dst = (struct sockaddr_in*) local;
+    char *payload;
+    int32_t id;
+    int plen;
+
+    for ( ;; ) {
+        if ( Netmap_RxWait( nm, -1 ) < 0 )
+            return -1;
+        // match on the port alone until a test shows up
+        nm->saddr = nm->daddr = 0;
+        nm->sport = 0;
+        nm->dport = htons( port );
+        while ( nm->cur_rx_ring <= nm->last_rx_ring ) {
+            struct netmap_ring *ring = NETMAP_RXRING( nm->nifp, nm->cur_rx_ring );
+            if ( nm_ring_empty( ring ) ) {
+                nm->cur_rx_ring++;
+                continue;
+            }
+            {
+                uint32_t cur = ring->cur;
+                char *frame = NETMAP_BUF( ring, ring->slot[cur].buf_idx );
+                int framelen = ring->slot[cur].len;
+                ring->head = ring->cur = nm_ring_next( ring, cur );
+                if ( framelen < NETMAP_FRAME_HDRLEN )
+                    continue;
+                // fill in the wildcards from the frame itself
+                memcpy( &nm->saddr, frame + 26, 4 );
+                memcpy( &nm->daddr, frame + 30, 4 );
+                memcpy( &nm->sport, frame + 14 + ((frame[14] & 0x0F) << 2), 2 );
+                payload = Netmap_RxMatch( nm, frame, framelen, &plen );
+                if ( payload == NULL || plen < (int) sizeof(id) ) {
+                    nm->saddr = nm->daddr = 0;
+                    nm->sport = 0;
+                    continue;
+                }
+                memcpy( &id, payload, sizeof(id) );
+                if ( (int32_t) ntohl( id ) < 0 ) {
+                    // the tail of a finished test
+                    nm->saddr = nm->daddr = 0;
+                    nm->sport = 0;
+                    continue;
+                }
+                memcpy( buf, payload, (plen < len) ? plen : len );
+                memset( peer, 0, sizeof(*peer) );
+                memset( local, 0, sizeof(*local) );
+                src->sin_family = AF_INET;
+                memcpy( &src->sin_addr, &nm->saddr, 4 );
+                src->sin_port = nm->sport;
+                dst->sin_family = AF_INET;
+                memcpy( &dst->sin_addr, &nm->daddr, 4 );
+                dst->sin_port = nm->dport;
+                return plen;
+            }
+        }
+    }
+}
+
+#endif // HAVE_NET_NETMAP_USER_H
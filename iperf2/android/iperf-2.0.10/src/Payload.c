@@ -0,0 +1,209 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * Payload.c
+ * -------------------------------------------------------------------
+ * Builds the --payload pools and checks what the server reads
+ * against them.  The PRNG is four xorshift64 lanes stepped side by
+ * side, no multiplies and no carries between lanes, so the compiler
+ * turns the loop into vector shifts and xors.
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "util.h"
+#include "Payload.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PAYLOAD_SEED   0x6970657266327061ULL
+#define PAYLOAD_LANES  4
+// bytes per compressible block, the first 1/ratio of it is random
+#define PAYLOAD_BLOCK  256
+
+static uint64_t splitmix64( uint64_t *x ) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Fill words 64 bit words, a multiple of the lanes, with the PRNG.
+ * The words are stored little endian so both ends agree on the bytes
+ * whatever their byte order.
+ */
+static void payload_random( uint64_t *out, long words ) {
+    uint64_t s[PAYLOAD_LANES], x = PAYLOAD_SEED;
+    union { uint64_t word; unsigned char byte[8]; } probe;
+    long i;
+    int l, b;
+
+    for ( l = 0; l < PAYLOAD_LANES; l++ ) {
+	s[l] = splitmix64( &x ) | 1;
+    }
+    for ( i = 0; i < words; i += PAYLOAD_LANES ) {
+	for ( l = 0; l < PAYLOAD_LANES; l++ ) {
+	    s[l] ^= s[l] << 13;
+	    s[l] ^= s[l] >> 7;
+	    s[l] ^= s[l] << 17;
+	    out[i + l] = s[l];
+	}
+    }
+    probe.word = 1;
+    if ( probe.byte[0] != 1 ) {
+	for ( i = 0; i < words; i++ ) {
+	    probe.word = out[i];
+	    for ( b = 0; b < 8; b++ ) {
+		((unsigned char *) &out[i])[b] = (unsigned char) (probe.word >> (8 * b));
+	    }
+	}
+    }
+}
+
+int Payload_Parse( const char *spec, double *ratio ) {
+    *ratio = 1.0;
+    if ( strcmp( spec, "zeros" ) == 0 ) {
+	return kPayload_Zeros;
+    } else if ( strcmp( spec, "pattern" ) == 0 ) {
+	return kPayload_Pattern;
+    } else if ( strcmp( spec, "random" ) == 0 ) {
+	return kPayload_Random;
+    } else if ( strncmp( spec, "compress=", 9 ) == 0 ) {
+	*ratio = atof( spec + 9 );
+	if ( *ratio < 1.0 || *ratio > PAYLOAD_RATIO_MAX ) {
+	    fprintf( stderr, "WARNING: --payload compress ratio must be 1 to %d\n", PAYLOAD_RATIO_MAX );
+	    return 0;
+	}
+	return kPayload_Compress;
+    }
+    fprintf( stderr, "WARNING: unknown --payload %s\n", spec );
+    return 0;
+}
+
+const char* Payload_Name( int mode ) {
+    switch ( mode ) {
+    case kPayload_Zeros:
+	return "zeros";
+    case kPayload_Pattern:
+	return "pattern";
+    case kPayload_Random:
+	return "random";
+    case kPayload_Compress:
+	return "compress";
+    default:
+	return "default";
+    }
+}
+
+char* Payload_Pool( int mode, double ratio, int extra ) {
+    char *pool;
+    long block, keep;
+    int n;
+
+    // malloc()'s alignment will do for the PRNG's word stores
+    pool = (char *) malloc( PAYLOAD_POOL + ((extra > 0) ? extra : 0) );
+    if ( pool == NULL ) {
+	WARN( 1, "Out of memory for the payload pool" );
+	return NULL;
+    }
+    switch ( mode ) {
+    case kPayload_Pattern:
+	pattern( pool, PAYLOAD_POOL );
+	break;
+    case kPayload_Random:
+    case kPayload_Compress:
+	payload_random( (uint64_t *) pool, PAYLOAD_POOL / 8 );
+	if ( mode == kPayload_Random )
+	    break;
+	// zero the tail of every block, carrying the rounding so the
+	// random share of the whole pool is 1/ratio
+	for ( block = 0; block < PAYLOAD_POOL / PAYLOAD_BLOCK; block++ ) {
+	    keep = (long) ((block + 1) * PAYLOAD_BLOCK / ratio) - (long) (block * PAYLOAD_BLOCK / ratio);
+	    memset( pool + block * PAYLOAD_BLOCK + keep, 0, PAYLOAD_BLOCK - keep );
+	}
+	break;
+    default:
+	memset( pool, 0, PAYLOAD_POOL );
+	break;
+    }
+    for ( n = 0; n < extra; n += PAYLOAD_POOL ) {
+	memcpy( pool + PAYLOAD_POOL + n, pool,
+		(extra - n < PAYLOAD_POOL) ? extra - n : PAYLOAD_POOL );
+    }
+    return pool;
+}
+
+void Payload_Free( char *pool ) {
+    free( pool );
+}
+
+max_size_t Payload_Verify( const char *pool, max_size_t pos, const char *buf, long len ) {
+    max_size_t bad = 0;
+    long i, n;
+
+    pos &= PAYLOAD_POOL - 1;
+    while ( len > 0 ) {
+	n = PAYLOAD_POOL - (long) pos;
+	if ( n > len )
+	    n = len;
+	// memcmp runs vectorized at memory speed, only count on a miss
+	if ( memcmp( pool + pos, buf, n ) != 0 ) {
+	    for ( i = 0; i < n; i++ ) {
+		bad += (pool[pos + i] != buf[i]);
+	    }
+	}
+	buf += n;
+	len -= n;
+	pos = 0;
+    }
+    return bad;
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
@@ -80,9 +80,13 @@ void CSV_stats( Transfer_Info *stats ) {
 	strftime(buffer, 80, "%Y%m%d%H%M%S", localtime(&t1.tv_sec));
 	snprintf(timestamp, 80, "%s.%.3d", buffer, milliseconds);
     }
+    // with --cpu the columns are written to line and get the CPU
+    // columns added in place of the newline, left empty on rows
+    // without a sample (e.g. [SUM]) so every row has the same width
+    char line[512];
     if ( stats->mUDP != (char)kMode_Server ) {
         // TCP Reporting
-        printf( reportCSV_bw_format,
+        snprintf( line, sizeof(line), reportCSV_bw_format,
                 timestamp,
                 (stats->reserved_delay == NULL ? ",,," : stats->reserved_delay),
                 stats->transferID,
@@ -92,7 +96,7 @@ void CSV_stats( Transfer_Info *stats ) {
                 speed);
     } else {
         // UDP Reporting
-        printf( reportCSV_bw_jitter_loss_format,
+        snprintf( line, sizeof(line), reportCSV_bw_jitter_loss_format,
                 timestamp,
                 (stats->reserved_delay == NULL ? ",,," : stats->reserved_delay),
                 stats->transferID,
@@ -105,6 +109,19 @@ void CSV_stats( Transfer_Info *stats ) {
                 stats->cntDatagrams,
                 (100.0 * stats->cntError) / stats->cntDatagrams, stats->cntOutofOrder );
     }
+    if ( stats->cpu.sampled ) {
+        CPUStats *cpu = &stats->cpu;
+        double secs = stats->endTime - stats->startTime;
+        line[strcspn( line, "\n" )] = '\0';
+        printf( reportCSV_cpu_format, line, (secs > 0) ? 100.0 * cpu->cpuSecs / secs : 0.0,
+                cpu->count[CPUACCT_CYCLES], cpu->count[CPUACCT_INSTRUCTIONS],
+                cpu->count[CPUACCT_CACHEMISSES], cpu->count[CPUACCT_CTXSWITCHES] );
+    } else if ( stats->mCPU ) {
+        line[strcspn( line, "\n" )] = '\0';
+        printf( reportCSV_cpu_empty, line );
+    } else {
+        printf( "%s", line );
+    }
     if ( stats->free == 1 && stats->reserved_delay != NULL ) {
         free( stats->reserved_delay );
     }
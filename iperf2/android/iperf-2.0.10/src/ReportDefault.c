@@ -64,6 +64,78 @@
 extern "C" {
 #endif
 
+/*
+ * Prints the log2 read size histogram requested by --recv-mode,
+ * only the populated bins are shown
+ */
+static void reporter_printreadhist( Transfer_Info *stats, int sum ) {
+    int ix;
+    double readsPerMB = (stats->TotalLen > 0) ?
+	(stats->tcp.read.cntRead * 1048576.0 / stats->TotalLen) : 0.0;
+
+    if (sum) {
+	printf(report_sum_read_log2hist_format,
+	       stats->startTime, stats->endTime, readsPerMB);
+    } else {
+	printf(report_read_log2hist_format, stats->transferID,
+	       stats->startTime, stats->endTime, readsPerMB);
+    }
+    for (ix = 0; ix < READ_LOG2BINS; ix++) {
+	if (stats->tcp.read.log2bins[ix])
+	    printf(report_read_log2bin, ix, stats->tcp.read.log2bins[ix]);
+    }
+    printf("\n");
+}
+
+/*
+ * Prints the --reorder-window histogram of how far behind the
+ * highest datagram ID the late ones arrived, populated bins only
+ */
+static void reporter_printreorderhist( Transfer_Info *stats ) {
+    SeqWindow *win = stats->seqwin;
+    int ix;
+
+    printf(report_reorder_log2hist_format, stats->transferID,
+	   stats->startTime, stats->endTime, (intmax_t) (win->mask + 1));
+    for (ix = 0; ix < SEQWINDOW_LOG2BINS; ix++) {
+	if (win->hist[ix])
+	    printf(report_read_log2bin, ix, win->hist[ix]);
+    }
+    printf("\n");
+}
+
+/*
+ * Prints the --cpu line under a stream's transfer report, packets
+ * being datagrams or TCP reads or writes
+ */
+static void reporter_printcpu( Transfer_Info *stats ) {
+    CPUStats *cpu = &stats->cpu;
+    double secs = stats->endTime - stats->startTime;
+    double packets;
+
+    if (stats->mUDP) {
+	packets = stats->cntDatagrams;
+    } else if (stats->mTCP == (char)kMode_Server) {
+	packets = stats->tcp.read.cntRead;
+    } else {
+	packets = stats->tcp.write.WriteCnt;
+    }
+    printf(report_cpu_format, stats->transferID, stats->startTime, stats->endTime,
+	   (secs > 0) ? 100.0 * cpu->cpuSecs / secs : 0.0);
+    if (cpu->counters) {
+	printf(report_cpu_counters,
+	       (stats->TotalLen > 0) ? (double) cpu->count[CPUACCT_CYCLES] / stats->TotalLen : 0.0,
+	       (packets > 0) ? cpu->count[CPUACCT_CYCLES] / packets : 0.0,
+	       (cpu->count[CPUACCT_CYCLES] > 0) ?
+	       (double) cpu->count[CPUACCT_INSTRUCTIONS] / cpu->count[CPUACCT_CYCLES] : 0.0,
+	       cpu->count[CPUACCT_CACHEMISSES], cpu->count[CPUACCT_CTXSWITCHES]);
+    }
+    if (cpu->rusage) {
+	printf(report_cpu_rusage, cpu->userSecs, cpu->sysSecs, cpu->nvcsw, cpu->nivcsw);
+    }
+    printf("\n");
+}
+
 /*
  * Prints transfer reports in default style
  */
@@ -114,6 +186,22 @@ void reporter_printstats( Transfer_Info *stats ) {
 		       stats->tcp.write.rtt);
 	    }
 	}
+	if (stats->mReadHist && stats->mTCP == (char)kMode_Server) {
+	    reporter_printreadhist(stats, 0);
+	}
+	// --write-latency, left out like the UDP latencies when the
+	// clocks are clearly not in sync
+	if (stats->mTCPLatency && stats->transit.cntTransit > 0 &&
+	    (stats->transit.minTransit <= UNREALISTIC_LATENCYMINMAX) &&
+	    (stats->transit.minTransit >= UNREALISTIC_LATENCYMINMIN)) {
+	    printf(report_write_latency_format, stats->transferID,
+		   stats->startTime, stats->endTime,
+		   (stats->transit.sumTransit / stats->transit.cntTransit)*1000.0,
+		   stats->transit.minTransit*1000.0,
+		   stats->transit.maxTransit*1000.0,
+		   (stats->transit.cntTransit < 2) ? 0 : sqrt(stats->transit.m2Transit / (stats->transit.cntTransit - 1)) / 1000,
+		   (intmax_t) stats->transit.cntTransit);
+	}
     } else if ( stats->mUDP == (char)kMode_Client ) {
 	// UDP Client reporting
 	if( !header_printed ) {
@@ -175,10 +263,26 @@ void reporter_printstats( Transfer_Info *stats ) {
 		    stats->transferID, stats->startTime,
 		    stats->endTime, stats->cntOutofOrder );
 	}
+	if ( stats->cntDuplicate > 0 ) {
+	    printf( report_duplicates,
+		    stats->transferID, stats->startTime,
+		    stats->endTime, stats->cntDuplicate );
+	}
+	if ( stats->cntTooLate > 0 ) {
+	    printf( report_toolate,
+		    stats->transferID, stats->startTime,
+		    stats->endTime, stats->cntTooLate );
+	}
+	if ( stats->free == 1 && stats->seqwin != NULL ) {
+	    reporter_printreorderhist( stats );
+	}
+    }
+    if (stats->cpu.sampled) {
+	reporter_printcpu(stats);
     }
     // Reset the enhanced stats for the next report interval
-    if (stats->mEnhanced) {
-	if (stats->mUDP) {
+    if (stats->mEnhanced || stats->mTCPLatency) {
+	if (stats->mUDP || stats->mTCPLatency) {
 	    stats->transit.minTransit=stats->transit.lastTransit;
 	    stats->transit.maxTransit=stats->transit.lastTransit;
 	    stats->transit.sumTransit = stats->transit.lastTransit;
@@ -252,6 +356,9 @@ void reporter_multistats( Transfer_Info *stats ) {
 	    }
 	}
     }
+    if (!stats->mUDP && stats->mReadHist && stats->mTCP == (char)kMode_Server) {
+	reporter_printreadhist(stats, 1);
+    }
     if ((stats->mUDP == kMode_Server) && stats->cntOutofOrder > 0 ) {
             printf( report_sum_outoforder,
                     stats->startTime,
@@ -58,6 +58,9 @@
 #include "Locale.h"
 #include "PerfSocket.hpp"
 #include "SocketAddr.h"
+#include "StatsShm.h"
+#include "Fanout.h"
+#include "Sweep.h"
 #include "lwip_adap.h"
 #ifdef __cplusplus
 extern "C" {
@@ -180,6 +183,8 @@ MultiHeader* InitMulti( thread_Settings *agent, int inID) {
 		} else {
 		    data->info.mEnhanced = 0;
 		}
+		data->info.mReadHist = (isRecvMode( agent ) ? 1 : 0);
+		data->info.mCPU = (isCPUAcct( agent ) ? 1 : 0);
                 if ( isUDP( agent ) ) {
                     multihdr->report->info.mUDP = (char)agent->mThreadMode;
                     multihdr->report->info.mUDP = 0;
@@ -204,6 +209,125 @@ MultiHeader* InitMulti( thread_Settings *agent, int inID) {
     return multihdr;
 }
 
+/*
+ * Report headers are kept on free lists by size class so a server
+ * taking many connections, e.g. in daemon mode, reuses them and their
+ * already faulted in rings instead of going back to the heap.  Class
+ * k > 0 holds a ring of 2^k bytes, class 0 headers have no ring
+ * (settings, connection and server relay reports).  Each class keeps
+ * at most REPORT_POOL_BYTES.
+ */
+#define REPORT_POOL_BYTES (32 * 1024 * 1024)
+#define REPORT_POOL_CLASSES 32
+static ReportHeader *reportpool[REPORT_POOL_CLASSES];
+static int reportpool_count[REPORT_POOL_CLASSES];
+
+static size_t report_size( int poolclass ) {
+    return sizeof(ReportHeader) + (poolclass > 0 ? (size_t) 1 << poolclass : 0);
+}
+
+static ReportHeader *report_alloc( size_t ringbytes ) {
+    ReportHeader *reporthdr;
+    int poolclass = 0;
+
+    if ( ringbytes > 0 ) {
+        poolclass = 1;
+        while ( ((size_t) 1 << poolclass) < ringbytes ) {
+            poolclass++;
+        }
+    }
+    Mutex_Lock( &poolCond );
+    reporthdr = reportpool[poolclass];
+    if ( reporthdr != NULL ) {
+        reportpool[poolclass] = reporthdr->next;
+        reportpool_count[poolclass]--;
+    }
+    Mutex_Unlock( &poolCond );
+    if ( reporthdr == NULL ) {
+        reporthdr = malloc( report_size( poolclass ) );
+        if ( reporthdr == NULL ) {
+            return NULL;
+        }
+    }
+    // Only need to make sure the headers are clean
+    memset( reporthdr, 0, sizeof(ReportHeader) );
+    reporthdr->poolclass = poolclass;
+    return reporthdr;
+}
+
+static void report_free( ReportHeader *reporthdr ) {
+    int poolclass = reporthdr->poolclass;
+
+    Mutex_Lock( &poolCond );
+    if ( (reportpool_count[poolclass] + 1) * report_size( poolclass ) <= REPORT_POOL_BYTES ) {
+        reporthdr->next = reportpool[poolclass];
+        reportpool[poolclass] = reporthdr;
+        reportpool_count[poolclass]++;
+        reporthdr = NULL;
+    }
+    Mutex_Unlock( &poolCond );
+    free( reporthdr );
+}
+
+/*
+ * Pack a packet into a compact ring entry.  The agent's event time
+ * only advances by what the reporter will add back, so rounding a
+ * long gap down to seconds or holding time across a clock step never
+ * lets the two drift apart.
+ */
+static inline void report_encode( ReportHeader *agent, ReportEvent *event, ReportStruct *packet ) {
+    long long usecs = (packet->packetTime.tv_sec - agent->eventTime.tv_sec) * (long long) rMillion +
+                      (packet->packetTime.tv_usec - agent->eventTime.tv_usec);
+
+    event->flags = 0;
+    if ( usecs <= 0 ) {
+        event->delta = 0;
+    } else if ( usecs <= UINT32_MAX ) {
+        event->delta = (uint32_t) usecs;
+        agent->eventTime = packet->packetTime;
+    } else {
+        // over 71 minutes since the last event
+        event->delta = (uint32_t) (usecs / rMillion);
+        event->flags = REPORT_EVENT_SECS;
+        agent->eventTime.tv_sec += event->delta;
+    }
+    if ( packet->emptyreport ) {
+        event->flags |= REPORT_EVENT_EMPTY;
+    }
+    if ( packet->errwrite ) {
+        event->flags |= REPORT_EVENT_ERRWRITE;
+    }
+    if ( packet->packetID < 0 ) {
+        event->flags |= REPORT_EVENT_END;
+    }
+    event->flags |= (uint32_t) (packet->writeCnt & REPORT_EVENT_MAXCNT) << REPORT_EVENT_CNTSHIFT;
+    event->packetLen = packet->packetLen;
+    agent->eventSocket = packet->socket;
+}
+
+static void report_decode( ReportHeader *reporthdr, ReportEvent *event, ReportStruct *packet ) {
+    struct timeval *t = &reporthdr->decodeTime;
+
+    if ( event->flags & REPORT_EVENT_SECS ) {
+        t->tv_sec += event->delta;
+    } else {
+        t->tv_sec += event->delta / rMillion;
+        t->tv_usec += event->delta % rMillion;
+        if ( t->tv_usec >= rMillion ) {
+            t->tv_sec++;
+            t->tv_usec -= rMillion;
+        }
+    }
+    memset( packet, 0, sizeof(ReportStruct) );
+    packet->packetTime = *t;
+    packet->packetLen = event->packetLen;
+    packet->packetID = (event->flags & REPORT_EVENT_END) ? -1 : 0;
+    packet->emptyreport = (event->flags & REPORT_EVENT_EMPTY) != 0;
+    packet->errwrite = (event->flags & REPORT_EVENT_ERRWRITE) != 0;
+    packet->socket = reporthdr->eventSocket;
+    packet->writeCnt = event->flags >> REPORT_EVENT_CNTSHIFT;
+}
+
 /*
  * BarrierClient allows for multiple stream clients to be syncronized
  */
@@ -236,15 +360,29 @@ ReportHeader* InitReport( thread_Settings *agent ) {
         /*
          * Create in one big chunk
          */
-        reporthdr = malloc( sizeof(ReportHeader) +
-                            NUM_REPORT_STRUCTS * sizeof(ReportStruct) );
+        /*
+         * The UDP server needs each datagram's ID and send time, as
+         * does a --write-latency TCP server its stamps', every other
+         * report gets by on the time, length and flags so its ring
+         * holds the compact events
+         */
+        int compact = !((isUDP( agent ) || isWriteLatency( agent )) &&
+                        agent->mThreadMode == kMode_Server);
+        reporthdr = report_alloc( agent->mReportDepth *
+                                  (compact ? sizeof(ReportEvent) : sizeof(ReportStruct)) );
         if ( reporthdr != NULL ) {
-            // Only need to make sure the headers are clean
-            memset( reporthdr, 0, sizeof(ReportHeader));
-            reporthdr->data = (ReportStruct*)(reporthdr+1);
+            Condition_Initialize( &reporthdr->completion );
             reporthdr->multireport = agent->multihdr;
+            reporthdr->depth = agent->mReportDepth;
+            if ( compact ) {
+                reporthdr->events = (ReportEvent*)(reporthdr+1);
+                gettimeofday( &reporthdr->eventTime, NULL );
+                reporthdr->decodeTime = reporthdr->eventTime;
+            } else {
+                reporthdr->data = (ReportStruct*)(reporthdr+1);
+            }
             data = &reporthdr->report;
-            reporthdr->reporterindex = NUM_REPORT_STRUCTS - 1;
+            reporthdr->reporterindex = reporthdr->depth - 1;
             data->info.transferID = agent->mSock;
             data->info.groupID = (agent->multihdr != NULL ? agent->multihdr->groupID : -1);
             data->type = TRANSFER_REPORT;
@@ -261,6 +399,16 @@ ReportHeader* InitReport( thread_Settings *agent ) {
             data->flags = agent->flags;
             data->mThreadMode = agent->mThreadMode;
             data->mode = agent->mReportMode;
+            data->mTarget = agent->mTarget;
+            data->mSweepStep = agent->mSweepStep;
+            if ( isWarmup( agent ) ) {
+                data->mWarmupSecs = agent->mWarmupSecs;
+                data->mWarmupBytes = agent->mWarmupBytes;
+            }
+            // InitReport runs on the agent's thread, the one to measure
+            if ( isCPUAcct( agent ) ) {
+                data->cpu = CPUAcct_Open( );
+            }
             data->info.mFormat = agent->mFormat;
             data->info.mTTL = agent->mTTL;
 	    if (data->mThreadMode == kMode_Server)
@@ -276,6 +424,14 @@ ReportHeader* InitReport( thread_Settings *agent ) {
 	    } else {
 		data->info.mEnhanced = 0;
 	    }
+	    data->info.mReadHist = (isRecvMode( agent ) ? 1 : 0);
+	    data->info.mCPU = (isCPUAcct( agent ) ? 1 : 0);
+	    data->info.mTCPLatency = (!compact && !isUDP( agent ) ? 1 : 0);
+	    if ( isReorderWin( agent ) && isUDP( agent ) && agent->mThreadMode == kMode_Server ) {
+		data->info.seqwin = SeqWindow_Init( agent->mReorderWindow );
+	    }
+	    data->info.clockOffset = agent->mClockOffset;
+	    reporthdr->shm = StatsShm_Attach( reporthdr );
         } else {
             FAIL(1, "Out of Memory!!\n", agent);
         }
@@ -285,10 +441,8 @@ ReportHeader* InitReport( thread_Settings *agent ) {
             /*
              * Create in one big chunk
              */
-            reporthdr = malloc( sizeof(ReportHeader) );
+            reporthdr = report_alloc( 0 );
             if ( reporthdr != NULL ) {
-                // Only need to make sure the headers are clean
-                memset( reporthdr, 0, sizeof(ReportHeader));
                 data = &reporthdr->report;
                 data->info.transferID = agent->mSock;
                 data->info.groupID = -1;
@@ -368,7 +522,7 @@ void ReportPacket( ReportHeader* agent, ReportStruct *packet ) {
         /*
          * First find the appropriate place to put the information
          */
-        if ( agent->agentindex == NUM_REPORT_STRUCTS ) {
+        if ( agent->agentindex == agent->depth ) {
             // Just need to make sure that reporter is not on the first
             // item
             while ( index == 0 ) {
@@ -390,7 +544,11 @@ void ReportPacket( ReportHeader* agent, ReportStruct *packet ) {
         }
 
         // Put the information there
-        memcpy( agent->data + agent->agentindex, packet, sizeof(ReportStruct) );
+        if ( agent->events != NULL ) {
+            report_encode( agent, agent->events + agent->agentindex, packet );
+        } else {
+            memcpy( agent->data + agent->agentindex, packet, sizeof(ReportStruct) );
+        }
 
         // Updating agentindex MUST be the last thing done
         agent->agentindex++;
@@ -414,6 +572,9 @@ void CloseReport( ReportHeader *agent, ReportStruct *packet ) {
         /*
          * Using PacketID of -1 ends reporting
          */
+        if ( agent->report.cpu != NULL ) {
+            CPUAcct_End( agent->report.cpu );
+        }
 	currpktid = packet->packetID;
         packet->packetID = -1;
         packet->packetLen = 0;
@@ -422,6 +583,19 @@ void CloseReport( ReportHeader *agent, ReportStruct *packet ) {
     }
 }
 
+/*
+ * Sleep until the reporter has processed the agent's final packet
+ * event, the reporter signals the completion condition when it
+ * sets reporterindex to -1
+ */
+static void reporter_waitcompletion( ReportHeader *agent ) {
+    Condition_Lock( agent->completion );
+    while ( agent->reporterindex != -1 ) {
+        Condition_Wait( &agent->completion );
+    }
+    Condition_Unlock( agent->completion );
+}
+
 /*
  * EndReport signifies the agent no longer is interested
  * in the report. Calls to GetReport will no longer be
@@ -429,11 +603,10 @@ void CloseReport( ReportHeader *agent, ReportStruct *packet ) {
  */
 void EndReport( ReportHeader *agent ) {
     if ( agent != NULL ) {
-        int index = agent->reporterindex;
-        while ( index != -1 ) {
-            thread_rest();
-            index = agent->reporterindex;
-        }
+        reporter_waitcompletion( agent );
+        // the reporter is done with the condition, and will
+        // free the header once agentindex is -1
+        Condition_Destroy( &agent->completion );
         agent->agentindex = -1;
 #ifndef HAVE_THREAD
         /*
@@ -450,11 +623,7 @@ void EndReport( ReportHeader *agent ) {
  * by the reporter thread.
  */
 Transfer_Info *GetReport( ReportHeader *agent ) {
-    int index = agent->reporterindex;
-    while ( index != -1 ) {
-        thread_rest();
-        index = agent->reporterindex;
-    }
+    reporter_waitcompletion( agent );
     return &agent->report.info;
 }
 
@@ -467,7 +636,7 @@ void ReportSettings( thread_Settings *agent ) {
         /*
          * Create in one big chunk
          */
-        ReportHeader *reporthdr = malloc( sizeof(ReportHeader) );
+        ReportHeader *reporthdr = report_alloc( 0 );
 
         if ( reporthdr != NULL ) {
             ReporterData *data = &reporthdr->report;
@@ -516,6 +685,83 @@ void ReportSettings( thread_Settings *agent ) {
     }
 }
 
+/*
+ * The server_hdr codec, the UDP server's final statistics as relayed
+ * back to the client.  EncodeServerHdr fills in the header from the
+ * server's stats, with the extended fields when flags has HEADER_EXTEND,
+ * DecodeServerHdr reads it back into the client's copy of the stats.
+ */
+void EncodeServerHdr( Transfer_Info *stats, server_hdr *hdr, int flags ) {
+    hdr->base.flags        = htonl( (long) flags );
+    hdr->base.total_len1   = htonl( (long) (stats->TotalLen >> 32) );
+    hdr->base.total_len2   = htonl( (long) (stats->TotalLen & 0xFFFFFFFF) );
+    hdr->base.stop_sec     = htonl( (long) stats->endTime );
+    hdr->base.stop_usec    = htonl( (long)((stats->endTime - (long)stats->endTime) * rMillion));
+    hdr->base.error_cnt    = htonl( stats->cntError );
+    hdr->base.outorder_cnt = htonl( stats->cntOutofOrder );
+#ifndef HAVE_SEQNO64b
+    hdr->base.datagrams    = htonl( stats->cntDatagrams );
+#else
+    hdr->base.datagrams2   = htonl( (long) (stats->cntDatagrams >> 32) );
+    hdr->base.datagrams    = htonl( (long) (stats->cntDatagrams & 0xFFFFFFFF) );
+#endif
+    hdr->base.jitter1      = htonl( (long) stats->jitter );
+    hdr->base.jitter2      = htonl( (long) ((stats->jitter - (long)stats->jitter) * rMillion) );
+    if ( flags & HEADER_EXTEND ) {
+        hdr->extend.minTransit1  = htonl( (long) stats->transit.totminTransit );
+        hdr->extend.minTransit2  = htonl( (long) ((stats->transit.totminTransit - (long)stats->transit.totminTransit) * rMillion) );
+        hdr->extend.maxTransit1  = htonl( (long) stats->transit.totmaxTransit );
+        hdr->extend.maxTransit2  = htonl( (long) ((stats->transit.totmaxTransit - (long)stats->transit.totmaxTransit) * rMillion) );
+        hdr->extend.sumTransit1  = htonl( (long) stats->transit.totsumTransit );
+        hdr->extend.sumTransit2  = htonl( (long) ((stats->transit.totsumTransit - (long)stats->transit.totsumTransit) * rMillion) );
+        hdr->extend.meanTransit1  = htonl( (long) stats->transit.totmeanTransit );
+        hdr->extend.meanTransit2  = htonl( (long) ((stats->transit.totmeanTransit - (long)stats->transit.totmeanTransit) * rMillion) );
+        hdr->extend.m2Transit1  = htonl( (long) stats->transit.totm2Transit );
+        hdr->extend.m2Transit2  = htonl( (long) ((stats->transit.totm2Transit - (long)stats->transit.totm2Transit) * rMillion) );
+        hdr->extend.vdTransit1  = htonl( (long) stats->transit.totvdTransit );
+        hdr->extend.vdTransit2  = htonl( (long) ((stats->transit.totvdTransit - (long)stats->transit.totvdTransit) * rMillion) );
+        hdr->extend.cntTransit   = htonl( stats->transit.totcntTransit );
+        hdr->extend.IPGcnt = htonl( (long) (stats->cntDatagrams / (stats->endTime - stats->startTime)));
+        hdr->extend.IPGsum = htonl(1);
+    }
+}
+
+void DecodeServerHdr( server_hdr *server, Transfer_Info *stats ) {
+    stats->jitter = ntohl( server->base.jitter1 );
+    stats->jitter += ntohl( server->base.jitter2 ) / (double)rMillion;
+    stats->TotalLen = (((max_size_t) ntohl( server->base.total_len1 )) << 32) + \
+        ntohl( server->base.total_len2 );
+    stats->startTime = 0;
+    stats->endTime = ntohl( server->base.stop_sec );
+    stats->endTime += ntohl( server->base.stop_usec ) / (double)rMillion;
+    stats->cntError = ntohl( server->base.error_cnt );
+    stats->cntOutofOrder = ntohl( server->base.outorder_cnt );
+#ifndef HAVE_SEQNO64b
+    stats->cntDatagrams = ntohl( server->base.datagrams );
+#else
+    stats->cntDatagrams = (((max_size_t) ntohl( server->base.datagrams2 )) << 32) + \
+        ntohl( server->base.datagrams );
+#endif
+    if ((ntohl( server->base.flags ) & HEADER_EXTEND) != 0) {
+        stats->mEnhanced = 1;
+        stats->transit.minTransit = ntohl( server->extend.minTransit1 );
+        stats->transit.minTransit += ntohl( server->extend.minTransit2 ) / (double)rMillion;
+        stats->transit.maxTransit = ntohl( server->extend.maxTransit1 );
+        stats->transit.maxTransit += ntohl( server->extend.maxTransit2 ) / (double)rMillion;
+        stats->transit.sumTransit = ntohl( server->extend.sumTransit1 );
+        stats->transit.sumTransit += ntohl( server->extend.sumTransit2 ) / (double)rMillion;
+        stats->transit.meanTransit = ntohl( server->extend.meanTransit1 );
+        stats->transit.meanTransit += ntohl( server->extend.meanTransit2 ) / (double)rMillion;
+        stats->transit.m2Transit = ntohl( server->extend.m2Transit1 );
+        stats->transit.m2Transit += ntohl( server->extend.m2Transit2 ) / (double)rMillion;
+        stats->transit.vdTransit = ntohl( server->extend.vdTransit1 );
+        stats->transit.vdTransit += ntohl( server->extend.vdTransit2 ) / (double)rMillion;
+        stats->transit.cntTransit = ntohl( server->extend.cntTransit );
+        stats->IPGcnt = ntohl( server->extend.IPGcnt );
+        stats->IPGsum = ntohl( server->extend.IPGsum );
+    }
+}
+
 /*
  * ReportServerUDP will generate a report of the UDP
  * statistics as reported by the server on the client
@@ -528,12 +774,13 @@ void ReportServerUDP( thread_Settings *agent, server_hdr *server ) {
 	/*
 	 * Create in one big chunk
 	 */
-	ReportHeader *reporthdr = malloc( sizeof(ReportHeader) );
-	Transfer_Info *stats = &reporthdr->report.info;
+	ReportHeader *reporthdr = report_alloc( 0 );
+	Transfer_Info *stats;
 
 	if ( !reporthdr ) {
 	    FAIL(1, "Out of Memory!!\n", agent);
 	}
+	stats = &reporthdr->report.info;
 
 	stats->transferID = agent->mSock;
 	stats->groupID = (agent->multihdr != NULL ? agent->multihdr->groupID \
@@ -544,39 +791,7 @@ void ReportServerUDP( thread_Settings *agent, server_hdr *server ) {
 	reporthdr->report.type = SERVER_RELAY_REPORT;
 	reporthdr->report.mode = agent->mReportMode;
 	stats->mFormat = agent->mFormat;
-	stats->jitter = ntohl( server->base.jitter1 );
-	stats->jitter += ntohl( server->base.jitter2 ) / (double)rMillion;
-	stats->TotalLen = (((max_size_t) ntohl( server->base.total_len1 )) << 32) + \
-	    ntohl( server->base.total_len2 );
-	stats->startTime = 0;
-	stats->endTime = ntohl( server->base.stop_sec );
-	stats->endTime += ntohl( server->base.stop_usec ) / (double)rMillion;
-	stats->cntError = ntohl( server->base.error_cnt );
-	stats->cntOutofOrder = ntohl( server->base.outorder_cnt );
-#ifndef HAVE_SEQNO64b
-	stats->cntDatagrams = ntohl( server->base.datagrams );
-#else
-	stats->cntDatagrams = (((max_size_t) ntohl( server->base.datagrams2 )) << 32) + \
-	    ntohl( server->base.datagrams );
-#endif
-	if ((flags & HEADER_EXTEND) != 0) {
-	    stats->mEnhanced = 1;
-	    stats->transit.minTransit = ntohl( server->extend.minTransit1 );
-	    stats->transit.minTransit += ntohl( server->extend.minTransit2 ) / (double)rMillion;
-	    stats->transit.maxTransit = ntohl( server->extend.maxTransit1 );
-	    stats->transit.maxTransit += ntohl( server->extend.maxTransit2 ) / (double)rMillion;
-	    stats->transit.sumTransit = ntohl( server->extend.sumTransit1 );
-	    stats->transit.sumTransit += ntohl( server->extend.sumTransit2 ) / (double)rMillion;
-	    stats->transit.meanTransit = ntohl( server->extend.meanTransit1 );
-	    stats->transit.meanTransit += ntohl( server->extend.meanTransit2 ) / (double)rMillion;
-	    stats->transit.m2Transit = ntohl( server->extend.m2Transit1 );
-	    stats->transit.m2Transit += ntohl( server->extend.m2Transit2 ) / (double)rMillion;
-	    stats->transit.vdTransit = ntohl( server->extend.vdTransit1 );
-	    stats->transit.vdTransit += ntohl( server->extend.vdTransit2 ) / (double)rMillion;
-	    stats->transit.cntTransit = ntohl( server->extend.cntTransit );
-	    stats->IPGcnt = ntohl( server->extend.IPGcnt );
-	    stats->IPGsum = ntohl( server->extend.IPGsum );
-	}
+	DecodeServerHdr( server, stats );
 	stats->mUDP = (char)kMode_Server;
 	reporthdr->report.connection.peer = agent->local;
 	reporthdr->report.connection.size_peer = agent->size_local;
@@ -603,11 +818,60 @@ void ReportServerUDP( thread_Settings *agent, server_hdr *server ) {
 }
 
 
+/*
+ * One pass over the report list, handing each report the packet
+ * events queued so far and freeing the reports that are done.
+ * Returns nonzero if reports remain.  The reporter thread loops on
+ * this, the lwIP run-to-completion loop calls it inline since it has
+ * no reporter thread.
+ */
+int reporter_poll( void ) {
+again:
+    if ( ReportRoot != NULL ) {
+        ReportHeader *temp = ReportRoot;
+        //Condition_Unlock ( ReportCond );
+        if ( reporter_process_report ( temp ) ) {
+            // This section allows for more reports to be added while
+            // the reporter is processing reports without needing to
+            // stop the reporter or immediately notify it
+            Condition_Lock ( ReportCond );
+            if ( temp == ReportRoot ) {
+                // no new reports
+                ReportRoot = temp->next;
+            } else {
+                // new reports added
+                ReportHeader *itr = ReportRoot;
+                while ( itr->next != temp ) {
+                    itr = itr->next;
+                }
+                itr->next = temp->next;
+            }
+            // finished with report so free it
+            report_free( temp );
+            Condition_Unlock ( ReportCond );
+            Condition_Signal( &ReportDoneCond );
+            if (ReportRoot)
+                goto again;
+            return 0;
+        }
+        Condition_Signal( &ReportDoneCond );
+        return 1;
+    }
+    return 0;
+}
+
 /*
  * This function is called only when the reporter thread
  * This function is the loop that the reporter thread processes
  */
+static CPUAcct *reporter_cpu = NULL;
+static struct timeval reporter_start;
+
 void reporter_spawn( thread_Settings *thread ) {
+    if ( isCPUAcct( thread ) ) {
+        reporter_cpu = CPUAcct_Open( );
+        gettimeofday( &reporter_start, NULL );
+    }
     do {
         // This section allows for safe exiting with Ctrl-C
         Condition_Lock ( ReportCond );
@@ -620,34 +884,7 @@ void reporter_spawn( thread_Settings *thread ) {
         }
         Condition_Unlock ( ReportCond );
 
-again:
-        if ( ReportRoot != NULL ) {
-            ReportHeader *temp = ReportRoot;
-            //Condition_Unlock ( ReportCond );
-            if ( reporter_process_report ( temp ) ) {
-                // This section allows for more reports to be added while
-                // the reporter is processing reports without needing to
-                // stop the reporter or immediately notify it
-                Condition_Lock ( ReportCond );
-                if ( temp == ReportRoot ) {
-                    // no new reports
-                    ReportRoot = temp->next;
-                } else {
-                    // new reports added
-                    ReportHeader *itr = ReportRoot;
-                    while ( itr->next != temp ) {
-                        itr = itr->next;
-                    }
-                    itr->next = temp->next;
-                }
-                // finished with report so free it
-                free( temp );
-                Condition_Unlock ( ReportCond );
-                Condition_Signal( &ReportDoneCond );
-                if (ReportRoot)
-                    goto again;
-            }
-            Condition_Signal( &ReportDoneCond );
+        if ( reporter_poll() ) {
 	    /*
 	     * Suspend the reporter thread for 10 milliseconds
 	     *
@@ -703,7 +940,7 @@ again:
 void process_report ( ReportHeader *report ) {
     if ( report != NULL ) {
         if ( reporter_process_report( report ) ) {
-            free( report );
+            report_free( report );
         }
     }
 }
@@ -720,7 +957,7 @@ int reporter_process_report ( ReportHeader *reporthdr ) {
             // If we are done with this report then free it
             ReportHeader *temp = reporthdr->next;
             reporthdr->next = reporthdr->next->next;
-            free( temp );
+            report_free( temp );
         }
     }
 
@@ -747,7 +984,7 @@ int reporter_process_report ( ReportHeader *reporthdr ) {
         if ( reporthdr->reporterindex >= 0 ) {
             // Need to make sure we do not pass the "agent"
             while ( reporthdr->reporterindex != reporthdr->agentindex - 1 ) {
-                if ( reporthdr->reporterindex == NUM_REPORT_STRUCTS - 1 ) {
+                if ( reporthdr->reporterindex == reporthdr->depth - 1 ) {
                     if ( reporthdr->agentindex == 0 ) {
                         break;
                     } else {
@@ -757,30 +994,176 @@ int reporter_process_report ( ReportHeader *reporthdr ) {
                     reporthdr->reporterindex++;
                 }
                 if ( reporter_handle_packet( reporthdr ) ) {
-                    // No more packets to process
+                    // No more packets to process, wake the agent
+                    // if it's waiting in EndReport or GetReport
+                    Condition_Lock( reporthdr->completion );
                     reporthdr->reporterindex = -1;
+                    Condition_Broadcast( &reporthdr->completion );
+                    Condition_Unlock( reporthdr->completion );
                     break;
                 }
             }
+            if ( reporthdr->shm != NULL ) {
+                StatsShm_Publish( reporthdr->shm, reporthdr );
+            }
         }
         // If the agent is done with the report then free it
         if ( reporthdr->agentindex == -1 ) {
+            if ( reporthdr->shm != NULL ) {
+                StatsShm_Detach( reporthdr->shm );
+                reporthdr->shm = NULL;
+            }
+            CPUAcct_Close( reporthdr->report.cpu );
+            reporthdr->report.cpu = NULL;
+            SeqWindow_Free( reporthdr->report.info.seqwin );
+            reporthdr->report.info.seqwin = NULL;
             need_free = 1;
         }
     }
     return need_free;
 }
 
+void reporter_print_cpu( void ) {
+    CPUStats cpu;
+    struct timeval now;
+    double secs;
+
+    if ( reporter_cpu == NULL ) {
+        return;
+    }
+    CPUAcct_Sample( reporter_cpu, &cpu, 1 );
+    gettimeofday( &now, NULL );
+    secs = TimeDifference( now, reporter_start );
+    printf( report_cpu_reporter, secs, (secs > 0) ? 100.0 * cpu.cpuSecs / secs : 0.0 );
+    if ( cpu.counters ) {
+        printf( report_cpu_reporter_counters, cpu.count[CPUACCT_CYCLES], cpu.count[CPUACCT_CTXSWITCHES] );
+    }
+    printf( "\n" );
+    fflush( stdout );
+}
+
+/*
+ * Folds one latency sample, in seconds, into the transit stats and
+ * the jitter, for the UDP server's datagrams and the --write-latency
+ * TCP server's write stamps
+ */
+static void reporter_handle_transit( Transfer_Info *stats, double transit ) {
+    double deltaTransit;
+    double usec_transit;
+
+    if (stats->transit.totcntTransit == 0) {
+	// Very first packet
+	stats->transit.minTransit = transit;
+	stats->transit.maxTransit = transit;
+	stats->transit.sumTransit = transit;
+	stats->transit.cntTransit = 1;
+	stats->transit.totminTransit = transit;
+	stats->transit.totmaxTransit = transit;
+	stats->transit.totsumTransit = transit;
+	stats->transit.totcntTransit = 1;
+	// For variance, working units is microseconds
+	usec_transit = transit * 1e6;
+	stats->transit.vdTransit = usec_transit;
+	stats->transit.meanTransit = usec_transit;
+	stats->transit.m2Transit = usec_transit * usec_transit;
+	stats->transit.totvdTransit = usec_transit;
+	stats->transit.totmeanTransit = usec_transit;
+	stats->transit.totm2Transit = usec_transit * usec_transit;
+    } else {
+	// from RFC 1889, Real Time Protocol (RTP)
+	// J = J + ( | D(i-1,i) | - J ) /
+	// Compute jitter
+	deltaTransit = transit - stats->transit.lastTransit;
+	if ( deltaTransit < 0.0 ) {
+	    deltaTransit = -deltaTransit;
+	}
+	stats->jitter += (deltaTransit - stats->jitter) / (16.0);
+	// Compute end/end delay stats
+	stats->transit.sumTransit += transit;
+	stats->transit.cntTransit++;
+	stats->transit.totsumTransit += transit;
+	stats->transit.totcntTransit++;
+	// mean min max tests
+	if (transit < stats->transit.minTransit) {
+	    stats->transit.minTransit=transit;
+	}
+	if (transit < stats->transit.totminTransit) {
+	    stats->transit.totminTransit=transit;
+	}
+	if (transit > stats->transit.maxTransit) {
+	    stats->transit.maxTransit=transit;
+	}
+	if (transit > stats->transit.totmaxTransit) {
+	    stats->transit.totmaxTransit=transit;
+	}
+	// For variance, working units is microseconds
+	// variance interval
+	usec_transit = transit * 1e6;
+	stats->transit.vdTransit = usec_transit - stats->transit.meanTransit;
+	stats->transit.meanTransit = stats->transit.meanTransit + (stats->transit.vdTransit / stats->transit.cntTransit);
+	stats->transit.m2Transit = stats->transit.m2Transit + (stats->transit.vdTransit * (usec_transit - stats->transit.meanTransit));
+	// variance total
+	stats->transit.totvdTransit = usec_transit - stats->transit.totmeanTransit;
+	stats->transit.totmeanTransit = stats->transit.totmeanTransit + (stats->transit.totvdTransit / stats->transit.totcntTransit);
+	stats->transit.totm2Transit = stats->transit.totm2Transit + (stats->transit.totvdTransit * (usec_transit - stats->transit.totmeanTransit));
+    }
+    stats->transit.lastTransit = transit;
+}
+
+/*
+ * Ends --warmup once the stream is that many secs or bytes in.  The
+ * counts so far are kept to be taken off the final report and the
+ * running totals behind it, which have no last values to diff
+ * against, start over.
+ */
+static void reporter_handle_warmup( ReportHeader *reporthdr ) {
+    ReporterData *data = &reporthdr->report;
+    Transfer_Info *stats = &reporthdr->report.info;
+    double elapsed = TimeDifference( data->packetTime, data->startTime );
+
+    if ( (data->mWarmupSecs > 0) ? (elapsed < data->mWarmupSecs) :
+	 (data->TotalLen < data->mWarmupBytes) )
+	return;
+    data->warmedUp = 1;
+    // a time is the same for every stream so their SUM lines up
+    data->warmupTime = (data->mWarmupSecs > 0) ? data->mWarmupSecs : elapsed;
+    data->warmupTotal = data->TotalLen;
+    data->warmupDatagrams = (stats->mUDP == kMode_Server) ? data->PacketID : data->cntDatagrams;
+    data->warmupError = data->cntError;
+    data->warmupOutofOrder = data->cntOutofOrder;
+    data->warmupDuplicate = data->cntDuplicate;
+    data->warmupTooLate = data->cntTooLate;
+    if ( reporthdr->multireport != NULL && reporthdr->multireport->warmupTime == 0 ) {
+	reporthdr->multireport->warmupTime = data->warmupTime;
+    }
+    stats->transit.totcntTransit = 0;
+    if ( stats->mTCP == kMode_Client ) {
+	stats->tcp.write.totWriteCnt = 0;
+	stats->tcp.write.totWriteErr = 0;
+	stats->tcp.write.totTCPretry = 0;
+    } else if ( stats->mTCP == kMode_Server ) {
+	stats->tcp.read.totcntRead = 0;
+	memset( stats->tcp.read.totbins, 0, sizeof(stats->tcp.read.totbins) );
+	memset( stats->tcp.read.totlog2bins, 0, sizeof(stats->tcp.read.totlog2bins) );
+    }
+}
+
 /*
  * Updates connection stats
  */
 int reporter_handle_packet( ReportHeader *reporthdr ) {
-    ReportStruct *packet = &reporthdr->data[reporthdr->reporterindex];
+    ReportStruct decoded;
+    ReportStruct *packet;
     ReporterData *data = &reporthdr->report;
     Transfer_Info *stats = &reporthdr->report.info;
     int finished = 0;
-    double usec_transit;
 
+    if ( reporthdr->events != NULL ) {
+        packet = &decoded;
+        report_decode( reporthdr, &reporthdr->events[reporthdr->reporterindex], packet );
+    } else {
+        packet = &reporthdr->data[reporthdr->reporterindex];
+    }
     data->packetTime = packet->packetTime;
     stats->socket = packet->socket;
     if ( packet->packetID < 0 ) {
@@ -802,10 +1185,30 @@ int reporter_handle_packet( ReportHeader *reporthdr ) {
 		if (stats->mUDP == kMode_Server) {
 		    //subsequent packets
 		    double transit;
-		    double deltaTransit;
-		    transit = TimeDifference( packet->packetTime, packet->sentTime );
-		    // packet loss occured if the datagram numbers aren't sequential
-		    if ( packet->packetID != data->PacketID + 1 ) {
+		    // sentTime is in the client's clock, move it to ours
+		    transit = TimeDifference( packet->packetTime, packet->sentTime ) + stats->clockOffset;
+		    if ( stats->seqwin != NULL ) {
+			// --reorder-window tells late datagrams from duplicates,
+			// the gaps still count as errors until filled in
+			switch ( SeqWindow_Add( stats->seqwin, packet->packetID ) ) {
+			case kSeq_New:
+			    if ( packet->packetID > data->PacketID + 1 ) {
+				data->cntError += packet->packetID - data->PacketID - 1;
+			    }
+			    data->PacketID = packet->packetID;
+			    break;
+			case kSeq_Late:
+			    data->cntOutofOrder++;
+			    break;
+			case kSeq_Duplicate:
+			    data->cntDuplicate++;
+			    break;
+			default:
+			    data->cntTooLate++;
+			    break;
+			}
+		    } else if ( packet->packetID != data->PacketID + 1 ) {
+			// packet loss occured if the datagram numbers aren't sequential
 			if (packet->packetID < data->PacketID + 1 ) {
 			    data->cntOutofOrder++;
 			} else {
@@ -816,83 +1219,42 @@ int reporter_handle_packet( ReportHeader *reporthdr ) {
 		    if ( packet->packetID > data->PacketID ) {
 			data->PacketID = packet->packetID;
 		    }
-		    if (stats->transit.totcntTransit == 0) {
-			// Very first packet
-			stats->transit.minTransit = transit;
-			stats->transit.maxTransit = transit;
-			stats->transit.sumTransit = transit;
-			stats->transit.cntTransit = 1;
-			stats->transit.totminTransit = transit;
-			stats->transit.totmaxTransit = transit;
-			stats->transit.totsumTransit = transit;
-			stats->transit.totcntTransit = 1;
-			// For variance, working units is microseconds
-			usec_transit = transit * 1e6;
-			stats->transit.vdTransit = usec_transit;
-			stats->transit.meanTransit = usec_transit;
-			stats->transit.m2Transit = usec_transit * usec_transit;
-			stats->transit.totvdTransit = usec_transit;
-			stats->transit.totmeanTransit = usec_transit;
-			stats->transit.totm2Transit = usec_transit * usec_transit;
-		    } else {
-			// from RFC 1889, Real Time Protocol (RTP)
-			// J = J + ( | D(i-1,i) | - J ) /
-			// Compute jitter
-			deltaTransit = transit - stats->transit.lastTransit;
-			if ( deltaTransit < 0.0 ) {
-			    deltaTransit = -deltaTransit;
-			}
-			stats->jitter += (deltaTransit - stats->jitter) / (16.0);
-			// Compute end/end delay stats
-			stats->transit.sumTransit += transit;
-			stats->transit.cntTransit++;
-			stats->transit.totsumTransit += transit;
-			stats->transit.totcntTransit++;
-			// mean min max tests
-			if (transit < stats->transit.minTransit) {
-			    stats->transit.minTransit=transit;
-			}
-			if (transit < stats->transit.totminTransit) {
-			    stats->transit.totminTransit=transit;
-			}
-			if (transit > stats->transit.maxTransit) {
-			    stats->transit.maxTransit=transit;
-			}
-			if (transit > stats->transit.totmaxTransit) {
-			    stats->transit.totmaxTransit=transit;
-			}
-			// For variance, working units is microseconds
-			// variance interval
-			usec_transit = transit * 1e6;
-			stats->transit.vdTransit = usec_transit - stats->transit.meanTransit;
-			stats->transit.meanTransit = stats->transit.meanTransit + (stats->transit.vdTransit / stats->transit.cntTransit);
-			stats->transit.m2Transit = stats->transit.m2Transit + (stats->transit.vdTransit * (usec_transit - stats->transit.meanTransit));
-			// variance total
-			stats->transit.totvdTransit = usec_transit - stats->transit.totmeanTransit;
-			stats->transit.totmeanTransit = stats->transit.totmeanTransit + (stats->transit.totvdTransit / stats->transit.totcntTransit);
-			stats->transit.totm2Transit = stats->transit.totm2Transit + (stats->transit.totvdTransit * (usec_transit - stats->transit.totmeanTransit));
-		    }
-		    stats->transit.lastTransit = transit;
+		    reporter_handle_transit( stats, transit );
 		}
+	    } else if (stats->mTCPLatency && packet->sentTime.tv_sec != 0) {
+		// a --write-latency stamp, the read itself is its own event
+		reporter_handle_transit( stats, TimeDifference( packet->packetTime, packet->sentTime ) +
+					 stats->clockOffset );
 	    } else if (reporthdr->report.mThreadMode == kMode_Server && (packet->packetLen > 0)) {
 		int bin;
+		umax_size_t len;
 		// mean min max tests
 		stats->tcp.read.cntRead++;
 		stats->tcp.read.totcntRead++;
 		bin = (int)floor((packet->packetLen -1)/stats->tcp.read.binsize);
 		stats->tcp.read.bins[bin]++;
 		stats->tcp.read.totbins[bin]++;
+		// log scale bins, independent of the -l based bins above
+		for (bin = 0, len = packet->packetLen >> 1; len && bin < READ_LOG2BINS - 1; len >>= 1) {
+		    bin++;
+		}
+		stats->tcp.read.log2bins[bin]++;
+		stats->tcp.read.totlog2bins[bin]++;
 	    } else if (reporthdr->report.mThreadMode == kMode_Client) {
+		// an aggregated event carries its writes' count and
+		// at most the one failed write that ended it
+		stats->tcp.write.WriteCnt += packet->writeCnt;
+		stats->tcp.write.totWriteCnt += packet->writeCnt;
 		if (packet->errwrite) {
 		    stats->tcp.write.WriteErr++;
 		    stats->tcp.write.totWriteErr++;
 		}
-		else {
+		else if (packet->writeCnt == 0) {
 		    stats->tcp.write.WriteCnt++;
 		    stats->tcp.write.totWriteCnt++;
 		}
 	    }
-	} else if ((stats->mUDP == kMode_Server) &&	\
+	} else if ((stats->mUDP == kMode_Server || stats->mTCPLatency) &&	\
 		   (stats->transit.cntTransit == 0)) {
 	    // This is the case when empty reports
 	    // cross the report interval boundary
@@ -906,6 +1268,11 @@ int reporter_handle_packet( ReportHeader *reporthdr ) {
 	    stats->transit.m2Transit = 0;
 	}
     }
+    // the packet that ends the warm-up is still part of it
+    if ( !finished && !packet->emptyreport && !data->warmedUp &&
+	 (data->mWarmupSecs > 0 || data->mWarmupBytes > 0) ) {
+	reporter_handle_warmup( reporthdr );
+    }
     // Print a report if appropriate
     return reporter_condprintstats( &reporthdr->report, reporthdr->multireport, finished );
 }
@@ -939,6 +1306,7 @@ void reporter_handle_multiple_reports( MultiHeader *reporthdr, Transfer_Info *st
                 current->TotalLen = stats->TotalLen;
                 current->mFormat = stats->mFormat;
                 current->mEnhanced = stats->mEnhanced;
+                current->mCPU = stats->mCPU;
                 current->endTime = stats->endTime;
                 current->jitter = stats->jitter;
                 current->startTime = stats->startTime;
@@ -953,6 +1321,10 @@ void reporter_handle_multiple_reports( MultiHeader *reporthdr, Transfer_Info *st
 		    for (ix = 0; ix < 8; ix++) {
 			current->tcp.read.bins[ix] = stats->tcp.read.bins[ix];
 		    }
+		    for (ix = 0; ix < READ_LOG2BINS; ix++) {
+			current->tcp.read.log2bins[ix] = stats->tcp.read.log2bins[ix];
+		    }
+		    current->mReadHist = stats->mReadHist;
 		} else if (stats->mTCP == kMode_Client) {
 		    current->tcp.write.WriteErr = stats->tcp.write.WriteErr;
 		    current->tcp.write.WriteCnt = stats->tcp.write.WriteCnt;
@@ -973,6 +1345,9 @@ void reporter_handle_multiple_reports( MultiHeader *reporthdr, Transfer_Info *st
 		    for (ix = 0; ix < 8; ix++) {
 			current->tcp.read.bins[ix] += stats->tcp.read.bins[ix];
 		    }
+		    for (ix = 0; ix < READ_LOG2BINS; ix++) {
+			current->tcp.read.log2bins[ix] += stats->tcp.read.log2bins[ix];
+		    }
 		} else if (stats->mTCP == kMode_Client) {
 		    current->tcp.write.WriteErr += stats->tcp.write.WriteErr;
 		    current->tcp.write.WriteCnt += stats->tcp.write.WriteCnt;
@@ -1031,7 +1406,12 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
 #ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
 	gettcpistats(stats);
 #endif
+	if ( stats->cpu != NULL ) {
+	    CPUAcct_Sample( stats->cpu, &stats->info.cpu, 1 );
+	}
         stats->info.cntOutofOrder = stats->cntOutofOrder;
+        stats->info.cntDuplicate = stats->cntDuplicate;
+        stats->info.cntTooLate = stats->cntTooLate;
         // assume most of the time out-of-order packets are not
         // duplicate packets, so conditionally subtract them from the lost packets.
         stats->info.cntError = stats->cntError;
@@ -1043,6 +1423,21 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
         stats->info.TotalLen = stats->TotalLen;
         stats->info.startTime = 0;
         stats->info.endTime = TimeDifference( stats->packetTime, stats->startTime );
+        if ( stats->warmedUp ) {
+            // the final report starts where --warmup ended
+            stats->info.cntOutofOrder -= stats->warmupOutofOrder;
+            stats->info.cntDuplicate -= stats->warmupDuplicate;
+            stats->info.cntTooLate -= stats->warmupTooLate;
+            stats->info.cntError = stats->cntError - stats->warmupError - stats->info.cntOutofOrder;
+            if ( stats->info.cntError < 0 ) {
+                stats->info.cntError = 0;
+            }
+            stats->info.cntDatagrams -= stats->warmupDatagrams;
+            stats->info.TotalLen -= stats->warmupTotal;
+            stats->info.startTime = stats->warmupTime;
+        } else if ( stats->mWarmupSecs > 0 || stats->mWarmupBytes > 0 ) {
+            fprintf( stderr, warn_warmup_short, stats->info.transferID );
+        }
 	stats->info.transit.minTransit = stats->info.transit.totminTransit;
 	stats->info.transit.maxTransit = stats->info.transit.totmaxTransit;
 	stats->info.transit.cntTransit = stats->info.transit.totcntTransit;
@@ -1061,8 +1456,13 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
 	    for (ix = 0; ix < 8; ix++) {
 		stats->info.tcp.read.bins[ix] = stats->info.tcp.read.totbins[ix];
 	    }
+	    for (ix = 0; ix < READ_LOG2BINS; ix++) {
+		stats->info.tcp.read.log2bins[ix] = stats->info.tcp.read.totlog2bins[ix];
+	    }
 	}
-	if (stats->info.endTime > 0) {
+	if (stats->warmedUp && stats->info.endTime > stats->info.startTime) {
+	    stats->info.IPGcnt = (int) (stats->info.cntDatagrams / (stats->info.endTime - stats->info.startTime));
+	} else if (stats->info.endTime > 0) {
 	    stats->info.IPGcnt = (int) (stats->cntDatagrams / stats->info.endTime);
 	} else {
 	    stats->info.IPGcnt = 0;
@@ -1072,8 +1472,19 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
 
         reporter_print( stats, TRANSFER_REPORT, force );
         if ( isMultipleReport(stats) ) {
+            // the SUM keys its slots on the start, make it the same
+            // for every stream of the group
+            if ( stats->warmedUp && multireport != NULL ) {
+                stats->info.startTime = multireport->warmupTime;
+            }
             reporter_handle_multiple_reports( multireport, &stats->info, force );
         }
+        if ( stats->mTarget > 0 ) {
+            Fanout_Account( stats );
+        }
+        if ( stats->mSweepStep > 0 ) {
+            Sweep_Account( stats );
+        }
     } else while ((stats->intervalTime.tv_sec != 0 ||
                    stats->intervalTime.tv_usec != 0) &&
                   TimeDifference( stats->nextTime,
@@ -1081,10 +1492,18 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
 #ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
 	    gettcpistats(stats);
 #endif
+	    if ( stats->cpu != NULL ) {
+		CPUAcct_Sample( stats->cpu, &stats->info.cpu, 0 );
+	    }
 	    stats->info.cntOutofOrder = stats->cntOutofOrder - stats->lastOutofOrder;
 	    stats->lastOutofOrder = stats->cntOutofOrder;
+	    stats->info.cntDuplicate = stats->cntDuplicate - stats->lastDuplicate;
+	    stats->lastDuplicate = stats->cntDuplicate;
+	    stats->info.cntTooLate = stats->cntTooLate - stats->lastTooLate;
+	    stats->lastTooLate = stats->cntTooLate;
 	    // assume most of the  time out-of-order packets are not
 	    // duplicate packets, so conditionally subtract them from the lost packets.
+	    // With --reorder-window duplicates are counted apart so they never are.
 	    stats->info.cntError = stats->cntError - stats->lastError;
 	    stats->info.cntError -= stats->info.cntOutofOrder;
 	    if ( stats->info.cntError < 0) {
@@ -1112,7 +1531,8 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
 		stats->info.IPGcnt = 0;
 		stats->info.IPGsum = 0;
 	    }
-	    if (stats->info.mEnhanced) {
+	    // --cpu needs per interval reads and writes for cycles/packet
+	    if (stats->info.mEnhanced || stats->cpu != NULL) {
 		if (stats->info.mTCP == (char)kMode_Client) {
 		    stats->info.tcp.write.WriteCnt = 0;
 		    stats->info.tcp.write.WriteErr = 0;
@@ -1124,6 +1544,10 @@ int reporter_condprintstats( ReporterData *stats, MultiHeader *multireport, int
 		    }
 		}
 	    }
+	    if (stats->info.mReadHist && stats->info.mTCP == (char)kMode_Server) {
+		stats->info.tcp.read.cntRead = 0;
+		memset(stats->info.tcp.read.log2bins, 0, sizeof(stats->info.tcp.read.log2bins));
+	    }
 	}
     return force;
 }
@@ -0,0 +1,91 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * SeqWindow.c
+ * -------------------------------------------------------------------
+ * Setup for the --reorder-window sequence number window, the per
+ * datagram classification is inline in SeqWindow.h
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "util.h"
+#include "SeqWindow.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SeqWindow* SeqWindow_Init( int size ) {
+    SeqWindow *win;
+    max_size_t slots = SEQWINDOW_MIN;
+
+    while ( slots < size && slots < SEQWINDOW_MAX )
+	slots <<= 1;
+    win = (SeqWindow *) calloc( 1, sizeof(SeqWindow) );
+    if ( win == NULL ) {
+	WARN( 1, "Out of memory for the reorder window" );
+	return NULL;
+    }
+    win->mask = slots - 1;
+    win->bits = (uint64_t *) calloc( slots >> 6, sizeof(uint64_t) );
+    if ( win->bits == NULL ) {
+	WARN( 1, "Out of memory for the reorder window" );
+	free( win );
+	return NULL;
+    }
+    return win;
+}
+
+void SeqWindow_Free( SeqWindow *win ) {
+    if ( win == NULL )
+	return;
+    free( win->bits );
+    free( win );
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
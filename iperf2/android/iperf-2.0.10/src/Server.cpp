@@ -61,6 +61,7 @@
 #include "Extractor.h"
 #include "Reporter.h"
 #include "Locale.h"
+#include "IOUring.h"
 #ifdef HAVE_SCHED_SETSCHEDULER
 #include <sched.h>
 #endif
@@ -75,6 +76,11 @@
 Server::Server( thread_Settings *inSettings ) {
     mSettings = inSettings;
     mBuf = NULL;
+    mBuckets = NULL;
+    mStreamOffset = 0;
+    mStampNext = 0;
+    mStampHave = 0;
+    mPayload = NULL;
     // initialize buffer, length checking done by the Listener
     mBuf = new char[((mSettings->mBufLen > SIZEOF_MAXHDRMSG) ? mSettings->mBufLen : SIZEOF_MAXHDRMSG)];
     FAIL_errno( mBuf == NULL, "No memory for buffer\n", mSettings );
@@ -91,26 +97,208 @@ Server::~Server() {
         mSettings->mSock = INVALID_SOCKET;
     }
     DELETE_ARRAY( mBuf );
+    Payload_Free( mPayload );
 }
 
 void Server::Sig_Int( int inSigno ) {
 }
+/* -------------------------------------------------------------------
+ * --busy-poll: have the kernel busy poll the device queue for the
+ * socket's receives rather than sleep on an interrupt, and prefer
+ * that over the softirq when the socket is being polled.
+ * ------------------------------------------------------------------- */
+void Server::BusyPollInit( void ) {
+#if HAVE_DECL_SO_BUSY_POLL
+    int usecs = mSettings->mBusyPollUsecs;
+    int rc = setsockopt( mSettings->mSock, SOL_SOCKET, SO_BUSY_POLL,
+                         (char*) &usecs, sizeof(usecs));
+    WARN_errno( rc == SOCKET_ERROR, "setsockopt SO_BUSY_POLL" );
+#ifdef SO_PREFER_BUSY_POLL
+    int prefer = 1;
+    rc = setsockopt( mSettings->mSock, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+                     (char*) &prefer, sizeof(prefer));
+    WARN_errno( rc == SOCKET_ERROR, "setsockopt SO_PREFER_BUSY_POLL" );
+#endif
+#endif
+}
+
+/*
+ * A receive for --busy-poll, recv() or, given a message, recvmsg().
+ * Spins on MSG_DONTWAIT reads until one returns data or a real error,
+ * then after mBusySpinUsecs of empty reads falls back to the blocking
+ * read and so to SO_RCVTIMEO.  With no spin budget it never blocks,
+ * returning the EAGAIN every BUSYPOLL_YIELD_USECS instead, which the
+ * callers treat like a read timeout.
+ */
+long Server::BusyRecv( void *buf, int len, struct msghdr *message, int flags ) {
+    long rc;
+#if HAVE_DECL_SO_BUSY_POLL
+    long budget = (mSettings->mBusySpinUsecs > 0) ? mSettings->mBusySpinUsecs : BUSYPOLL_YIELD_USECS;
+    size_t controllen = (message != NULL) ? message->msg_controllen : 0;
+    struct timespec t0, t1;
+    int spins = 0;
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    while ( 1 ) {
+        if ( message != NULL ) {
+            message->msg_controllen = controllen;
+            rc = recvmsg( mSettings->mSock, message, flags | MSG_DONTWAIT );
+        } else {
+            rc = recv( mSettings->mSock, buf, len, flags | MSG_DONTWAIT );
+        }
+        if ( rc >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK) ) {
+            return rc;
+        }
+        // only look at the clock every 64 empty reads
+        if ( (++spins & 0x3f) == 0 ) {
+            clock_gettime( CLOCK_MONOTONIC, &t1 );
+            if ( (t1.tv_sec - t0.tv_sec) * 1000000L + (t1.tv_nsec - t0.tv_nsec) / 1000 >= budget ) {
+                break;
+            }
+        }
+    }
+    if ( mSettings->mBusySpinUsecs == 0 ) {
+        return rc;
+    }
+#endif
+    if ( message != NULL ) {
+        rc = recvmsg( mSettings->mSock, message, flags );
+    } else {
+        rc = recv( mSettings->mSock, buf, len, flags );
+    }
+    return rc;
+}
+
 /* -------------------------------------------------------------------
  * Receive TCP data from the (connected) socket.
  * Sends termination flag several times at the end.
  * Does not close the socket.
  * ------------------------------------------------------------------- */
+/* -------------------------------------------------------------------
+ * --write-latency: each of the client's writes starts with a
+ * tcp_write_stamp carrying the write's length and start time.  Walk
+ * the stamps in this read, one may straddle reads, and post each as
+ * a zero length event with the read's arrival time so the reporter
+ * can take the write to read latency.  A bad stamp means the stream
+ * offsets are off, e.g. a lost --clock-sync reply, so give up.
+ * ------------------------------------------------------------------- */
+void Server::ReadStamps( const char *buf, long len, ReportStruct *reportstruct ) {
+    ReportStruct stampstruct;
+    long start;
+    int n;
+
+    while ( (start = (long) (mStampNext + mStampHave - mStreamOffset)) < len ) {
+	n = sizeof(tcp_write_stamp) - mStampHave;
+	if ( n > len - start )
+	    n = len - start;
+	memcpy( (char *) &mStamp + mStampHave, buf + start, n );
+	mStampHave += n;
+	if ( mStampHave < (int) sizeof(tcp_write_stamp) )
+	    break;
+	if ( ntohl( mStamp.magic ) != WRITESTAMP_MAGIC ||
+	     ntohl( mStamp.len ) < sizeof(tcp_write_stamp) ) {
+	    fprintf( stderr, warn_write_stamp_lost, mSettings->mSock );
+	    unsetWriteLatency( mSettings );
+	    break;
+	}
+	stampstruct = *reportstruct;
+	stampstruct.packetLen = 0;
+	stampstruct.sentTime.tv_sec = ntohl( mStamp.tv_sec );
+	stampstruct.sentTime.tv_usec = ntohl( mStamp.tv_usec );
+	ReportPacket( mSettings->reporthdr, &stampstruct );
+	mStampNext += ntohl( mStamp.len );
+	mStampHave = 0;
+    }
+    mStreamOffset += len;
+}
+
+/* -------------------------------------------------------------------
+ * --verify: the client's --payload is rebuilt here from the mode in
+ * its header, so every byte read past the header messages has a known
+ * value.  TCP reads are checked at their stream offset, UDP datagrams
+ * past their headers against their ID's slot.
+ * ------------------------------------------------------------------- */
+void Server::PayloadInit( void ) {
+    mPayloadNext = 0;
+    mPayloadChecked = 0;
+    mPayloadCorrupt = 0;
+    mPayloadBad = 0;
+    if ( !isVerify( mSettings ) )
+	return;
+    if ( !isPayload( mSettings ) ) {
+	fprintf( stderr, warn_verify_no_payload, mSettings->mSock );
+	return;
+    }
+    mPayload = Payload_Pool( mSettings->mPayload, mSettings->mPayloadRatio, 0 );
+}
+
+void Server::VerifyTCP( const char *buf, long len ) {
+    max_size_t bad;
+    long skip = 0;
+
+    if ( mPayloadNext < mSettings->mPayloadOffset ) {
+	skip = (long) (mSettings->mPayloadOffset - mPayloadNext);
+	if ( skip > len )
+	    skip = len;
+    }
+    if ( len > skip ) {
+	bad = Payload_Verify( mPayload, mPayloadNext + skip - mSettings->mPayloadOffset,
+			      buf + skip, len - skip );
+	mPayloadChecked += len - skip;
+	if ( bad > 0 ) {
+	    mPayloadCorrupt += bad;
+	    mPayloadBad++;
+	}
+    }
+    mPayloadNext += len;
+}
+
+void Server::VerifyUDP( max_size_t id, const char *buf, long len ) {
+    max_size_t bad;
+
+    if ( len <= (long) SIZEOF_UDPCLIENTMSG )
+	return;
+    len -= SIZEOF_UDPCLIENTMSG;
+    bad = Payload_Verify( mPayload, Payload_Slot( id ), buf + SIZEOF_UDPCLIENTMSG, len );
+    mPayloadChecked += len;
+    if ( bad > 0 ) {
+	mPayloadCorrupt += bad;
+	mPayloadBad++;
+    }
+}
+
+void Server::PayloadEnd( const char *unit ) {
+    if ( mPayload == NULL )
+	return;
+    printf( report_payload_verify, mSettings->mSock, Payload_Name( mSettings->mPayload ),
+	    mPayloadChecked, mPayloadCorrupt, mPayloadBad, unit );
+    fflush( stdout );
+    Payload_Free( mPayload );
+    mPayload = NULL;
+}
+
 void Server::RunTCP( void ) {
     long currLen;
     max_size_t totLen = 0;
     ReportStruct *reportstruct = NULL;
     int running;
     bool mMode_Time = isServerModeTime( mSettings );
+    int readLen = mSettings->mBufLen;
+    int minReadLen = (mSettings->mBufLen < 1024) ? mSettings->mBufLen : 1024;
+    int readFlags = 0;
 
     reportstruct = new ReportStruct;
     if ( reportstruct != NULL ) {
         reportstruct->packetID = 0;
+        reportstruct->writeCnt = 0;
+        reportstruct->sentTime.tv_sec = 0;
+        reportstruct->sentTime.tv_usec = 0;
         mSettings->reporthdr = InitReport( mSettings );
+        mBuckets = TimeBuckets_Init( mSettings );
+	mStreamOffset = 0;
+	mStampNext = mSettings->mStampOffset;
+	mStampHave = 0;
+	PayloadInit( );
 	running=1;
 #ifdef HAVE_SCHED_SETSCHEDULER
 	if ( isRealtime( mSettings ) ) {
@@ -132,10 +320,60 @@ void Server::RunTCP( void ) {
 	    mEndTime.setnow();
 	    mEndTime.add( mSettings->mAmount / 100.0 );
 	}
-        do {
+	if ( isRecvMode( mSettings ) ) {
+	    switch ( mSettings->mRecvMode ) {
+	    case kRecv_WaitAll:
+		readFlags = MSG_WAITALL;
+		break;
+	    case kRecv_LowAt:
+#ifdef SO_RCVLOWAT
+		{
+		    // have the kernel hold off wakeups until this many bytes are queued
+		    int lowat = (mSettings->mRcvLowat > 0) ? mSettings->mRcvLowat : mSettings->mBufLen;
+		    int rc = setsockopt( mSettings->mSock, SOL_SOCKET, SO_RCVLOWAT,
+					 (char*) &lowat, sizeof(lowat));
+		    WARN_errno( rc == SOCKET_ERROR, "setsockopt SO_RCVLOWAT" );
+		}
+#else
+		fprintf( stderr, "WARNING: SO_RCVLOWAT is not supported on this platform\n");
+#endif
+		break;
+	    default:
+		break;
+	    }
+	}
+	if ( isBusyPoll( mSettings ) ) {
+	    BusyPollInit();
+	}
+#ifdef HAVE_LINUX_IO_URING_H
+	// the ring's reads are never looked at, --write-latency and --verify need the data
+	if ( isIOUring( mSettings ) && !isWriteLatency( mSettings ) && mPayload == NULL &&
+	     RingReadTCP( reportstruct, &totLen ) ) {
+	    running = 0;
+	}
+#endif
+        while (running) {
 	    reportstruct->emptyreport=0;
 	    // perform read
-	    currLen = recv( mSettings->mSock, mBuf, mSettings->mBufLen, 0 );
+	    if ( isBusyPoll( mSettings ) ) {
+		currLen = BusyRecv( mBuf, readLen, NULL, readFlags );
+	    } else {
+		currLen = recv( mSettings->mSock, mBuf, readLen, readFlags );
+	    }
+	    if ( mSettings->mRecvMode == kRecv_Adaptive && currLen > 0 ) {
+		// grow the request while reads fill it, shrink it when they
+		// come back mostly empty, so the histogram shows what the
+		// stack actually hands up per syscall
+		if ( currLen == readLen && readLen < mSettings->mBufLen ) {
+		    readLen *= 2;
+		    if ( readLen > mSettings->mBufLen )
+			readLen = mSettings->mBufLen;
+		} else if ( currLen < (readLen >> 2) && readLen > minReadLen ) {
+		    readLen >>= 1;
+		    if ( readLen < minReadLen )
+			readLen = minReadLen;
+		}
+	    }
 #ifdef HAVE_CLOCK_GETTIME
 	    {
 		struct timespec t1;
@@ -162,12 +400,18 @@ void Server::RunTCP( void ) {
 		currLen = 0;
 	    }
 	    totLen += currLen;
+	    if ( mBuckets != NULL && currLen > 0 )
+		TimeBuckets_Add( mBuckets, currLen, &reportstruct->packetTime );
+	    if ( currLen > 0 && isWriteLatency( mSettings ) )
+		ReadStamps( mBuf, currLen, reportstruct );
+	    if ( currLen > 0 && mPayload != NULL )
+		VerifyTCP( mBuf, currLen );
 	    reportstruct->packetLen = currLen;
 	    if (mMode_Time && mEndTime.before( reportstruct->packetTime)) {
 		running = 0;
 	    }
 	    ReportPacket( mSettings->reporthdr, reportstruct );
-        } while (running);
+        }
 
         // stop timing
 #ifdef HAVE_CLOCK_GETTIME
@@ -196,6 +440,9 @@ void Server::RunTCP( void ) {
 
     DELETE_PTR( reportstruct );
     EndReport( mSettings->reporthdr );
+    TimeBuckets_End( mBuckets );
+    mBuckets = NULL;
+    PayloadEnd( "reads" );
 }
 
 /* -------------------------------------------------------------------
@@ -236,7 +483,10 @@ void Server::RunUDP( void ) {
     reportstruct = new ReportStruct;
     if ( reportstruct != NULL ) {
         reportstruct->packetID = 0;
+        reportstruct->writeCnt = 0;
         mSettings->reporthdr = InitReport( mSettings );
+        mBuckets = TimeBuckets_Init( mSettings );
+	PayloadInit( );
 	running=1;
 	int sorcvtimer = 0;
 	// sorcvtimer units microseconds convert to that
@@ -287,11 +537,30 @@ void Server::RunUDP( void ) {
 	    mEndTime.setnow();
 	    mEndTime.add( mSettings->mAmount / 100.0 );
 	}
-        do {
+	if ( isBusyPoll( mSettings ) ) {
+	    BusyPollInit();
+	}
+#ifdef HAVE_LINUX_IO_URING_H
+	if ( isIOUring( mSettings ) && mPayload == NULL &&
+	     RingReadUDP( reportstruct, &totLen, sorcvtimer ) ) {
+	    running = 0;
+	}
+#endif
+#ifdef HAVE_NET_NETMAP_USER_H
+	if ( mSettings->mNetmap != NULL ) {
+	    NetmapReadUDP( reportstruct, &totLen, sorcvtimer );
+	    running = 0;
+	}
+#endif
+        while (running) {
 	    reportstruct->emptyreport=0;
 #if HAVE_DECL_SO_TIMESTAMP
             // perform read
-            currLen = recvmsg( mSettings->mSock, &message, 0 );
+            if ( isBusyPoll( mSettings ) ) {
+                currLen = BusyRecv( NULL, 0, &message, 0 );
+            } else {
+                currLen = recvmsg( mSettings->mSock, &message, 0 );
+            }
 	    if (currLen <= 0) {
 		// Socket read timeout or read error
 		reportstruct->emptyreport=1;
@@ -331,7 +600,11 @@ void Server::RunUDP( void ) {
             }
 #else
             // perform read
-            currLen = recv( mSettings->mSock, mBuf, mSettings->mBufLen, 0 );
+            if ( isBusyPoll( mSettings ) ) {
+                currLen = BusyRecv( mBuf, mSettings->mBufLen, NULL, 0 );
+            } else {
+                currLen = recv( mSettings->mSock, mBuf, mSettings->mBufLen, 0 );
+            }
 	    if (currLen <= 0) {
 		reportstruct->emptyreport=1;
                 // End loop on 0 read or socket error
@@ -366,6 +639,8 @@ void Server::RunUDP( void ) {
             }
 #endif
 	    totLen += currLen;
+	    if ( mBuckets != NULL && currLen > 0 )
+		TimeBuckets_Add( mBuckets, currLen, &reportstruct->packetTime );
             // terminate when datagram begins with negative index
             // the datagram ID should be correct, just negated
 	    if (!isSeqNo64b(mSettings) && (reportstruct->packetID & 0x80000000L)) {
@@ -377,11 +652,13 @@ void Server::RunUDP( void ) {
 		currLen = -1;
 		running = 0;
 	    }
+	    if ( currLen > 0 && mPayload != NULL )
+		VerifyUDP( reportstruct->packetID, mBuf, currLen );
 	    if (mMode_Time && mEndTime.before( reportstruct->packetTime)) {
 		running = 0;
 	    }
 	    ReportPacket( mSettings->reporthdr, reportstruct );
-        } while (running);
+        }
         // stop timing
 #ifdef HAVE_CLOCK_GETTIME
        {
@@ -395,8 +672,9 @@ void Server::RunUDP( void ) {
 #endif
 	CloseReport( mSettings->reporthdr, reportstruct );
 
-        // send a acknowledgement back only if we're NOT receiving multicast
-        if (!isMulticast( mSettings ) ) {
+        // send a acknowledgement back only if we're NOT receiving multicast,
+        // nor through netmap where the client doesn't wait for one
+        if (!isMulticast( mSettings ) && mSettings->mNetmap == NULL ) {
             // send back an acknowledgement of the terminating datagram
             write_UDP_AckFIN( );
         }
@@ -409,9 +687,256 @@ void Server::RunUDP( void ) {
 
     DELETE_PTR( reportstruct );
     EndReport( mSettings->reporthdr );
+    TimeBuckets_End( mBuckets );
+    mBuckets = NULL;
+    PayloadEnd( "datagrams" );
 }
 // end Recv
 
+#ifdef HAVE_LINUX_IO_URING_H
+/* -------------------------------------------------------------------
+ * The RunTCP() read loop using io_uring.  mRingDepth reads are kept
+ * in flight and a report is generated per completion.  Returns false
+ * if the ring can't be set up so the caller uses recv() instead.
+ * ------------------------------------------------------------------- */
+bool Server::RingReadTCP( ReportStruct *reportstruct, max_size_t *totLen ) {
+    IOUring ring;
+    unsigned tag;
+    int slot, res;
+    bool running = true, cancelled = false, mMode_Time = isServerModeTime( mSettings );
+
+    if ( IOUring_Init( &ring, mSettings->mSock, mSettings->mRingDepth, mSettings->mBufLen ) < 0 ) {
+	fprintf( stderr, warn_iouring_fallback, mSettings->mSock, strerror( errno ) );
+	return false;
+    }
+    for ( slot = 0; slot < ring.depth; slot++ ) {
+	IOUring_PrepRead( &ring, slot );
+    }
+    while ( ring.inflight > 0 ) {
+	if ( IOUring_Enter( &ring, 1 ) < 0 ) {
+	    if ( errno != EINTR ) {
+		WARN_errno( 1, "io_uring_enter" );
+		break;
+	    }
+	} else {
+	    while ( IOUring_Reap( &ring, &tag, &res ) ) {
+		if ( (tag & IOURING_TAG_CANCEL) || res == -ECANCELED )
+		    continue;
+		slot = tag & IOURING_TAG_MASK;
+		reportstruct->emptyreport = 0;
+#ifdef HAVE_CLOCK_GETTIME
+		{
+		    struct timespec t1;
+		    clock_gettime(CLOCK_REALTIME, &t1);
+		    reportstruct->packetTime.tv_sec = t1.tv_sec;
+		    reportstruct->packetTime.tv_usec = t1.tv_nsec / 1000;
+		}
+#else
+		gettimeofday( &(reportstruct->packetTime), NULL );
+#endif
+		if ( res <= 0 ) {
+		    reportstruct->emptyreport = 1;
+		    // End loop on 0 read or socket error
+		    if ( res == 0 || (res != -EAGAIN && res != -EWOULDBLOCK) ) {
+			running = false;
+		    }
+		    res = 0;
+		}
+		*totLen += res;
+		if ( mBuckets != NULL && res > 0 )
+		    TimeBuckets_Add( mBuckets, res, &reportstruct->packetTime );
+		reportstruct->packetLen = res;
+		if ( mMode_Time && mEndTime.before( reportstruct->packetTime ) ) {
+		    running = false;
+		}
+		ReportPacket( mSettings->reporthdr, reportstruct );
+		if ( running ) {
+		    IOUring_PrepRead( &ring, slot );
+		}
+	    }
+	}
+	if ( !running && !cancelled ) {
+	    for ( slot = 0; slot < ring.depth; slot++ )
+		IOUring_PrepCancel( &ring, slot );
+	    cancelled = true;
+	}
+    }
+    IOUring_Destroy( &ring );
+    return true;
+}
+
+/* -------------------------------------------------------------------
+ * The RunUDP() read loop using io_uring.  A ring timeout stands in
+ * for SO_RCVTIMEO and, as plain reads don't return SO_TIMESTAMP
+ * control messages, packets are timestamped when reaped.
+ * ------------------------------------------------------------------- */
+bool Server::RingReadUDP( ReportStruct *reportstruct, max_size_t *totLen, int sorcvtimer ) {
+    IOUring ring;
+    unsigned tag;
+    int slot, res;
+    struct UDP_datagram* mBuf_UDP;
+    bool running = true, cancelled = false, mMode_Time = isServerModeTime( mSettings );
+
+    if ( IOUring_Init( &ring, mSettings->mSock, mSettings->mRingDepth, mSettings->mBufLen ) < 0 ) {
+	fprintf( stderr, warn_iouring_fallback, mSettings->mSock, strerror( errno ) );
+	return false;
+    }
+    for ( slot = 0; slot < ring.depth; slot++ ) {
+	IOUring_PrepRead( &ring, slot );
+    }
+    if ( sorcvtimer > 0 ) {
+	IOUring_PrepTimeout( &ring, sorcvtimer );
+    }
+    while ( ring.inflight > 0 ) {
+	if ( IOUring_Enter( &ring, 1 ) < 0 ) {
+	    if ( errno != EINTR ) {
+		WARN_errno( 1, "io_uring_enter" );
+		break;
+	    }
+	} else {
+	    while ( IOUring_Reap( &ring, &tag, &res ) ) {
+		// completions after the FIN (e.g. FIN retransmits) are left for write_UDP_AckFIN
+		if ( (tag & IOURING_TAG_CANCEL) || !running )
+		    continue;
+		reportstruct->emptyreport = 0;
+#ifdef HAVE_CLOCK_GETTIME
+		{
+		    struct timespec t1;
+		    clock_gettime(CLOCK_REALTIME, &t1);
+		    reportstruct->packetTime.tv_sec = t1.tv_sec;
+		    reportstruct->packetTime.tv_usec = t1.tv_nsec / 1000;
+		}
+#else
+		gettimeofday( &(reportstruct->packetTime), NULL );
+#endif
+		if ( tag == IOURING_TAG_TIMEOUT ) {
+		    // read timeout, same as SO_RCVTIMEO expiring
+		    reportstruct->emptyreport = 1;
+		    reportstruct->packetLen = 0;
+		    IOUring_PrepTimeout( &ring, sorcvtimer );
+		} else if ( res <= 0 ) {
+		    reportstruct->emptyreport = 1;
+		    reportstruct->packetLen = 0;
+		    if ( res == 0 || (res != -EAGAIN && res != -EWOULDBLOCK) ) {
+			errno = -res;
+			WARN_errno( res < 0, "read" );
+			running = false;
+		    } else {
+			IOUring_PrepRead( &ring, tag & IOURING_TAG_MASK );
+		    }
+		} else {
+		    slot = tag & IOURING_TAG_MASK;
+		    mBuf_UDP = (struct UDP_datagram*) IOUring_Slot( &ring, slot );
+		    // read the datagram ID and sentTime out of the buffer
+		    if (isSeqNo64b(mSettings)) {
+			reportstruct->packetID = (((max_size_t) (ntohl(mBuf_UDP->id2)) << 32) | ntohl(mBuf_UDP->id));
+		    } else {
+			reportstruct->packetID = ntohl(mBuf_UDP->id);
+		    }
+		    reportstruct->sentTime.tv_sec = ntohl( mBuf_UDP->tv_sec  );
+		    reportstruct->sentTime.tv_usec = ntohl( mBuf_UDP->tv_usec );
+		    reportstruct->packetLen = res;
+		    *totLen += res;
+		    if ( mBuckets != NULL )
+			TimeBuckets_Add( mBuckets, res, &reportstruct->packetTime );
+		    // terminate when datagram begins with negative index
+		    if (!isSeqNo64b(mSettings) && (reportstruct->packetID & 0x80000000L)) {
+			reportstruct->packetID = (reportstruct->packetID & 0x7FFFFFFFL);
+			running = false;
+		    } else if (isSeqNo64b(mSettings) && (reportstruct->packetID & 0x8000000000000000LL)) {
+			reportstruct->packetID = (reportstruct->packetID & 0x7FFFFFFFFFFFFFFFLL);
+			running = false;
+		    } else {
+			IOUring_PrepRead( &ring, slot );
+		    }
+		}
+		if ( mMode_Time && mEndTime.before( reportstruct->packetTime ) ) {
+		    running = false;
+		}
+		ReportPacket( mSettings->reporthdr, reportstruct );
+	    }
+	}
+	if ( !running && !cancelled ) {
+	    for ( slot = 0; slot < ring.depth; slot++ )
+		IOUring_PrepCancel( &ring, slot );
+	    if ( sorcvtimer > 0 )
+		IOUring_PrepCancelTimeout( &ring );
+	    cancelled = true;
+	}
+    }
+    IOUring_Destroy( &ring );
+    return true;
+}
+#endif
+
+#ifdef HAVE_NET_NETMAP_USER_H
+/* -------------------------------------------------------------------
+ * The RunUDP() read loop through the netmap port the listener
+ * accepted the test on.  Each wakeup walks whatever the RX rings
+ * hold, datagrams of other flows are dropped.  A datagram's arrival
+ * time is its ring's sync time, falling back to the time of the
+ * wakeup if the port doesn't provide one.
+ * ------------------------------------------------------------------- */
+void Server::NetmapReadUDP( ReportStruct *reportstruct, max_size_t *totLen, int sorcvtimer ) {
+    Netmap *nm = mSettings->mNetmap;
+    UDP_datagram hdr;
+    struct timeval now, ts;
+    char *payload;
+    int rc, len;
+    bool running = true, mMode_Time = isServerModeTime( mSettings );
+
+    while ( running ) {
+	// sorcvtimer units microseconds
+	rc = Netmap_RxWait( nm, (sorcvtimer > 0) ? (sorcvtimer + 999) / 1000 : -1 );
+	gettimeofday( &now, NULL );
+	if ( rc <= 0 ) {
+	    // read timeout, same as SO_RCVTIMEO expiring
+	    if ( rc < 0 && errno != EINTR ) {
+		WARN_errno( 1, "netmap poll" );
+		running = false;
+	    }
+	    reportstruct->emptyreport = 1;
+	    reportstruct->packetLen = 0;
+	    reportstruct->packetTime = now;
+	    if ( mMode_Time && mEndTime.before( reportstruct->packetTime ) )
+		running = false;
+	    ReportPacket( mSettings->reporthdr, reportstruct );
+	    continue;
+	}
+	while ( running && (payload = Netmap_RxNext( nm, &len, &ts )) != NULL ) {
+	    if ( len < (int) sizeof(hdr) )
+		continue;
+	    reportstruct->emptyreport = 0;
+	    reportstruct->packetTime = (ts.tv_sec != 0) ? ts : now;
+	    // read the datagram ID and sentTime out of the slot
+	    memcpy( &hdr, payload, sizeof(hdr) );
+	    if (isSeqNo64b(mSettings)) {
+		reportstruct->packetID = (((max_size_t) (ntohl(hdr.id2)) << 32) | ntohl(hdr.id));
+	    } else {
+		reportstruct->packetID = ntohl(hdr.id);
+	    }
+	    reportstruct->sentTime.tv_sec = ntohl( hdr.tv_sec  );
+	    reportstruct->sentTime.tv_usec = ntohl( hdr.tv_usec );
+	    reportstruct->packetLen = len;
+	    *totLen += len;
+	    if ( mBuckets != NULL )
+		TimeBuckets_Add( mBuckets, len, &reportstruct->packetTime );
+	    // terminate when datagram begins with negative index
+	    if (!isSeqNo64b(mSettings) && (reportstruct->packetID & 0x80000000L)) {
+		reportstruct->packetID = (reportstruct->packetID & 0x7FFFFFFFL);
+		running = false;
+	    } else if (isSeqNo64b(mSettings) && (reportstruct->packetID & 0x8000000000000000LL)) {
+		reportstruct->packetID = (reportstruct->packetID & 0x7FFFFFFFFFFFFFFFLL);
+		running = false;
+	    }
+	    if ( mMode_Time && mEndTime.before( reportstruct->packetTime ) )
+		running = false;
+	    ReportPacket( mSettings->reporthdr, reportstruct );
+	}
+    }
+}
+#endif
+
 /* -------------------------------------------------------------------
  * Send an AckFIN (a datagram acknowledging a FIN) on the socket,
  * then select on the socket for some time. If additional datagrams
@@ -441,38 +966,7 @@ void Server::write_UDP_AckFIN( ) {
 	    int flags = (!isEnhanced(mSettings) ? HEADER_VERSION1 : (HEADER_VERSION1 | HEADER_EXTEND));
             Transfer_Info *stats = GetReport( mSettings->reporthdr );
             hdr = (server_hdr*) (UDP_Hdr+1);
-	    hdr->base.flags        = htonl((long) flags);
-            hdr->base.total_len1   = htonl( (long) (stats->TotalLen >> 32) );
-            hdr->base.total_len2   = htonl( (long) (stats->TotalLen & 0xFFFFFFFF) );
-            hdr->base.stop_sec     = htonl( (long) stats->endTime );
-            hdr->base.stop_usec    = htonl( (long)((stats->endTime - (long)stats->endTime) * rMillion));
-            hdr->base.error_cnt    = htonl( stats->cntError );
-            hdr->base.outorder_cnt = htonl( stats->cntOutofOrder );
-#ifndef HAVE_SEQNO64b
-            hdr->base.datagrams    = htonl( stats->cntDatagrams );
-#else
-            hdr->base.datagrams2   = htonl( (long) (stats->cntDatagrams >> 32) );
-            hdr->base.datagrams    = htonl( (long) (stats->cntDatagrams & 0xFFFFFFFF) );
-#endif
-            hdr->base.jitter1      = htonl( (long) stats->jitter );
-            hdr->base.jitter2      = htonl( (long) ((stats->jitter - (long)stats->jitter) * rMillion) );
-	    if (flags & HEADER_EXTEND) {
-		hdr->extend.minTransit1  = htonl( (long) stats->transit.totminTransit );
-		hdr->extend.minTransit2  = htonl( (long) ((stats->transit.totminTransit - (long)stats->transit.totminTransit) * rMillion) );
-		hdr->extend.maxTransit1  = htonl( (long) stats->transit.totmaxTransit );
-		hdr->extend.maxTransit2  = htonl( (long) ((stats->transit.totmaxTransit - (long)stats->transit.totmaxTransit) * rMillion) );
-		hdr->extend.sumTransit1  = htonl( (long) stats->transit.totsumTransit );
-		hdr->extend.sumTransit2  = htonl( (long) ((stats->transit.totsumTransit - (long)stats->transit.totsumTransit) * rMillion) );
-		hdr->extend.meanTransit1  = htonl( (long) stats->transit.totmeanTransit );
-		hdr->extend.meanTransit2  = htonl( (long) ((stats->transit.totmeanTransit - (long)stats->transit.totmeanTransit) * rMillion) );
-		hdr->extend.m2Transit1  = htonl( (long) stats->transit.totm2Transit );
-		hdr->extend.m2Transit2  = htonl( (long) ((stats->transit.totm2Transit - (long)stats->transit.totm2Transit) * rMillion) );
-		hdr->extend.vdTransit1  = htonl( (long) stats->transit.totvdTransit );
-		hdr->extend.vdTransit2  = htonl( (long) ((stats->transit.totvdTransit - (long)stats->transit.totvdTransit) * rMillion) );
-		hdr->extend.cntTransit   = htonl( stats->transit.totcntTransit );
-		hdr->extend.IPGcnt = htonl( (long) (stats->cntDatagrams / (stats->endTime - stats->startTime)));
-		hdr->extend.IPGsum = htonl(1);
-	    }
+            EncodeServerHdr( stats, hdr, flags );
         }
 
         // write data
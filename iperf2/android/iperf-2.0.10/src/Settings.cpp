@@ -71,9 +71,41 @@
 #include "version.h"
 
 #include "gnu_getopt.h"
+#include "IOUring.h"
+#include "TCPSampler.h"
+#include "TimeBuckets.h"
+#include "Netmap.h"
+#include "Fanout.h"
+#include "SeqWindow.h"
+#include "McastGroups.h"
+#include "Sweep.h"
+#include "Payload.h"
 #include "lwip_adap.h"
 static int seqno64b = 0;
 static int reversetest = 0;
+static int iouring = 0;
+static int recvmode = 0;
+static int tcpsample = 0;
+static int timebuckets = 0;
+static int clocksync = 0;
+static int netmapport = 0;
+static int statsshm = 0;
+static int reportdepth = 0;
+static int aggregate = 0;
+static int targets = 0;
+static int fanout = 0;
+static int cpuacct = 0;
+static int affinity = 0;
+static int busypoll = 0;
+static int writelatency = 0;
+static int reorderwin = 0;
+static int mcastgroups = 0;
+static int sweep = 0;
+static int trials = 0;
+static int sweepsettle = 0;
+static int warmup = 0;
+static int payload = 0;
+static int verify = 0;
 
 void Settings_Interpret( char option, const char *optarg, thread_Settings *mExtSettings );
 // apply compound settings after the command line has been fully parsed
@@ -136,6 +168,29 @@ const struct option long_options[] =
 {"peer-detect",      no_argument, NULL, 'X'},
 {"linux-congestion", required_argument, NULL, 'Z'},
 {"udp-counters-64bit", no_argument, &seqno64b, 1},
+{"io-uring",   optional_argument, &iouring, 1},
+{"recv-mode",  required_argument, &recvmode, 1},
+{"tcp-sample", optional_argument, &tcpsample, 1},
+{"time-buckets", optional_argument, &timebuckets, 1},
+{"clock-sync", no_argument, &clocksync, 1},
+{"netmap",     required_argument, &netmapport, 1},
+{"stats-shm",  required_argument, &statsshm, 1},
+{"report-depth", required_argument, &reportdepth, 1},
+{"aggregate",  no_argument, &aggregate, 1},
+{"targets",    required_argument, &targets, 1},
+{"fanout",     required_argument, &fanout, 1},
+{"cpu",        no_argument, &cpuacct, 1},
+{"affinity",   required_argument, &affinity, 1},
+{"busy-poll",  optional_argument, &busypoll, 1},
+{"write-latency", optional_argument, &writelatency, 1},
+{"reorder-window", optional_argument, &reorderwin, 1},
+{"mcast-groups", required_argument, &mcastgroups, 1},
+{"sweep",      required_argument, &sweep, 1},
+{"trials",     required_argument, &trials, 1},
+{"sweep-settle", required_argument, &sweepsettle, 1},
+{"warmup",     required_argument, &warmup, 1},
+{"payload",    required_argument, &payload, 1},
+{"verify",     no_argument, &verify, 1},
 #ifdef WIN32
 {"reverse", no_argument, &reversetest, 1},
 #endif
@@ -250,13 +305,35 @@ void Settings_Initialize( thread_Settings *main ) {
     //main->mRemoveService = false;      // -R,
     //main->mTOS          = 0;           // -S,  ie. don't set type of service
     main->mTTL          = 1;             // -T,  link-local TTL
+    main->mReportDepth  = NUM_REPORT_STRUCTS; // --report-depth
+    main->mFanout       = FANOUT_DEFAULT;     // --fanout
+    main->mTrials       = SWEEP_TRIALS_DEFAULT; // --trials
+    main->mSweepSettle  = SWEEP_SETTLE_DEFAULT; // --sweep-settle
     //main->mDomain     = kMode_IPv4;    // -V,
     //main->mSuggestWin = false;         // -W,  Suggest the window size.
 
 } // end Settings
 
+/* -------------------------------------------------------------------
+ * Destroyed settings are kept on a free list, chained through runNext,
+ * so a server taking many connections, e.g. in daemon mode, reuses
+ * them rather than going back to the heap for every stream.
+ * ------------------------------------------------------------------- */
+#define SETTINGS_POOL_MAX 1024
+static thread_Settings *settings_pool = NULL;
+static int settings_pooled = 0;
+
 void Settings_Copy( thread_Settings *from, thread_Settings **into ) {
-    *into = new thread_Settings;
+    Mutex_Lock( &poolCond );
+    *into = settings_pool;
+    if ( *into != NULL ) {
+        settings_pool = (*into)->runNext;
+        settings_pooled--;
+    }
+    Mutex_Unlock( &poolCond );
+    if ( *into == NULL ) {
+        *into = new thread_Settings;
+    }
     memcpy( *into, from, sizeof(thread_Settings) );
     if ( from->mHost != NULL ) {
         (*into)->mHost = new char[ strlen(from->mHost) + 1];
@@ -278,6 +355,7 @@ void Settings_Copy( thread_Settings *from, thread_Settings **into ) {
     (*into)->mTID = thread_zeroid();
     (*into)->runNext = NULL;
     (*into)->runNow = NULL;
+    (*into)->runGroup = NULL;
 }
 
 /* -------------------------------------------------------------------
@@ -289,6 +367,14 @@ void Settings_Destroy( thread_Settings *mSettings) {
     DELETE_ARRAY( mSettings->mLocalhost );
     DELETE_ARRAY( mSettings->mFileName  );
     DELETE_ARRAY( mSettings->mOutputFileName );
+    Mutex_Lock( &poolCond );
+    if ( settings_pooled < SETTINGS_POOL_MAX ) {
+        mSettings->runNext = settings_pool;
+        settings_pool = mSettings;
+        settings_pooled++;
+        mSettings = NULL;
+    }
+    Mutex_Unlock( &poolCond );
     DELETE_PTR( mSettings );
 } // end ~Settings
 
@@ -678,6 +764,242 @@ void Settings_Interpret( char option, const char *optarg, thread_Settings *mExtS
 		exit(1);
 		setReverse(mExtSettings);
 	    }
+	    if (iouring) {
+		iouring = 0;
+#ifdef HAVE_LINUX_IO_URING_H
+		setIOUring(mExtSettings);
+		mExtSettings->mRingDepth = (optarg != NULL) ? atoi(optarg) : IOURING_DEFAULT_DEPTH;
+		if (mExtSettings->mRingDepth < 1 || mExtSettings->mRingDepth > IOURING_MAX_DEPTH) {
+		    fprintf( stderr, "WARNING: io_uring depth must be between 1 and %d, using %d\n",
+			     IOURING_MAX_DEPTH, IOURING_DEFAULT_DEPTH);
+		    mExtSettings->mRingDepth = IOURING_DEFAULT_DEPTH;
+		}
+#else
+		fprintf( stderr, "WARNING: io_uring is not supported on this platform, option ignored\n");
+#endif
+	    }
+	    if (recvmode) {
+		recvmode = 0;
+		setRecvMode(mExtSettings);
+		if (strcmp(optarg, "waitall") == 0) {
+		    mExtSettings->mRecvMode = kRecv_WaitAll;
+		} else if (strcmp(optarg, "adaptive") == 0) {
+		    mExtSettings->mRecvMode = kRecv_Adaptive;
+		} else if (strncmp(optarg, "lowat", 5) == 0) {
+		    mExtSettings->mRecvMode = kRecv_LowAt;
+		    mExtSettings->mRcvLowat = (optarg[5] == ':') ? byte_atoi(optarg + 6) : 0;
+		} else {
+		    if (strcmp(optarg, "normal") != 0) {
+			fprintf( stderr, "WARNING: unknown recv mode '%s', using normal reads\n", optarg);
+		    }
+		    mExtSettings->mRecvMode = kRecv_Default;
+		}
+	    }
+	    if (tcpsample) {
+		tcpsample = 0;
+#ifdef HAVE_TCP_SAMPLER
+		setTCPSample(mExtSettings);
+		mExtSettings->mSampleUsecs = (optarg != NULL) ? atoi(optarg) : TCPSAMPLE_DEFAULT_USECS;
+		if (mExtSettings->mSampleUsecs < TCPSAMPLE_MIN_USECS) {
+		    fprintf( stderr, "WARNING: TCP_INFO sample period must be at least %d usecs\n",
+			     TCPSAMPLE_MIN_USECS);
+		    mExtSettings->mSampleUsecs = TCPSAMPLE_MIN_USECS;
+		}
+#else
+		fprintf( stderr, "WARNING: TCP_INFO sampling is not supported on this platform, option ignored\n");
+#endif
+	    }
+	    if (timebuckets) {
+		timebuckets = 0;
+		setTimeBuckets(mExtSettings);
+		mExtSettings->mBucketUsecs = (optarg != NULL) ? atoi(optarg) : TIMEBUCKETS_DEFAULT_USECS;
+		if (mExtSettings->mBucketUsecs < TIMEBUCKETS_MIN_USECS) {
+		    fprintf( stderr, "WARNING: time bucket width must be at least %d usecs, using %d\n",
+			     TIMEBUCKETS_MIN_USECS, TIMEBUCKETS_DEFAULT_USECS);
+		    mExtSettings->mBucketUsecs = TIMEBUCKETS_DEFAULT_USECS;
+		}
+	    }
+	    if (clocksync) {
+		clocksync = 0;
+		// the exchange rides on the peer version header exchange
+		setClockSync(mExtSettings);
+		setPeerVerDetect(mExtSettings);
+	    }
+	    if (netmapport) {
+		netmapport = 0;
+#ifdef HAVE_NET_NETMAP_USER_H
+		setNetmap(mExtSettings);
+		mExtSettings->mNetmapPort = new char[strlen(optarg)+1];
+		strcpy( mExtSettings->mNetmapPort, optarg);
+#else
+		fprintf( stderr, "WARNING: netmap is not supported on this build, option ignored\n");
+#endif
+	    }
+	    if (statsshm) {
+		statsshm = 0;
+		setStatsShm(mExtSettings);
+		mExtSettings->mStatsShm = new char[strlen(optarg)+1];
+		strcpy( mExtSettings->mStatsShm, optarg);
+	    }
+	    if (reportdepth) {
+		reportdepth = 0;
+		mExtSettings->mReportDepth = atoi(optarg);
+		if (mExtSettings->mReportDepth < (1 << REPORT_DEPTH_MINLOG2) ||
+		    mExtSettings->mReportDepth > (1 << REPORT_DEPTH_MAXLOG2)) {
+		    fprintf( stderr, "WARNING: report depth must be %d to %d, using %d\n",
+			     1 << REPORT_DEPTH_MINLOG2, 1 << REPORT_DEPTH_MAXLOG2, NUM_REPORT_STRUCTS);
+		    mExtSettings->mReportDepth = NUM_REPORT_STRUCTS;
+		}
+	    }
+	    if (aggregate) {
+		aggregate = 0;
+		setAggregate(mExtSettings);
+	    }
+	    if (targets) {
+		targets = 0;
+		if (Fanout_Load(optarg) > 0) {
+		    setFanout(mExtSettings);
+		    // the first target stands in for -c
+		    DELETE_ARRAY( mExtSettings->mHost );
+		    mExtSettings->mHost = new char[strlen(Fanout_Host(0))+1];
+		    strcpy( mExtSettings->mHost, Fanout_Host(0));
+		    if ( mExtSettings->mThreadMode == kMode_Unknown ) {
+			mExtSettings->mThreadMode = kMode_Client;
+			mExtSettings->mThreads = 1;
+		    }
+		}
+	    }
+	    if (fanout) {
+		fanout = 0;
+		mExtSettings->mFanout = atoi(optarg);
+		if (mExtSettings->mFanout < 1) {
+		    fprintf( stderr, "WARNING: fanout must be at least 1, using %d\n", FANOUT_DEFAULT);
+		    mExtSettings->mFanout = FANOUT_DEFAULT;
+		}
+	    }
+	    if (cpuacct) {
+		cpuacct = 0;
+		setCPUAcct(mExtSettings);
+	    }
+	    if (affinity) {
+		affinity = 0;
+#if HAVE_DECL_CPU_SET
+		mExtSettings->mAffinity = atoi(optarg);
+		if (mExtSettings->mAffinity < 0 || mExtSettings->mAffinity >= CPU_SETSIZE) {
+		    fprintf( stderr, "WARNING: affinity CPU %s is out of range, option ignored\n", optarg);
+		} else {
+		    setAffinity(mExtSettings);
+		}
+#else
+		fprintf( stderr, "WARNING: CPU affinity is not supported on this platform, option ignored\n");
+#endif
+	    }
+	    if (busypoll) {
+		busypoll = 0;
+#if HAVE_DECL_SO_BUSY_POLL
+		setBusyPoll(mExtSettings);
+		mExtSettings->mBusyPollUsecs = BUSYPOLL_DEFAULT_USECS;
+		mExtSettings->mBusySpinUsecs = 0;
+		if (optarg != NULL) {
+		    const char *spin = strchr(optarg, ':');
+		    if (spin != optarg) {
+			mExtSettings->mBusyPollUsecs = atoi(optarg);
+		    }
+		    if (spin != NULL) {
+			mExtSettings->mBusySpinUsecs = atoi(spin + 1);
+		    }
+		    if (mExtSettings->mBusyPollUsecs < 0 || mExtSettings->mBusySpinUsecs < 0) {
+			fprintf( stderr, "WARNING: busy poll times must not be negative, using %d usecs and no spin budget\n",
+				 BUSYPOLL_DEFAULT_USECS);
+			mExtSettings->mBusyPollUsecs = BUSYPOLL_DEFAULT_USECS;
+			mExtSettings->mBusySpinUsecs = 0;
+		    }
+		}
+#else
+		fprintf( stderr, "WARNING: busy polling is not supported on this platform, option ignored\n");
+#endif
+	    }
+	    if (writelatency) {
+		writelatency = 0;
+		// the server learns of the stamps from the extended header
+		setWriteLatency(mExtSettings);
+		setPeerVerDetect(mExtSettings);
+		mExtSettings->mNotSentLowat = (optarg != NULL) ? byte_atoi(optarg) : 0;
+		if (mExtSettings->mNotSentLowat < 0) {
+		    fprintf( stderr, "WARNING: not sent low water mark must not be negative, using the write size\n");
+		    mExtSettings->mNotSentLowat = 0;
+		}
+	    }
+	    if (reorderwin) {
+		reorderwin = 0;
+		setReorderWin(mExtSettings);
+		mExtSettings->mReorderWindow = (optarg != NULL) ? byte_atoi(optarg) : SEQWINDOW_DEFAULT;
+		if (mExtSettings->mReorderWindow <= 0 || mExtSettings->mReorderWindow > SEQWINDOW_MAX) {
+		    fprintf( stderr, "WARNING: reorder window must be 1 to %d datagrams, using %d\n",
+			     SEQWINDOW_MAX, SEQWINDOW_DEFAULT);
+		    mExtSettings->mReorderWindow = SEQWINDOW_DEFAULT;
+		}
+	    }
+	    if (mcastgroups) {
+		mcastgroups = 0;
+		if (McastGroups_Load(optarg) > 0) {
+		    setMcastGroups(mExtSettings);
+		}
+	    }
+	    if (sweep) {
+		sweep = 0;
+		if (Sweep_Load(optarg) > 0) {
+		    setSweep(mExtSettings);
+		}
+	    }
+	    if (trials) {
+		trials = 0;
+		// the trials are the one step sweep, or each step's repeats
+		setSweep(mExtSettings);
+		mExtSettings->mTrials = atoi(optarg);
+		if (mExtSettings->mTrials < 1) {
+		    fprintf( stderr, "WARNING: trials must be at least 1, using %d\n", SWEEP_TRIALS_DEFAULT);
+		    mExtSettings->mTrials = SWEEP_TRIALS_DEFAULT;
+		}
+	    }
+	    if (sweepsettle) {
+		sweepsettle = 0;
+		mExtSettings->mSweepSettle = atof(optarg);
+		if (mExtSettings->mSweepSettle < 0) {
+		    fprintf( stderr, "WARNING: sweep settle time must not be negative, using %.1f secs\n",
+			     SWEEP_SETTLE_DEFAULT);
+		    mExtSettings->mSweepSettle = SWEEP_SETTLE_DEFAULT;
+		}
+	    }
+	    if (warmup) {
+		warmup = 0;
+		// a k/m/g suffix makes it bytes, a plain number is secs
+		if (isalpha((unsigned char) optarg[strlen(optarg) - 1])) {
+		    mExtSettings->mWarmupBytes = byte_atoi(optarg);
+		    mExtSettings->mWarmupSecs = 0;
+		} else {
+		    mExtSettings->mWarmupSecs = atof(optarg);
+		    mExtSettings->mWarmupBytes = 0;
+		}
+		if (mExtSettings->mWarmupSecs > 0 || mExtSettings->mWarmupBytes > 0) {
+		    setWarmup(mExtSettings);
+		} else {
+		    fprintf( stderr, "WARNING: warm-up must be more than 0 secs or bytes, option ignored\n");
+		}
+	    }
+	    if (payload) {
+		payload = 0;
+		mExtSettings->mPayload = Payload_Parse(optarg, &mExtSettings->mPayloadRatio);
+		if (mExtSettings->mPayload != kPayload_Default) {
+		    // the server learns of the payload from the extended header
+		    setPayload(mExtSettings);
+		    setPeerVerDetect(mExtSettings);
+		}
+	    }
+	    if (verify) {
+		verify = 0;
+		setVerify(mExtSettings);
+	    }
         default: // ignore unknown
             break;
     }
@@ -714,6 +1036,54 @@ void Settings_ModalOptions( thread_Settings *mExtSettings ) {
     if (!isBWSet(mExtSettings) && isUDP(mExtSettings)) {
 	mExtSettings->mUDPRate = kDefault_UDPRate;
     }
+    // the netmap data path only carries UDP
+    if (isNetmap(mExtSettings) && !isUDP(mExtSettings)) {
+	fprintf( stderr, "WARNING: --netmap requires -u, option ignored\n");
+	unsetNetmap(mExtSettings);
+    }
+    // the stamped writes are TCP only and must hold a whole stamp
+    if (isWriteLatency(mExtSettings) && mExtSettings->mThreadMode == kMode_Client) {
+	if (isUDP(mExtSettings)) {
+	    fprintf( stderr, "WARNING: --write-latency is TCP only, option ignored\n");
+	    unsetWriteLatency(mExtSettings);
+	} else if (mExtSettings->mBufLen < (int) sizeof(tcp_write_stamp)) {
+	    fprintf( stderr, "WARNING: --write-latency needs -l of at least %d bytes, option ignored\n",
+		     (int) sizeof(tcp_write_stamp));
+	    unsetWriteLatency(mExtSettings);
+	} else {
+	    // Nagle would hold a short write for the ack of the one before
+	    setNoDelay(mExtSettings);
+	}
+    }
+    // a client's payload comes from the pools, which the file input and
+    // the stamped writes would overwrite, the server's is told by the client
+    if (isPayload(mExtSettings)) {
+	if (mExtSettings->mThreadMode != kMode_Client) {
+	    fprintf( stderr, "WARNING: --payload is a client option, the server takes it from the client\n");
+	    unsetPayload(mExtSettings);
+	} else if (isFileInput(mExtSettings) || isSTDIN(mExtSettings) ||
+		   isWriteLatency(mExtSettings) || isNetmap(mExtSettings) || isCompat(mExtSettings)) {
+	    fprintf( stderr, "WARNING: --payload can't be used with -F, -I, -C, --write-latency or --netmap, option ignored\n");
+	    unsetPayload(mExtSettings);
+	}
+	if (!isPayload(mExtSettings)) {
+	    mExtSettings->mPayload = kPayload_Default;
+	}
+    }
+    if (isVerify(mExtSettings) && mExtSettings->mThreadMode == kMode_Client) {
+	fprintf( stderr, "WARNING: --verify is a server option, option ignored\n");
+	unsetVerify(mExtSettings);
+    }
+    // the channels are received by the listener itself, datagram by datagram
+    if (isMcastGroups(mExtSettings) &&
+	(!isUDP(mExtSettings) || mExtSettings->mThreadMode != kMode_Listener)) {
+	fprintf( stderr, "WARNING: --mcast-groups requires -s -u, option ignored\n");
+	unsetMcastGroups(mExtSettings);
+    }
+    // the sweep sizes the client's buffer and streams for its largest step
+    if (isSweep(mExtSettings)) {
+	Sweep_Init(mExtSettings);
+    }
     // Check for local port assignment via parsing -B's mLocalhost string
     // (only supported on the client as server/listener uses -p for this)
     if ( mExtSettings->mLocalhost != NULL && mExtSettings->mThreadMode == kMode_Client ) {
@@ -837,6 +1207,10 @@ void Settings_GenerateClientSettings( thread_Settings *server,
         *client = new thread_Settings;
         memcpy(*client, server, sizeof( thread_Settings ));
         setCompat( (*client) );
+        // --payload and --verify were for the other direction
+        unsetPayload( (*client) );
+        unsetVerify( (*client) );
+        (*client)->mPayload = kPayload_Default;
         (*client)->mTID = thread_zeroid();
         (*client)->mPort       = (unsigned short) ntohl(hdr->base.mPort);
         (*client)->mThreads    = 1;
@@ -939,9 +1313,21 @@ int Settings_GenerateClientHdr( thread_Settings *client, client_hdr *hdr ) {
 	if (client->mUDPRateUnits == kRate_PPS) {
 	    extendflags |= UNITS_PPS;
 	}
+	if (isClockSync(client)) {
+	    extendflags |= CLOCKSYNC;
+	}
+	if (isWriteLatency(client)) {
+	    extendflags |= WRITELATENCY;
+	}
+	hdr->extend.mPayload = 0;
+	if (isPayload(client)) {
+	    // the mode in the top byte, the compress ratio in hundredths below it
+	    extendflags |= PAYLOAD;
+	    hdr->extend.mPayload = htonl((client->mPayload << 24) |
+					 (int) (client->mPayloadRatio * 100 + 0.5));
+	}
         hdr->extend.typelen.type  = htonl(CLIENTHDR);
 	hdr->extend.typelen.length = htonl((sizeof(client_hdrext) - sizeof(hdr_typelen)));
-	hdr->extend.reserved = 0;
 	hdr->extend.version_u = htonl(IPERF_VERSION_MAJORHEX);
 	hdr->extend.version_l = htonl(IPERF_VERSION_MINORHEX);
 	hdr->extend.flags  = htonl(extendflags);
@@ -0,0 +1,199 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * StatsShm.c
+ * -------------------------------------------------------------------
+ * The writer side of --stats-shm, see StatsShm.h for the layout
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "Mutex.h"
+#include "StatsShm.h"
+#include <sys/mman.h>
+
+static StatsShm *statsshm = NULL;
+// serializes slot claims, made from the traffic threads' InitReport()
+static Mutex statsshm_mutex;
+
+/*
+ * Create and map the stats file, a bare name is placed in /dev/shm
+ */
+int StatsShm_Open( const char *path ) {
+    char name[256];
+    int fd;
+
+    if ( strchr( path, '/' ) == NULL ) {
+        snprintf( name, sizeof(name), "/dev/shm/%s", path );
+    } else {
+        snprintf( name, sizeof(name), "%s", path );
+    }
+    fd = open( name, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 ) {
+        return -1;
+    }
+    if ( ftruncate( fd, sizeof(StatsShm) ) < 0 ) {
+        close( fd );
+        return -1;
+    }
+    statsshm = (StatsShm *) mmap( NULL, sizeof(StatsShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if ( statsshm == MAP_FAILED ) {
+        statsshm = NULL;
+        return -1;
+    }
+    Mutex_Initialize( &statsshm_mutex );
+    statsshm->version = STATSSHM_VERSION;
+    statsshm->streams = STATSSHM_STREAMS;
+    statsshm->streamSize = sizeof(StatsShm_Stream);
+    statsshm->pid = getpid();
+    statsshm->running = 1;
+    // monitors check the magic last
+    __atomic_store_n( &statsshm->magic, STATSSHM_MAGIC, __ATOMIC_RELEASE );
+    return 0;
+}
+
+void StatsShm_Close( void ) {
+    if ( statsshm != NULL ) {
+        statsshm->running = 0;
+        munmap( statsshm, sizeof(StatsShm) );
+        statsshm = NULL;
+        Mutex_Destroy( &statsshm_mutex );
+    }
+}
+
+static void statsshm_begin( StatsShm_Stream *slot ) {
+    __atomic_store_n( &slot->seq, slot->seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+static void statsshm_end( StatsShm_Stream *slot ) {
+    __atomic_store_n( &slot->seq, slot->seq + 1, __ATOMIC_RELEASE );
+}
+
+/*
+ * Claim a free slot for a transfer report, NULL when --stats-shm
+ * isn't in use or every slot is taken
+ */
+StatsShm_Stream *StatsShm_Attach( ReportHeader *reporthdr ) {
+    StatsShm_Stream *slot = NULL;
+    ReporterData *data = &reporthdr->report;
+    int ix;
+
+    if ( statsshm == NULL ) {
+        return NULL;
+    }
+    Mutex_Lock( &statsshm_mutex );
+    for ( ix = 0; ix < STATSSHM_STREAMS; ix++ ) {
+        if ( !statsshm->stream[ix].inuse ) {
+            slot = &statsshm->stream[ix];
+            statsshm_begin( slot );
+            memset( ((char *) slot) + sizeof(slot->seq), 0, sizeof(StatsShm_Stream) - sizeof(slot->seq) );
+            slot->inuse = 1;
+            slot->transferID = data->info.transferID;
+            slot->groupID = data->info.groupID;
+            slot->threadMode = data->mThreadMode;
+            slot->udp = isUDP( data ) ? 1 : 0;
+            statsshm_end( slot );
+            break;
+        }
+    }
+    Mutex_Unlock( &statsshm_mutex );
+    return slot;
+}
+
+/*
+ * Copy a report's running totals to its slot, called by the reporter
+ */
+void StatsShm_Publish( StatsShm_Stream *slot, ReportHeader *reporthdr ) {
+    ReporterData *data = &reporthdr->report;
+    Transfer_Info *stats = &data->info;
+    int ix;
+
+    statsshm_begin( slot );
+    slot->startTime = data->startTime.tv_sec + data->startTime.tv_usec / (double) rMillion;
+    slot->lastTime = data->packetTime.tv_sec + data->packetTime.tv_usec / (double) rMillion;
+    slot->bytes = data->TotalLen;
+    if ( isUDP( data ) ) {
+        slot->packets = data->cntDatagrams;
+        slot->errors = data->cntError;
+        slot->outOfOrder = data->cntOutofOrder;
+        slot->jitter = stats->jitter;
+        slot->transitMin = stats->transit.totminTransit;
+        slot->transitMax = stats->transit.totmaxTransit;
+        slot->transitCnt = stats->transit.totcntTransit;
+        slot->transitMean = (stats->transit.totcntTransit > 0) ?
+            stats->transit.totsumTransit / stats->transit.totcntTransit : 0.0;
+    } else if ( data->mThreadMode == kMode_Server ) {
+        slot->packets = stats->tcp.read.totcntRead;
+        for ( ix = 0; ix < STATSSHM_LOG2BINS; ix++ ) {
+            slot->readLog2Bins[ix] = stats->tcp.read.totlog2bins[ix];
+        }
+    } else {
+        slot->packets = stats->tcp.write.totWriteCnt;
+        slot->errors = stats->tcp.write.totWriteErr;
+    }
+    if ( data->cpu != NULL ) {
+        CPUStats cpu;
+        CPUAcct_Sample( data->cpu, &cpu, 1 );
+        slot->cpuSecs = cpu.cpuSecs;
+        slot->cycles = cpu.count[CPUACCT_CYCLES];
+    }
+    statsshm_end( slot );
+}
+
+/*
+ * The report is done, free its slot
+ */
+void StatsShm_Detach( StatsShm_Stream *slot ) {
+    Mutex_Lock( &statsshm_mutex );
+    statsshm_begin( slot );
+    slot->inuse = 0;
+    statsshm_end( slot );
+    Mutex_Unlock( &statsshm_mutex );
+}
@@ -0,0 +1,462 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * Sweep.cpp
+ * -------------------------------------------------------------------
+ * The --sweep matrix.  The streams of the largest combination are
+ * connected once and run every step together, the ones a step has
+ * no use for sit it out.  Steps go round the combinations --trials
+ * times so a slow drift in the path is spread over all of them
+ * rather than landing on the last few.
+ * ------------------------------------------------------------------- */
+
+#include <math.h>
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "PerfSocket.hpp"
+#include "Condition.h"
+#include "Locale.h"
+#include "delay.h"
+#include "util.h"
+#include "Sweep.h"
+
+enum {
+    kSweep_Congestion = 0,
+    kSweep_Window,
+    kSweep_Length,
+    kSweep_Streams,
+    kSweep_Dims
+};
+
+typedef struct SweepDim {
+    char name;
+    int given;
+    int count;
+    char *label[SWEEP_MAX_VALUES];
+    int value[SWEEP_MAX_VALUES];
+} SweepDim;
+
+typedef struct SweepStep {
+    double bandwidth;
+    // usecs, summed over the streams
+    double rtt;
+    int rttcnt;
+    int streams;
+} SweepStep;
+
+static SweepDim sweep_dims[kSweep_Dims] = {
+    { 'Z', 0, 0, {NULL}, {0} },
+    { 'w', 0, 0, {NULL}, {0} },
+    { 'l', 0, 0, {NULL}, {0} },
+    { 'P', 0, 0, {NULL}, {0} }
+};
+static SweepStep *sweep_steps = NULL;
+static int sweep_cells = 0;
+static int sweep_total = 0;
+static int sweep_pool = 0;
+static double sweep_settle = 0;
+static char sweep_format = 'a';
+
+// the barrier between steps
+static Condition sweep_cond;
+static int sweep_streamid = 0;
+static int sweep_arrived = 0;
+static int sweep_generation = 0;
+static int sweep_step = -1;
+static int sweep_done = 0;
+
+static char* sweep_strdup( const char *str ) {
+    char *copy = new char[strlen( str ) + 1];
+    strcpy( copy, str );
+    return copy;
+}
+
+// a byte count as it would be typed, e.g. 256K
+static char* sweep_label( int bytes ) {
+    char label[32];
+    if ( bytes > 0 && (bytes % (1024 * 1024)) == 0 )
+	snprintf( label, sizeof(label), "%dM", bytes / (1024 * 1024) );
+    else if ( bytes > 0 && (bytes % 1024) == 0 )
+	snprintf( label, sizeof(label), "%dK", bytes / 1024 );
+    else
+	snprintf( label, sizeof(label), "%d", bytes );
+    return sweep_strdup( label );
+}
+
+static int sweep_dimension( char *token ) {
+    SweepDim *dim = NULL;
+    char *value, *next;
+
+    for ( int d = 0; d < kSweep_Dims; d++ ) {
+	if ( token[0] == sweep_dims[d].name && token[1] == '=' )
+	    dim = &sweep_dims[d];
+    }
+    if ( dim == NULL || dim->given || token[2] == '\0' )
+	return 0;
+    dim->given = 1;
+    for ( value = &token[2]; value != NULL; value = next ) {
+	if ( (next = strchr( value, ',' )) != NULL )
+	    *next++ = '\0';
+	if ( *value == '\0' || dim->count == SWEEP_MAX_VALUES )
+	    return 0;
+	switch ( dim->name ) {
+	    case 'Z':
+		dim->value[dim->count] = 0;
+		break;
+	    case 'P':
+		dim->value[dim->count] = atoi( value );
+		break;
+	    default:
+		dim->value[dim->count] = byte_atoi( value );
+		break;
+	}
+	if ( dim->name != 'Z' && dim->value[dim->count] <= 0 )
+	    return 0;
+	dim->label[dim->count++] = sweep_strdup( value );
+    }
+    return 1;
+}
+
+int Sweep_Load( const char *spec ) {
+    char *copy = sweep_strdup( spec );
+    char *token, *next;
+    int dims = 0;
+
+    for ( token = copy; *token != '\0'; token = next ) {
+	while ( *token == ';' || isspace( (unsigned char) *token ) )
+	    token++;
+	for ( next = token; *next != '\0' && *next != ';' && !isspace( (unsigned char) *next ); next++ )
+	    ;
+	if ( *next != '\0' )
+	    *next++ = '\0';
+	if ( *token == '\0' )
+	    continue;
+	if ( !sweep_dimension( token ) ) {
+	    fprintf( stderr, warn_sweep_spec, token );
+	    dims = 0;
+	    break;
+	}
+	dims++;
+    }
+    DELETE_ARRAY( copy );
+    return dims;
+}
+
+void Sweep_Init( thread_Settings *client ) {
+    SweepDim *dim;
+
+    if ( isUDP( client ) || client->mMode != kTest_Normal || isFanout( client ) ||
+	 isWriteLatency( client ) || client->mThreadMode != kMode_Client ) {
+	fprintf( stderr, "%s", warn_sweep_mode );
+	unsetSweep( client );
+	return;
+    }
+    // a dimension left out keeps the value from the command line
+    dim = &sweep_dims[kSweep_Congestion];
+    if ( dim->count == 0 ) {
+	dim->label[0] = sweep_strdup( isCongestionControl( client ) ? client->mCongestion : "default" );
+	dim->count = 1;
+    }
+    dim = &sweep_dims[kSweep_Window];
+    if ( dim->count == 0 ) {
+	dim->label[0] = (client->mTCPWin > 0) ? sweep_label( client->mTCPWin ) : sweep_strdup( "default" );
+	dim->value[0] = client->mTCPWin;
+	dim->count = 1;
+    }
+    dim = &sweep_dims[kSweep_Length];
+    if ( dim->count == 0 ) {
+	dim->label[0] = sweep_label( client->mBufLen );
+	dim->value[0] = client->mBufLen;
+	dim->count = 1;
+    }
+    dim = &sweep_dims[kSweep_Streams];
+    if ( dim->count == 0 ) {
+	dim->label[0] = NULL;
+	dim->value[0] = (client->mThreads > 0) ? client->mThreads : 1;
+	dim->count = 1;
+    }
+
+    // the client's buffer and stream pool fit the largest step
+    client->mBufLen = 0;
+    dim = &sweep_dims[kSweep_Length];
+    for ( int i = 0; i < dim->count; i++ ) {
+	if ( dim->value[i] > client->mBufLen )
+	    client->mBufLen = dim->value[i];
+    }
+    sweep_pool = 0;
+    dim = &sweep_dims[kSweep_Streams];
+    for ( int i = 0; i < dim->count; i++ ) {
+	if ( dim->value[i] > sweep_pool )
+	    sweep_pool = dim->value[i];
+    }
+    client->mThreads = sweep_pool;
+
+    sweep_cells = 1;
+    for ( int d = 0; d < kSweep_Dims; d++ )
+	sweep_cells *= sweep_dims[d].count;
+    sweep_total = sweep_cells * client->mTrials;
+    sweep_steps = new SweepStep[sweep_total];
+    memset( sweep_steps, 0, sweep_total * sizeof(SweepStep) );
+    sweep_settle = client->mSweepSettle;
+    sweep_format = client->mFormat;
+    Condition_Initialize( &sweep_cond );
+}
+
+int Sweep_Stream( void ) {
+    int stream;
+
+    Condition_Lock( sweep_cond );
+    stream = sweep_streamid++;
+    Condition_Unlock( sweep_cond );
+    return stream;
+}
+
+/*
+ * A step's value of each dimension, the streams run innermost so the
+ * combinations come out in the order the table prints them
+ */
+static int sweep_index( int step, int which ) {
+    int cell = step % sweep_cells;
+
+    for ( int d = kSweep_Dims - 1; d > which; d-- )
+	cell /= sweep_dims[d].count;
+    return cell % sweep_dims[which].count;
+}
+
+const char* Sweep_Congestion( int step ) {
+    SweepDim *dim = &sweep_dims[kSweep_Congestion];
+    return dim->given ? dim->label[sweep_index( step, kSweep_Congestion )] : NULL;
+}
+
+int Sweep_Window( int step ) {
+    SweepDim *dim = &sweep_dims[kSweep_Window];
+    return dim->given ? dim->value[sweep_index( step, kSweep_Window )] : 0;
+}
+
+int Sweep_Length( int step ) {
+    return sweep_dims[kSweep_Length].value[sweep_index( step, kSweep_Length )];
+}
+
+int Sweep_Streams( int step ) {
+    return sweep_dims[kSweep_Streams].value[sweep_index( step, kSweep_Streams )];
+}
+
+// the settle time, in naps short enough to notice a ^C
+static void sweep_settle_wait( void ) {
+    double left = sweep_settle;
+
+    while ( left > 0 && !sInterupted ) {
+	double nap = (left < 0.1) ? left : 0.1;
+	delay_loop( (unsigned long) (nap * 1e6) );
+	left -= nap;
+    }
+}
+
+int Sweep_Wait( void ) {
+    int step;
+
+    Condition_Lock( sweep_cond );
+    if ( ++sweep_arrived == sweep_pool ) {
+	// the last stream in lets the next step go
+	sweep_arrived = 0;
+	if ( sweep_step >= 0 )
+	    sweep_settle_wait( );
+	if ( ++sweep_step >= sweep_total || sInterupted ) {
+	    sweep_done = 1;
+	} else {
+	    printf( report_sweep_step, sweep_step + 1, sweep_total,
+		    sweep_dims[kSweep_Congestion].label[sweep_index( sweep_step, kSweep_Congestion )],
+		    sweep_dims[kSweep_Window].label[sweep_index( sweep_step, kSweep_Window )],
+		    sweep_dims[kSweep_Length].label[sweep_index( sweep_step, kSweep_Length )],
+		    Sweep_Streams( sweep_step ) );
+	    fflush( stdout );
+	}
+	sweep_generation++;
+	Condition_Broadcast( &sweep_cond );
+    } else {
+	int generation = sweep_generation;
+	while ( generation == sweep_generation )
+	    Condition_Wait( &sweep_cond );
+    }
+    step = sweep_done ? -1 : sweep_step;
+    Condition_Unlock( sweep_cond );
+    return step;
+}
+
+/*
+ * A stream's rate is over its final report, which starts after any
+ * --warmup, and a step's bandwidth is its streams' rates summed.
+ * The RTT is the kernel's smoothed one as the stream ends.
+ */
+void Sweep_Account( ReporterData *stats ) {
+    SweepStep *step = &sweep_steps[stats->mSweepStep - 1];
+    double secs = stats->info.endTime - stats->info.startTime;
+
+    if ( secs > 0 )
+	step->bandwidth += stats->info.TotalLen / secs;
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+    {
+	struct tcp_info info;
+	Socklen_t len = sizeof(info);
+	if ( getsockopt( stats->info.socket, IPPROTO_TCP, TCP_INFO, &info, &len ) == 0 &&
+	     info.tcpi_rtt > 0 ) {
+	    step->rtt += info.tcpi_rtt;
+	    step->rttcnt++;
+	}
+    }
+#endif
+    step->streams++;
+}
+
+/*
+ * Two sided 95% Student's t for 1 to 30 degrees of freedom, the
+ * normal's 1.96 past that
+ */
+static double sweep_t95( int df ) {
+    static const double t95[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    return (df <= 30) ? t95[df - 1] : 1.96;
+}
+
+static int sweep_compare( const void *a, const void *b ) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+typedef struct SweepSummary {
+    double mean;
+    // the 95% confidence interval's half width
+    double ci;
+    double median;
+    double p10;
+    double p90;
+} SweepSummary;
+
+// the p'th percentile of sorted values, between the two nearest
+static double sweep_percentile( const double *values, int count, double p ) {
+    double rank = p * (count - 1);
+    int below = (int) rank;
+
+    if ( below + 1 >= count )
+	return values[count - 1];
+    return values[below] + (rank - below) * (values[below + 1] - values[below]);
+}
+
+// sorts the values
+static void sweep_summarize( double *values, int count, SweepSummary *summary ) {
+    double sum = 0, sumsq = 0;
+
+    for ( int i = 0; i < count; i++ ) {
+	sum += values[i];
+	sumsq += values[i] * values[i];
+    }
+    summary->mean = sum / count;
+    summary->ci = 0;
+    if ( count > 1 ) {
+	double var = (sumsq - count * summary->mean * summary->mean) / (count - 1);
+	if ( var > 0 )
+	    summary->ci = sweep_t95( count - 1 ) * sqrt( var / count );
+    }
+    qsort( values, count, sizeof(double), sweep_compare );
+    summary->median = sweep_percentile( values, count, 0.5 );
+    summary->p10 = sweep_percentile( values, count, 0.1 );
+    summary->p90 = sweep_percentile( values, count, 0.9 );
+}
+
+void Sweep_Print( void ) {
+    char buffer[5][32];
+    double *bandwidth, *rtt;
+    SweepSummary summary;
+
+    if ( sweep_total == 0 )
+	return;
+    bandwidth = new double[sweep_total / sweep_cells];
+    rtt = new double[sweep_total / sweep_cells];
+    printf( "%s", report_sweep_header );
+    for ( int cell = 0; cell < sweep_cells; cell++ ) {
+	const char *congestion = sweep_dims[kSweep_Congestion].label[sweep_index( cell, kSweep_Congestion )];
+	const char *window = sweep_dims[kSweep_Window].label[sweep_index( cell, kSweep_Window )];
+	const char *length = sweep_dims[kSweep_Length].label[sweep_index( cell, kSweep_Length )];
+	int streams = Sweep_Streams( cell );
+	int runs = 0, rtts = 0;
+
+	for ( int step = cell; step < sweep_total; step += sweep_cells ) {
+	    SweepStep *result = &sweep_steps[step];
+	    if ( result->streams == 0 || result->bandwidth <= 0 )
+		continue;
+	    bandwidth[runs++] = result->bandwidth;
+	    if ( result->rttcnt > 0 )
+		rtt[rtts++] = result->rtt / result->rttcnt;
+	}
+	if ( runs == 0 ) {
+	    printf( report_sweep_failed, congestion, window, length, streams );
+	    continue;
+	}
+	sweep_summarize( bandwidth, runs, &summary );
+	byte_snprintf( buffer[0], sizeof(buffer[0]), summary.mean, sweep_format );
+	byte_snprintf( buffer[1], sizeof(buffer[1]), summary.ci, sweep_format );
+	byte_snprintf( buffer[2], sizeof(buffer[2]), summary.median, sweep_format );
+	byte_snprintf( buffer[3], sizeof(buffer[3]), summary.p10, sweep_format );
+	byte_snprintf( buffer[4], sizeof(buffer[4]), summary.p90, sweep_format );
+	printf( report_sweep_format, congestion, window, length, streams, runs,
+		buffer[0], buffer[1], buffer[2], buffer[3], buffer[4] );
+	if ( rtts > 0 ) {
+	    sweep_summarize( rtt, rtts, &summary );
+	    printf( report_sweep_rtt_format, congestion, window, length, streams, rtts,
+		    summary.mean / 1e3, summary.ci / 1e3, summary.median / 1e3,
+		    summary.p10 / 1e3, summary.p90 / 1e3 );
+	}
+    }
+    DELETE_ARRAY( bandwidth );
+    DELETE_ARRAY( rtt );
+    fflush( stdout );
+}
@@ -0,0 +1,229 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * TCPSampler.c
+ * -------------------------------------------------------------------
+ * Periodic TCP_INFO sampling (--tcp-sample).  The sampler thread is
+ * started by the first registered stream and exits when the last
+ * one is removed.  Samples go into a preallocated per-stream ring so
+ * the thread never allocates or prints while the traffic is running.
+ * ------------------------------------------------------------------- */
+
+#include <stddef.h>
+#include "headers.h"
+#include "Mutex.h"
+#include "util.h"
+#include "Locale.h"
+#include "TCPSampler.h"
+
+#ifdef HAVE_TCP_SAMPLER
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * glibc's struct tcp_info stops at tcpi_total_retrans, the kernel
+ * has since appended more fields.  Mirror the ones needed here and
+ * use the returned length to tell if the running kernel filled them.
+ */
+struct tcp_info_ext {
+    struct tcp_info base;
+    uint64_t tcpi_pacing_rate;
+    uint64_t tcpi_max_pacing_rate;
+    uint64_t tcpi_bytes_acked;
+    uint64_t tcpi_bytes_received;
+    uint32_t tcpi_segs_out;
+    uint32_t tcpi_segs_in;
+    uint32_t tcpi_notsent_bytes;
+    uint32_t tcpi_min_rtt;
+    uint32_t tcpi_data_segs_in;
+    uint32_t tcpi_data_segs_out;
+    uint64_t tcpi_delivery_rate;
+};
+
+static Mutex sampler_lock = PTHREAD_MUTEX_INITIALIZER;
+static TCPSampler *sampler_list = NULL;
+static int sampler_running = 0;
+
+static void TCPSampler_Sample( TCPSampler *s, struct timespec *now ) {
+    struct tcp_info_ext ti;
+    socklen_t len = sizeof(ti);
+    TCPSample *sample;
+    long inflight;
+
+    memset(&ti, 0, sizeof(ti));
+    if (getsockopt(s->sock, IPPROTO_TCP, TCP_INFO, &ti, &len) < 0) {
+	// the socket is likely being closed, stop polling it
+	s->failed = 1;
+	return;
+    }
+    sample = &s->ring[s->count % s->depth];
+    sample->usecs = (uint32_t) ((now->tv_sec - s->start.tv_sec) * 1000000 +
+				(now->tv_nsec - s->start.tv_nsec) / 1000);
+    sample->cwnd = ti.base.tcpi_snd_cwnd;
+    sample->srtt = ti.base.tcpi_rtt;
+    sample->rttvar = ti.base.tcpi_rttvar;
+    sample->retrans = ti.base.tcpi_total_retrans;
+    // packets in flight per the kernel's tcp_packets_in_flight()
+    inflight = (long) ti.base.tcpi_unacked - ti.base.tcpi_sacked -
+	ti.base.tcpi_lost + ti.base.tcpi_retrans;
+    sample->inflight = (inflight > 0) ? (uint32_t) (inflight * ti.base.tcpi_snd_mss) : 0;
+    sample->pacing_rate = (len >= offsetof(struct tcp_info_ext, tcpi_max_pacing_rate)) ?
+	ti.tcpi_pacing_rate : 0;
+    sample->delivery_rate = (len >= sizeof(struct tcp_info_ext)) ?
+	ti.tcpi_delivery_rate : 0;
+    s->count++;
+}
+
+static void* TCPSampler_Run( void *arg ) {
+    struct timespec next, now;
+    TCPSampler *s;
+    long period;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    Mutex_Lock(&sampler_lock);
+    while (sampler_list != NULL) {
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	period = 0;
+	for (s = sampler_list; s != NULL; s = s->next) {
+	    if (!s->failed)
+		TCPSampler_Sample(s, &now);
+	    if (period == 0 || s->period < period)
+		period = s->period;
+	}
+	Mutex_Unlock(&sampler_lock);
+
+	// absolute deadlines so the period doesn't drift, but don't
+	// try to catch up after falling behind
+	next.tv_nsec += period * 1000;
+	while (next.tv_nsec >= 1000000000) {
+	    next.tv_nsec -= 1000000000;
+	    next.tv_sec++;
+	}
+	if (next.tv_sec < now.tv_sec ||
+	    (next.tv_sec == now.tv_sec && next.tv_nsec < now.tv_nsec)) {
+	    next = now;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	Mutex_Lock(&sampler_lock);
+    }
+    sampler_running = 0;
+    Mutex_Unlock(&sampler_lock);
+    return NULL;
+}
+
+TCPSampler* TCPSampler_Start( int sock, int usecs, int depth ) {
+    TCPSampler *s;
+    pthread_t tid;
+
+    s = (TCPSampler *) calloc(1, sizeof(TCPSampler));
+    if (s == NULL)
+	return NULL;
+    s->sock = sock;
+    s->period = (usecs < TCPSAMPLE_MIN_USECS) ? TCPSAMPLE_MIN_USECS : usecs;
+    s->depth = (depth <= 0) ? TCPSAMPLE_DEFAULT_DEPTH :
+	((depth > TCPSAMPLE_MAX_DEPTH) ? TCPSAMPLE_MAX_DEPTH : depth);
+    s->ring = (TCPSample *) malloc(s->depth * sizeof(TCPSample));
+    if (s->ring == NULL) {
+	free(s);
+	return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &s->start);
+
+    Mutex_Lock(&sampler_lock);
+    s->next = sampler_list;
+    sampler_list = s;
+    if (!sampler_running) {
+	if (pthread_create(&tid, NULL, TCPSampler_Run, NULL) != 0) {
+	    WARN_errno(1, "pthread_create");
+	    sampler_list = s->next;
+	    Mutex_Unlock(&sampler_lock);
+	    free(s->ring);
+	    free(s);
+	    return NULL;
+	}
+	pthread_detach(tid);
+	sampler_running = 1;
+    }
+    Mutex_Unlock(&sampler_lock);
+    return s;
+}
+
+void TCPSampler_Stop( TCPSampler *s ) {
+    TCPSampler **prev;
+    unsigned long ix, first;
+    TCPSample *sample;
+
+    Mutex_Lock(&sampler_lock);
+    for (prev = &sampler_list; *prev != NULL; prev = &(*prev)->next) {
+	if (*prev == s) {
+	    *prev = s->next;
+	    break;
+	}
+    }
+    Mutex_Unlock(&sampler_lock);
+
+    // the sampler thread no longer sees s, the ring is ours to print
+    first = (s->count > (unsigned long) s->depth) ? s->count - s->depth : 0;
+    printf(report_tcpsample_header, s->sock, s->period, s->count - first, first);
+    for (ix = first; ix < s->count; ix++) {
+	sample = &s->ring[ix % s->depth];
+	printf(report_tcpsample_format, s->sock,
+	       sample->usecs / 1e6, sample->cwnd, sample->srtt, sample->rttvar,
+	       sample->inflight, sample->retrans,
+	       sample->pacing_rate * 8, sample->delivery_rate * 8);
+    }
+    fflush(stdout);
+    free(s->ring);
+    free(s);
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // HAVE_TCP_SAMPLER
@@ -0,0 +1,136 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * TimeBuckets.c
+ * -------------------------------------------------------------------
+ * Setup and output for the --time-buckets series, the per packet
+ * accounting is inline in TimeBuckets.h
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "Locale.h"
+#include "util.h"
+#include "TimeBuckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TimeBuckets* TimeBuckets_Init( thread_Settings *agent ) {
+    TimeBuckets *tb;
+    double secs = 0;
+
+    if ( !isTimeBuckets( agent ) )
+	return NULL;
+    tb = (TimeBuckets *) calloc( 1, sizeof(TimeBuckets) );
+    if ( tb == NULL ) {
+	WARN( 1, "Out of memory for time buckets" );
+	return NULL;
+    }
+    tb->id = agent->mSock;
+    tb->usecs = agent->mBucketUsecs;
+    tb->last = -1;
+    // -t is known up front for clients and for servers run with -t,
+    // allow a second of slack for connection and FIN handling
+    if ( (agent->mThreadMode == kMode_Client && isModeTime( agent )) ||
+	 (agent->mThreadMode == kMode_Server && isServerModeTime( agent )) ) {
+	secs = agent->mAmount / 100.0 + 1.0;
+    }
+    if ( secs > 0 ) {
+	double count = secs * 1e6 / tb->usecs;
+	tb->count = (count < TIMEBUCKETS_MAX_COUNT) ? (long) count : TIMEBUCKETS_MAX_COUNT;
+    } else {
+	tb->count = TIMEBUCKETS_DEFAULT_COUNT;
+    }
+    // calloc so untouched pages of a long array cost nothing
+    tb->bucket = (TimeBucket *) calloc( tb->count, sizeof(TimeBucket) );
+    if ( tb->bucket == NULL ) {
+	WARN( 1, "Out of memory for time buckets" );
+	free( tb );
+	return NULL;
+    }
+    if ( agent->reporthdr != NULL ) {
+	tb->start = agent->reporthdr->report.startTime;
+    } else {
+	gettimeofday( &tb->start, NULL );
+    }
+    return tb;
+}
+
+void TimeBuckets_End( TimeBuckets *tb ) {
+    long ix, peak = -1, populated = 0;
+
+    if ( tb == NULL )
+	return;
+    for ( ix = 0; ix <= tb->last; ix++ ) {
+	if ( tb->bucket[ix].packets ) {
+	    populated++;
+	    if ( peak < 0 || tb->bucket[ix].bytes > tb->bucket[peak].bytes )
+		peak = ix;
+	}
+    }
+    printf( report_timebuckets_header, tb->id, tb->usecs, populated, tb->last + 1,
+	    (peak < 0) ? 0.0 : tb->bucket[peak].bytes * 8e6 / tb->usecs,
+	    (peak < 0) ? 0.0 : peak * tb->usecs / 1e6 );
+    if ( tb->latePackets ) {
+	printf( report_timebuckets_late, tb->id, tb->latePackets, tb->lateBytes );
+    }
+    for ( ix = 0; ix <= tb->last; ix++ ) {
+	if ( tb->bucket[ix].packets ) {
+	    printf( report_timebuckets_format, tb->id, ix * tb->usecs / 1e6,
+		    tb->bucket[ix].packets, tb->bucket[ix].bytes );
+	}
+    }
+    fflush( stdout );
+    free( tb->bucket );
+    free( tb );
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
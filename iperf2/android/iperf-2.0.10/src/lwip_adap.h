@@ -1,9 +1,17 @@
 #ifndef __IPERF__LWIP__ADP__
 #define  __IPERF__LWIP__ADP__
 
+#ifndef IPERF_USE_LWIP
 #define IPERF_USE_LWIP 0
+#endif
+
+// the run-to-completion build drives lwIP's raw API from one loop
+// (lwip_rtc.c) and never goes through the sockets below
+#ifndef IPERF_LWIP_RTC
+#define IPERF_LWIP_RTC 0
+#endif
 
-#if IPERF_USE_LWIP
+#if IPERF_USE_LWIP && !IPERF_LWIP_RTC
 
 int lwip_accept(int s, struct sockaddr *addr, socklen_t *addrlen);
 int lwip_bind(int s, const struct sockaddr *name, socklen_t namelen);
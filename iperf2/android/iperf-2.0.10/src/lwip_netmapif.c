@@ -0,0 +1,457 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * lwip_netmapif.c
+ * -------------------------------------------------------------------
+ * An lwIP netif driver on netmap rings, so the IPERF_USE_LWIP build
+ * runs TCP/UDP entirely in userspace over a NIC, a VALE port or a
+ * netmap pipe.
+ *
+ * A poll thread walks the RX rings in batches and hands frames to
+ * the tcpip thread.  With a NO_SYS lwIP there are no threads at all,
+ * the iperf-lwip-rtc loop calls lwip_netmap_poll() which receives,
+ * flushes the TX rings once per pass and runs the lwIP timers.  Where possible the frames aren't copied: the
+ * port is opened with a pool of extra buffers, an RX slot's buffer
+ * is lent to a custom pbuf and the slot gets a spare buffer in its
+ * place.  The buffer returns to the pool when lwIP frees the pbuf.
+ * Once the pool runs dry frames are copied into PBUF_POOL pbufs.
+ * Transmit copies the pbuf chain into a TX slot.
+ * ------------------------------------------------------------------- */
+
+#include "lwip_netmapif.h"
+
+#if IPERF_USE_LWIP
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/mem.h"
+#include "lwip/memp.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "netif/etharp.h"
+#if NO_SYS
+#include "lwip/init.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+#include <time.h>
+#endif
+
+#define NETMAP_WITH_LIBS
+#include <net/netmap_user.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#define NETMAPIF_EXTRA_BUFS  4096   // zero-copy RX pool
+#define NETMAPIF_RX_BATCH    256    // frames per ring per pass
+#define NETMAPIF_POLL_MSECS  100
+
+// lending buffers needs custom pbufs and frames without leading padding
+#if LWIP_SUPPORT_CUSTOM_PBUF && ETH_PAD_SIZE == 0
+#define NETMAPIF_ZEROCOPY 1
+#else
+#define NETMAPIF_ZEROCOPY 0
+#endif
+
+struct netmapif {
+    struct nm_desc *desc;
+    struct netif *netif;
+    // spare netmap buffers, swapped into RX slots lent to pbufs
+    uint32_t *spare;
+    int nspare;
+    int maxspare;
+    // NO_SYS: frames queued since the last NIOCTXSYNC
+    int txpending;
+};
+
+#if NETMAPIF_ZEROCOPY
+struct netmapif_pbuf {
+    struct pbuf_custom pc;
+    struct netmapif *nmif;
+    uint32_t buf_idx;
+};
+
+LWIP_MEMPOOL_DECLARE(NETMAPIF_RX, NETMAPIF_EXTRA_BUFS, sizeof(struct netmapif_pbuf), "netmap rx");
+
+/* -------------------------------------------------------------------
+ * A lent RX buffer is back, return it to the spare pool
+ * ------------------------------------------------------------------- */
+static void netmapif_pbuf_free(struct pbuf *p) {
+    struct netmapif_pbuf *q = (struct netmapif_pbuf *) p;
+    struct netmapif *nmif = q->nmif;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    nmif->spare[nmif->nspare++] = q->buf_idx;
+    SYS_ARCH_UNPROTECT(lev);
+    LWIP_MEMPOOL_FREE(NETMAPIF_RX, q);
+}
+#endif
+
+/* -------------------------------------------------------------------
+ * Wrap a received frame in a pbuf, lending the slot's buffer when a
+ * spare is available and copying otherwise
+ * ------------------------------------------------------------------- */
+static struct pbuf *netmapif_frame(struct netmapif *nmif, struct netmap_ring *ring,
+                                   struct netmap_slot *slot, uint32_t *spare, int *nspare) {
+    char *buf = NETMAP_BUF(ring, slot->buf_idx);
+    struct pbuf *p;
+
+#if NETMAPIF_ZEROCOPY
+    if (*nspare > 0) {
+        struct netmapif_pbuf *q = (struct netmapif_pbuf *) LWIP_MEMPOOL_ALLOC(NETMAPIF_RX);
+        if (q != NULL) {
+            q->pc.custom_free_function = netmapif_pbuf_free;
+            q->nmif = nmif;
+            q->buf_idx = slot->buf_idx;
+            p = pbuf_alloced_custom(PBUF_RAW, slot->len, PBUF_REF, &q->pc,
+                                    buf, ring->nr_buf_size);
+            slot->buf_idx = spare[--(*nspare)];
+            slot->flags |= NS_BUF_CHANGED;
+            return p;
+        }
+    }
+#endif
+    p = pbuf_alloc(PBUF_RAW, slot->len + ETH_PAD_SIZE, PBUF_POOL);
+    if (p != NULL) {
+#if ETH_PAD_SIZE
+        pbuf_header(p, -ETH_PAD_SIZE);
+#endif
+        pbuf_take(p, buf, slot->len);
+#if ETH_PAD_SIZE
+        pbuf_header(p, ETH_PAD_SIZE);
+#endif
+    }
+    return p;
+}
+
+/* -------------------------------------------------------------------
+ * Pass up to NETMAPIF_RX_BATCH frames per RX ring to lwIP, returns
+ * how many were taken off the rings
+ * ------------------------------------------------------------------- */
+static int netmapif_rx(struct netif *netif) {
+    struct netmapif *nmif = (struct netmapif *) netif->state;
+    struct nm_desc *d = nmif->desc;
+    uint32_t spare[NETMAPIF_RX_BATCH];
+    int nspare, r, frames = 0;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    for (r = d->first_rx_ring; r <= d->last_rx_ring; r++) {
+        struct netmap_ring *ring = NETMAP_RXRING(d->nifp, r);
+        uint32_t n = nm_ring_space(ring), cur = ring->cur;
+        if (n == 0)
+            continue;
+        if (n > NETMAPIF_RX_BATCH)
+            n = NETMAPIF_RX_BATCH;
+        frames += n;
+
+        // take the batch's worth of spare buffers in one go
+        SYS_ARCH_PROTECT(lev);
+        nspare = ((int) n < nmif->nspare) ? (int) n : nmif->nspare;
+        nmif->nspare -= nspare;
+        memcpy(spare, nmif->spare + nmif->nspare, nspare * sizeof(uint32_t));
+        SYS_ARCH_UNPROTECT(lev);
+
+        while (n-- > 0) {
+            struct netmap_slot *slot = &ring->slot[cur];
+            struct pbuf *p = netmapif_frame(nmif, ring, slot, spare, &nspare);
+            cur = nm_ring_next(ring, cur);
+            if (p == NULL) {
+                LINK_STATS_INC(link.memerr);
+                LINK_STATS_INC(link.drop);
+                continue;
+            }
+            LINK_STATS_INC(link.recv);
+            if (netif->input(p, netif) != ERR_OK) {
+                pbuf_free(p);
+            }
+        }
+        ring->head = ring->cur = cur;
+
+        // give back whatever the batch didn't use
+        SYS_ARCH_PROTECT(lev);
+        memcpy(nmif->spare + nmif->nspare, spare, nspare * sizeof(uint32_t));
+        nmif->nspare += nspare;
+        SYS_ARCH_UNPROTECT(lev);
+    }
+    return frames;
+}
+
+#if !NO_SYS
+static void netmapif_thread(void *arg) {
+    struct netif *netif = (struct netif *) arg;
+    struct netmapif *nmif = (struct netmapif *) netif->state;
+    struct pollfd pfd;
+
+    pfd.fd = nmif->desc->fd;
+    pfd.events = POLLIN;
+    for (;;) {
+        pfd.revents = 0;
+        if (poll(&pfd, 1, NETMAPIF_POLL_MSECS) > 0) {
+            netmapif_rx(netif);
+        }
+    }
+}
+#endif
+
+/* -------------------------------------------------------------------
+ * linkoutput, called from the tcpip thread only.  NO_SYS builds leave
+ * the sync to lwip_netmap_poll() so a pass's frames go out together.
+ * ------------------------------------------------------------------- */
+static err_t netmapif_linkoutput(struct netif *netif, struct pbuf *p) {
+    struct netmapif *nmif = (struct netmapif *) netif->state;
+    struct nm_desc *d = nmif->desc;
+    int r, tries;
+
+    if (p->tot_len - ETH_PAD_SIZE > NETMAP_TXRING(d->nifp, d->first_tx_ring)->nr_buf_size) {
+        LINK_STATS_INC(link.lenerr);
+        return ERR_BUF;
+    }
+    for (tries = 0; tries < 2; tries++) {
+        for (r = d->first_tx_ring; r <= d->last_tx_ring; r++) {
+            struct netmap_ring *ring = NETMAP_TXRING(d->nifp, r);
+            struct netmap_slot *slot;
+            if (nm_ring_empty(ring))
+                continue;
+            slot = &ring->slot[ring->cur];
+            slot->len = pbuf_copy_partial(p, NETMAP_BUF(ring, slot->buf_idx),
+                                          p->tot_len - ETH_PAD_SIZE, ETH_PAD_SIZE);
+            ring->head = ring->cur = nm_ring_next(ring, ring->cur);
+#if NO_SYS
+            nmif->txpending = 1;
+#else
+            ioctl(d->fd, NIOCTXSYNC, NULL);
+#endif
+            LINK_STATS_INC(link.xmit);
+            return ERR_OK;
+        }
+        // every ring is full, reclaim completed slots and retry once
+        ioctl(d->fd, NIOCTXSYNC, NULL);
+        nmif->txpending = 0;
+    }
+    LINK_STATS_INC(link.drop);
+    return ERR_MEM;
+}
+
+err_t netmapif_init(struct netif *netif) {
+    const char *port = (const char *) netif->state;
+    struct netmapif *nmif;
+    struct nmreq req;
+    uint32_t idx;
+
+    nmif = (struct netmapif *) mem_malloc(sizeof(struct netmapif));
+    if (nmif == NULL)
+        return ERR_MEM;
+    memset(nmif, 0, sizeof(*nmif));
+
+    memset(&req, 0, sizeof(req));
+    req.nr_arg3 = NETMAPIF_EXTRA_BUFS;
+    nmif->desc = nm_open(port, &req, 0, NULL);
+    if (nmif->desc == NULL) {
+        fprintf(stderr, "lwIP netmap netif: can't open %s\n", port);
+        mem_free(nmif);
+        return ERR_IF;
+    }
+
+    // collect the extra buffers, chained through their first word
+    nmif->maxspare = nmif->desc->req.nr_arg3;
+    nmif->spare = (uint32_t *) malloc((nmif->maxspare + 1) * sizeof(uint32_t));
+    if (nmif->spare == NULL) {
+        nm_close(nmif->desc);
+        mem_free(nmif);
+        return ERR_MEM;
+    }
+    for (idx = nmif->desc->nifp->ni_bufs_head; idx != 0 && nmif->nspare < nmif->maxspare;
+         idx = *(uint32_t *) NETMAP_BUF(NETMAP_RXRING(nmif->desc->nifp, 0), idx)) {
+        nmif->spare[nmif->nspare++] = idx;
+    }
+    // they're ours for the life of the process
+    nmif->desc->nifp->ni_bufs_head = 0;
+#if NETMAPIF_ZEROCOPY
+    LWIP_MEMPOOL_INIT(NETMAPIF_RX);
+#endif
+
+    nmif->netif = netif;
+    netif->state = nmif;
+    netif->name[0] = 'n';
+    netif->name[1] = 'm';
+    netif->output = etharp_output;
+    netif->linkoutput = netmapif_linkoutput;
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+    // a locally administered mac made from the IPv4 address
+    netif->hwaddr_len = ETH_HWADDR_LEN;
+    netif->hwaddr[0] = 0x02;
+    netif->hwaddr[1] = 0x00;
+    memcpy(&netif->hwaddr[2], &ip4_addr_get_u32(netif_ip4_addr(netif)), 4);
+
+#if !NO_SYS
+    sys_thread_new("netmapif", netmapif_thread, netif,
+                   DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
+#endif
+    return ERR_OK;
+}
+
+struct netmapif_start {
+    struct netif netif;
+    ip4_addr_t addr, mask, gw;
+    const char *port;
+#if !NO_SYS
+    sys_sem_t done;
+#endif
+    int err;
+};
+
+#if NO_SYS
+static struct netif *netmapif_netif;
+
+u32_t sys_now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (u32_t) (t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+/* -------------------------------------------------------------------
+ * One pass of the NO_SYS loop: receive, send what lwIP queued and
+ * run the timers.  Waits up to msecs for frames when there's nothing
+ * to do, msecs of 0 busy polls.  Returns the number of frames lwIP
+ * was offered.
+ * ------------------------------------------------------------------- */
+int lwip_netmap_poll(int msecs) {
+    struct netmapif *nmif = (struct netmapif *) netmapif_netif->state;
+    struct pollfd pfd;
+    int n = 0;
+
+    pfd.fd = nmif->desc->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, nmif->txpending ? 0 : msecs) > 0) {
+        n = netmapif_rx(netmapif_netif);
+    }
+    sys_check_timeouts();
+    if (nmif->txpending) {
+        ioctl(nmif->desc->fd, NIOCTXSYNC, NULL);
+        nmif->txpending = 0;
+    }
+    return n;
+}
+
+int lwip_netmap_start(void) {
+    static struct netmapif_start s;
+    const char *addr = getenv("IPERF_LWIP_ADDR");
+    const char *mask = getenv("IPERF_LWIP_NETMASK");
+    const char *gw = getenv("IPERF_LWIP_GW");
+
+    s.port = getenv("IPERF_LWIP_NETMAP");
+    if (s.port == NULL || addr == NULL) {
+        fprintf(stderr, "lwIP netmap netif: set IPERF_LWIP_NETMAP and IPERF_LWIP_ADDR\n");
+        return -1;
+    }
+    if (!ip4addr_aton(addr, &s.addr) ||
+        !ip4addr_aton((mask != NULL) ? mask : "255.255.255.0", &s.mask) ||
+        !ip4addr_aton((gw != NULL) ? gw : "0.0.0.0", &s.gw)) {
+        fprintf(stderr, "lwIP netmap netif: bad address\n");
+        return -1;
+    }
+    lwip_init();
+    if (netif_add(&s.netif, &s.addr, &s.mask, &s.gw, (void *) s.port,
+                  netmapif_init, ethernet_input) == NULL) {
+        return -1;
+    }
+    netif_set_default(&s.netif);
+    netif_set_up(&s.netif);
+    netmapif_netif = &s.netif;
+    return 0;
+}
+#else
+// runs in the tcpip thread once it is up
+static void netmapif_tcpip_ready(void *arg) {
+    struct netmapif_start *s = (struct netmapif_start *) arg;
+
+    if (netif_add(&s->netif, &s->addr, &s->mask, &s->gw, (void *) s->port,
+                  netmapif_init, tcpip_input) == NULL) {
+        s->err = 1;
+    } else {
+        netif_set_default(&s->netif);
+        netif_set_up(&s->netif);
+    }
+    sys_sem_signal(&s->done);
+}
+
+int lwip_netmap_start(void) {
+    static struct netmapif_start s;
+    const char *addr = getenv("IPERF_LWIP_ADDR");
+    const char *mask = getenv("IPERF_LWIP_NETMASK");
+    const char *gw = getenv("IPERF_LWIP_GW");
+
+    s.port = getenv("IPERF_LWIP_NETMAP");
+    if (s.port == NULL || addr == NULL) {
+        fprintf(stderr, "lwIP netmap netif: set IPERF_LWIP_NETMAP and IPERF_LWIP_ADDR\n");
+        return -1;
+    }
+    if (!ip4addr_aton(addr, &s.addr) ||
+        !ip4addr_aton((mask != NULL) ? mask : "255.255.255.0", &s.mask) ||
+        !ip4addr_aton((gw != NULL) ? gw : "0.0.0.0", &s.gw)) {
+        fprintf(stderr, "lwIP netmap netif: bad address\n");
+        return -1;
+    }
+    if (sys_sem_new(&s.done, 0) != ERR_OK)
+        return -1;
+    tcpip_init(netmapif_tcpip_ready, &s);
+    sys_sem_wait(&s.done);
+    sys_sem_free(&s.done);
+    return s.err ? -1 : 0;
+}
+#endif /* NO_SYS */
+
+#endif /* IPERF_USE_LWIP */
@@ -0,0 +1,38 @@
+#ifndef __IPERF__LWIP__NETMAPIF__
+#define  __IPERF__LWIP__NETMAPIF__
+
+/*
+ * lwIP netif on a netmap port, used by the iperf-lwip build (see
+ * src/Makefile.am).  The stack is configured from the environment:
+ *
+ *   IPERF_LWIP_NETMAP   netmap port, e.g. vale0:a or netmap:eth0 (required)
+ *   IPERF_LWIP_ADDR     IPv4 address of the netif (required)
+ *   IPERF_LWIP_NETMASK  default 255.255.255.0
+ *   IPERF_LWIP_GW       default none
+ */
+
+#if IPERF_USE_LWIP
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct netif;
+
+/* netif_add() init callback, state is the netmap port name */
+signed char netmapif_init(struct netif *netif);
+
+/* bring up lwIP and the netmap netif, returns 0 on success */
+int lwip_netmap_start(void);
+
+/* NO_SYS lwIP only: receive, flush TX and run the timers once,
+   waiting up to msecs for frames; returns the frames received */
+int lwip_netmap_poll(int msecs);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif
+
+#endif /*__IPERF__LWIP__NETMAPIF__*/
@@ -0,0 +1,431 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ *
+ * lwip_rtc.c
+ * -------------------------------------------------------------------
+ * Run-to-completion mode for the iperf-lwip-rtc build.  A NO_SYS lwIP,
+ * the netmap netif and all of the test's TCP streams share a single
+ * thread: each pass of the loop receives a batch of frames, lets
+ * lwIP's raw API callbacks move the streams along, flushes the TX
+ * rings and hands the packet events to the reporter, all without a
+ * context switch or a mailbox.
+ *
+ * Client streams write straight from a shared pattern buffer that
+ * lwIP references instead of copying.  Server streams report each
+ * received pbuf chain as one read.
+ * ------------------------------------------------------------------- */
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "Locale.h"
+#include "util.h"
+#include "SocketAddr.h"
+#include "PerfSocket.hpp"
+#include "lwip_adap.h"
+#include "lwip_rtc.h"
+
+#if IPERF_LWIP_RTC
+
+#include "lwip/opt.h"
+#include "lwip/tcp.h"
+#include "lwip_netmapif.h"
+
+#define RTC_WAIT_MSECS  1     // poll wait while streams are running
+#define RTC_IDLE_MSECS  100   // poll wait for a server with no streams
+
+enum {
+    RTC_CONNECTING,
+    RTC_RUNNING,
+    RTC_CLOSING,
+    RTC_DONE
+};
+
+struct rtc_stream {
+    thread_Settings *mSettings;
+    struct tcp_pcb *pcb;
+    ReportStruct packet;
+    struct timeval endTime;
+    int state;
+    struct rtc_stream *next;
+};
+
+static struct rtc_stream *rtc_streams = NULL;
+// client write buffer, the pattern with the client header in front
+// as Client::InitiateServer() leaves it; lwIP references it directly
+static char *rtc_buf = NULL;
+// transfer IDs stand in for the socket descriptors
+static int rtc_transferID = 3;
+
+static void rtc_now( struct timeval *now ) {
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec t1;
+    clock_gettime( CLOCK_REALTIME, &t1 );
+    now->tv_sec = t1.tv_sec;
+    now->tv_usec = t1.tv_nsec / 1000;
+#else
+    gettimeofday( now, NULL );
+#endif
+}
+
+static void rtc_sockaddr( iperf_sockaddr *sa, Socklen_t *len, const ip_addr_t *ip, u16_t port ) {
+    struct sockaddr_in *in = (struct sockaddr_in *) sa;
+
+    memset( sa, 0, sizeof(iperf_sockaddr) );
+    in->sin_family = AF_INET;
+    in->sin_addr.s_addr = ip4_addr_get_u32( ip_2_ip4( ip ) );
+    in->sin_port = htons( port );
+    *len = sizeof(struct sockaddr_in);
+}
+
+/* -------------------------------------------------------------------
+ * ReportPacket() waits for the reporter when a report's ring is full,
+ * with no reporter thread that would never return, so drain the ring
+ * here once it is half full
+ * ------------------------------------------------------------------- */
+static void rtc_report( struct rtc_stream *st ) {
+    ReportHeader *reporthdr = st->mSettings->reporthdr;
+
+    ReportPacket( reporthdr, &st->packet );
+    if ( (reporthdr->agentindex - reporthdr->reporterindex + reporthdr->depth) % reporthdr->depth
+         > reporthdr->depth / 2 ) {
+        reporter_poll();
+    }
+}
+
+/* -------------------------------------------------------------------
+ * Close out a stream's report and its pcb.  There's no reporter
+ * thread, so the final packet event is delivered here before
+ * EndReport() waits on it.
+ * ------------------------------------------------------------------- */
+static void rtc_stream_end( struct rtc_stream *st ) {
+    if ( st->state == RTC_RUNNING ) {
+        rtc_now( &st->packet.packetTime );
+        st->packet.packetLen = 0;
+        CloseReport( st->mSettings->reporthdr, &st->packet );
+        reporter_poll();
+        EndReport( st->mSettings->reporthdr );
+    }
+    st->state = RTC_CLOSING;
+    if ( st->pcb != NULL ) {
+        tcp_arg( st->pcb, NULL );
+        tcp_recv( st->pcb, NULL );
+        tcp_sent( st->pcb, NULL );
+        tcp_err( st->pcb, NULL );
+        // out of memory, retried by the loop
+        if ( tcp_close( st->pcb ) != ERR_OK ) {
+            return;
+        }
+        st->pcb = NULL;
+    }
+    st->state = RTC_DONE;
+}
+
+static void rtc_err( void *arg, err_t err ) {
+    struct rtc_stream *st = (struct rtc_stream *) arg;
+
+    if ( st != NULL ) {
+        // lwIP has already freed the pcb
+        st->pcb = NULL;
+        if ( st->state == RTC_CONNECTING ) {
+            fprintf( stderr, "lwIP connect failed (%d)\n", (int) err );
+        }
+        rtc_stream_end( st );
+    }
+}
+
+static struct rtc_stream *rtc_stream_new( thread_Settings *settings, struct tcp_pcb *pcb ) {
+    struct rtc_stream *st = (struct rtc_stream *) calloc( 1, sizeof(struct rtc_stream) );
+
+    FAIL( st == NULL, "Out of Memory!!\n", settings );
+    st->mSettings = settings;
+    st->pcb = pcb;
+    st->state = RTC_CONNECTING;
+    st->next = rtc_streams;
+    rtc_streams = st;
+    tcp_arg( pcb, st );
+    tcp_err( pcb, rtc_err );
+    return st;
+}
+
+static void rtc_stream_start( struct rtc_stream *st ) {
+    thread_Settings *settings = st->mSettings;
+
+    rtc_sockaddr( &settings->local, &settings->size_local, &st->pcb->local_ip, st->pcb->local_port );
+    rtc_sockaddr( &settings->peer, &settings->size_peer, &st->pcb->remote_ip, st->pcb->remote_port );
+    settings->mSock = rtc_transferID++;
+    st->packet.packetID = 0;
+    st->packet.socket = settings->mSock;
+    settings->reporthdr = InitReport( settings );
+    rtc_now( &st->endTime );
+    if ( isModeTime( settings ) ) {
+        st->endTime.tv_sec += settings->mAmount / 100;
+        st->endTime.tv_usec += (settings->mAmount % 100) * 10000;
+        if ( st->endTime.tv_usec >= rMillion ) {
+            st->endTime.tv_sec++;
+            st->endTime.tv_usec -= rMillion;
+        }
+    }
+    st->state = RTC_RUNNING;
+}
+
+/* -------------------------------------------------------------------
+ * Client: queue as much as the send buffer takes, one packet event
+ * per tcp_write(), then push it out with a single tcp_output()
+ * ------------------------------------------------------------------- */
+static void rtc_client_send( struct rtc_stream *st ) {
+    thread_Settings *settings = st->mSettings;
+    int queued = 0;
+
+    while ( st->state == RTC_RUNNING ) {
+        u32_t len = settings->mBufLen;
+        u32_t avail = tcp_sndbuf( st->pcb );
+
+        rtc_now( &st->packet.packetTime );
+        if ( isModeTime( settings ) ? !timercmp( &st->packet.packetTime, &st->endTime, < )
+                                    : settings->mAmount == 0 ) {
+            rtc_stream_end( st );
+            return;
+        }
+        if ( len > avail )
+            len = avail;
+        if ( len > 0xffff )
+            len = 0xffff;
+        if ( !isModeTime( settings ) && len > settings->mAmount )
+            len = (u32_t) settings->mAmount;
+        if ( len == 0 || tcp_write( st->pcb, rtc_buf, (u16_t) len, 0 ) != ERR_OK ) {
+            // the send buffer or the segment queue is full, wait for acks
+            break;
+        }
+        if ( !isModeTime( settings ) )
+            settings->mAmount -= len;
+        st->packet.packetLen = len;
+        rtc_report( st );
+        queued = 1;
+    }
+    if ( queued ) {
+        tcp_output( st->pcb );
+    }
+}
+
+static err_t rtc_client_sent( void *arg, struct tcp_pcb *pcb, u16_t len ) {
+    rtc_client_send( (struct rtc_stream *) arg );
+    return ERR_OK;
+}
+
+// anything the server sends is dropped, its close ends the test
+static err_t rtc_client_recv( void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err ) {
+    if ( p == NULL ) {
+        rtc_stream_end( (struct rtc_stream *) arg );
+    } else {
+        tcp_recved( pcb, p->tot_len );
+        pbuf_free( p );
+    }
+    return ERR_OK;
+}
+
+static err_t rtc_client_connected( void *arg, struct tcp_pcb *pcb, err_t err ) {
+    struct rtc_stream *st = (struct rtc_stream *) arg;
+
+    if ( err != ERR_OK ) {
+        // the stream (this build's client thread) ends before it
+        // started, rtc_err() isn't wanted for the abort
+        fprintf( stderr, "lwIP connect failed (%d)\n", (int) err );
+        tcp_arg( pcb, NULL );
+        tcp_err( pcb, NULL );
+        tcp_abort( pcb );
+        st->pcb = NULL;
+        rtc_stream_end( st );
+        return ERR_ABRT;
+    }
+    rtc_stream_start( st );
+    tcp_sent( pcb, rtc_client_sent );
+    tcp_recv( pcb, rtc_client_recv );
+    rtc_client_send( st );
+    return ERR_OK;
+}
+
+static int rtc_client_init( thread_Settings *clients ) {
+    int bufLen = (clients->mBufLen > SIZEOF_MAXHDRMSG) ? clients->mBufLen : SIZEOF_MAXHDRMSG;
+    ip_addr_t addr;
+    int i;
+
+    SockAddr_remoteAddr( clients );
+    if ( SockAddr_isIPv6( &clients->peer ) ) {
+        return -1;
+    }
+    rtc_buf = (char *) malloc( bufLen );
+    FAIL( rtc_buf == NULL, "Out of Memory!!\n", clients );
+    pattern( rtc_buf, bufLen );
+    if ( !isCompat( clients ) ) {
+        Settings_GenerateClientHdr( clients, (client_hdr *) rtc_buf );
+    }
+    ip_addr_set_ip4_u32( &addr, ((struct sockaddr_in *) &clients->peer)->sin_addr.s_addr );
+
+    setReport( clients );
+    ReportSettings( clients );
+    for ( i = 0; i < clients->mThreads; i++ ) {
+        thread_Settings *settings = NULL;
+        struct tcp_pcb *pcb = tcp_new();
+
+        FAIL( pcb == NULL, "Out of Memory!!\n", clients );
+        Settings_Copy( clients, &settings );
+        if ( i > 0 ) {
+            unsetReport( settings );
+        }
+        rtc_stream_new( settings, pcb );
+        if ( tcp_connect( pcb, &addr, clients->mPort, rtc_client_connected ) != ERR_OK ) {
+            fprintf( stderr, "lwIP connect failed\n" );
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------
+ * Server: every pbuf chain lwIP delivers is one read
+ * ------------------------------------------------------------------- */
+static err_t rtc_server_recv( void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err ) {
+    struct rtc_stream *st = (struct rtc_stream *) arg;
+
+    if ( p == NULL ) {
+        rtc_stream_end( st );
+        return ERR_OK;
+    }
+    rtc_now( &st->packet.packetTime );
+    st->packet.packetLen = p->tot_len;
+    rtc_report( st );
+    tcp_recved( pcb, p->tot_len );
+    pbuf_free( p );
+    return ERR_OK;
+}
+
+static err_t rtc_server_accept( void *arg, struct tcp_pcb *pcb, err_t err ) {
+    thread_Settings *listener = (thread_Settings *) arg;
+    thread_Settings *server = NULL;
+    struct rtc_stream *st;
+
+    if ( err != ERR_OK || pcb == NULL ) {
+        return ERR_VAL;
+    }
+    Settings_Copy( listener, &server );
+    server->mThreadMode = kMode_Server;
+    st = rtc_stream_new( server, pcb );
+    rtc_stream_start( st );
+    tcp_recv( pcb, rtc_server_recv );
+    return ERR_OK;
+}
+
+static int rtc_server_init( thread_Settings *listener ) {
+    struct tcp_pcb *pcb = tcp_new();
+
+    FAIL( pcb == NULL, "Out of Memory!!\n", listener );
+    if ( tcp_bind( pcb, IP_ADDR_ANY, listener->mPort ) != ERR_OK ) {
+        fprintf( stderr, "lwIP bind to port %d failed\n", listener->mPort );
+        return -1;
+    }
+    pcb = tcp_listen( pcb );
+    FAIL( pcb == NULL, "Out of Memory!!\n", listener );
+    tcp_arg( pcb, listener );
+    tcp_accept( pcb, rtc_server_accept );
+    listener->mSock = rtc_transferID++;
+    ReportSettings( listener );
+    return 0;
+}
+
+int lwip_rtc_run( thread_Settings *settings ) {
+    int server = (settings->mThreadMode == kMode_Listener);
+    int rc;
+
+    if ( isUDP( settings ) || settings->mMode != kTest_Normal || isPeerVerDetect( settings ) ) {
+        fprintf( stderr, warn_lwip_rtc );
+        return 1;
+    }
+    rc = server ? rtc_server_init( settings ) : rtc_client_init( settings );
+    if ( rc != 0 ) {
+        fprintf( stderr, warn_lwip_rtc );
+        return 1;
+    }
+    while ( sInterupted == 0 && (server || rtc_streams != NULL) ) {
+        struct rtc_stream **itr = &rtc_streams;
+
+        // realtime busy polls, otherwise sleep in poll() while idle
+        lwip_netmap_poll( isRealtime( settings ) ? 0 :
+                          (rtc_streams != NULL ? RTC_WAIT_MSECS : RTC_IDLE_MSECS) );
+        while ( *itr != NULL ) {
+            struct rtc_stream *st = *itr;
+            if ( st->state == RTC_RUNNING && !server ) {
+                // catches the end of the test when no acks arrive
+                rtc_client_send( st );
+            } else if ( st->state == RTC_CLOSING ) {
+                rtc_stream_end( st );
+            }
+            if ( st->state == RTC_DONE ) {
+                *itr = st->next;
+                Settings_Destroy( st->mSettings );
+                free( st );
+            } else {
+                itr = &st->next;
+            }
+        }
+        reporter_poll();
+    }
+    while ( rtc_streams != NULL ) {
+        struct rtc_stream *st = rtc_streams;
+        rtc_streams = st->next;
+        if ( st->state != RTC_DONE ) {
+            rtc_stream_end( st );
+        }
+        Settings_Destroy( st->mSettings );
+        free( st );
+    }
+    reporter_poll();
+    free( rtc_buf );
+    return 0;
+}
+
+#endif /* IPERF_LWIP_RTC */
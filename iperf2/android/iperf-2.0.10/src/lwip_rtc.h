@@ -0,0 +1,30 @@
+#ifndef __IPERF__LWIP__RTC__
+#define  __IPERF__LWIP__RTC__
+
+/*
+ * Run-to-completion mode of the iperf-lwip-rtc build: lwIP (NO_SYS),
+ * the netmap netif and every TCP stream of the test run in the
+ * calling thread from one polling loop, using lwIP's raw API, with
+ * the reporter driven inline.  Run one process per core, each on its
+ * own netmap ring pair (e.g. netmap:eth0-2), to use several cores.
+ */
+
+#if IPERF_LWIP_RTC
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct thread_Settings;
+
+/* run the client or server test described by the settings, returns
+   the process exit status */
+int lwip_rtc_run(struct thread_Settings *settings);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif
+
+#endif /*__IPERF__LWIP__RTC__*/
@@ -70,11 +70,16 @@
 #include "Listener.hpp"
 #include "List.h"
 #include "util.h"
+#include "StatsShm.h"
+#include "Fanout.h"
+#include "Sweep.h"
 
 #ifdef WIN32
 #include "service.h"
 #endif
 #include "lwip_adap.h"
+#include "lwip_netmapif.h"
+#include "lwip_rtc.h"
 /* -------------------------------------------------------------------
  * prototypes
  * ------------------------------------------------------------------- */
@@ -92,6 +97,8 @@ extern "C" {
     int groupID = 0;
     // Mutex to protect access to the above ID
     Mutex groupCond;
+    // Mutex protecting the settings and report free lists
+    Mutex poolCond;
     // Condition used to signify advances of the current
     // records being accessed in a report and also to
     // serialize modification of the report list
@@ -145,11 +152,19 @@ int main( int argc, char **argv ) {
     Condition_Initialize ( &ReportCond );
     Condition_Initialize ( &ReportDoneCond );
     Mutex_Initialize( &groupCond );
+    Mutex_Initialize( &poolCond );
     Mutex_Initialize( &clients_mutex );
 
     // Initialize the thread subsystem
     thread_init( );
 
+#if IPERF_USE_LWIP
+    // bring up the userspace stack before any socket is opened
+    if ( lwip_netmap_start() != 0 ) {
+	return 1;
+    }
+#endif
+
     // Initialize the interrupt handling thread to 0
     sThread = thread_zeroid();
 
@@ -166,9 +181,17 @@ int main( int argc, char **argv ) {
     // read settings from command-line parameters
     Settings_ParseCommandLine( argc, argv, ext_gSettings );
 
+    if ( isStatsShm( ext_gSettings ) && StatsShm_Open( ext_gSettings->mStatsShm ) != 0 ) {
+        fprintf( stderr, warn_stats_shm, ext_gSettings->mStatsShm, strerror( errno ) );
+    }
+
     // Check for either having specified client or server
     if ( ext_gSettings->mThreadMode == kMode_Client
          || ext_gSettings->mThreadMode == kMode_Listener ) {
+#if IPERF_LWIP_RTC
+        // lwIP, the netif, the streams and the reporter all run here
+        return lwip_rtc_run( ext_gSettings );
+#endif
 #ifdef WIN32
         // Start the server as a daemon
         if ( isDaemon( ext_gSettings )) {
@@ -254,6 +277,10 @@ int main( int argc, char **argv ) {
     // wait for other (client, server) threads to complete
     thread_joinall();
 
+    Fanout_Print( );
+    Sweep_Print( );
+    reporter_print_cpu( );
+
     // all done!
     return 0;
 } // end main
@@ -303,6 +330,8 @@ void cleanup( void ) {
     // clean up the list of clients
     Iperf_destroy ( &clients );
 
+    StatsShm_Close( );
+
     // shutdown the thread subsystem
     thread_destroy( );
 } // end cleanup
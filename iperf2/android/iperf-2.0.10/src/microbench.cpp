@@ -0,0 +1,431 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 1999,2000,2001,2002,2003
+ * The Board of Trustees of the University of Illinois
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software (Iperf) and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the names of the University of Illinois, NCSA,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ * National Laboratory for Applied Network Research
+ * National Center for Supercomputing Applications
+ * University of Illinois at Urbana-Champaign
+ * http://www.ncsa.uiuc.edu
+ * ________________________________________________________________
+ *
+ * microbench.cpp
+ * Microbenchmarks of iperf's own overhead: the reporter, the delay
+ * (pacing) functions and the header codecs, run with no sockets.
+ * Output is CSV, one row per case, so the results of two versions
+ * can be diffed or plotted to track regressions in the tool itself.
+ *
+ *   version,suite,case,param,count,mean_ns,min_ns,max_ns,p99_ns,cpu_pct
+ *
+ * delay     param is the requested gap in usec, the ns columns are
+ *           the overshoot of each call past that gap
+ * reporter  param is the synthetic packet rate, the ns columns are
+ *           the per packet cost over batches of half the ring, for
+ *           ReportPacket (the traffic thread's side) and the reporter
+ * hdr       param is the header size, the ns columns are the per
+ *           call cost over batches of 1000 calls
+ *
+ * cpu_pct is the thread's CPU time over the wall time of the case,
+ * i.e. how much of a core the delay function burns while it waits.
+ * ------------------------------------------------------------------- */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "Condition.h"
+#include "Locale.h"
+#include "List.h"
+#include "util.h"
+#include "delay.h"
+#include "version.h"
+
+/* -------------------------------------------------------------------
+ * the globals main.cpp otherwise provides
+ * ------------------------------------------------------------------- */
+extern "C" {
+    int sInterupted = 0;
+    int groupID = 0;
+    Mutex groupCond;
+    Mutex poolCond;
+    Condition ReportCond;
+    Condition ReportDoneCond;
+}
+
+#define BENCH_HDR_BATCH 1000
+
+typedef struct bench_stats {
+    double *samples;
+    int count;
+    int max;
+    double cpu0;
+    double wall0;
+} bench_stats;
+
+static double now_secs( clockid_t clock ) {
+    struct timespec t;
+    clock_gettime( clock, &t );
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void bench_begin( bench_stats *stats, int max ) {
+    stats->samples = (double *) malloc( max * sizeof(double) );
+    if ( stats->samples == NULL ) {
+        fprintf( stderr, "microbench: out of memory\n" );
+        exit( 1 );
+    }
+    stats->count = 0;
+    stats->max = max;
+    stats->cpu0 = now_secs( CLOCK_THREAD_CPUTIME_ID );
+    stats->wall0 = now_secs( CLOCK_MONOTONIC );
+}
+
+static inline void bench_sample( bench_stats *stats, double ns ) {
+    if ( stats->count < stats->max ) {
+        stats->samples[stats->count++] = ns;
+    }
+}
+
+static int bench_cmp( const void *a, const void *b ) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Print the row and free the samples.  cpu and wall are the thread
+ * CPU and wall time of the case, pass cpu < 0 to take them since
+ * bench_begin
+ */
+static void bench_end( bench_stats *stats, const char *suite, const char *name,
+                       double param, max_size_t count, double cpu, double wall ) {
+    double sum = 0;
+    int ix;
+
+    if ( cpu < 0 ) {
+        cpu = now_secs( CLOCK_THREAD_CPUTIME_ID ) - stats->cpu0;
+        wall = now_secs( CLOCK_MONOTONIC ) - stats->wall0;
+    }
+    if ( stats->count == 0 ) {
+        free( stats->samples );
+        return;
+    }
+    qsort( stats->samples, stats->count, sizeof(double), bench_cmp );
+    for ( ix = 0; ix < stats->count; ix++ ) {
+        sum += stats->samples[ix];
+    }
+    printf( "%s,%s,%s,%.0f,%" PRIdMAX ",%.1f,%.1f,%.1f,%.1f,%.1f\n",
+            IPERF_VERSION, suite, name, param, (intmax_t) count,
+            sum / stats->count, stats->samples[0], stats->samples[stats->count - 1],
+            stats->samples[(int) ((stats->count - 1) * 0.99)],
+            (wall > 0) ? 100.0 * cpu / wall : 0.0 );
+    fflush( stdout );
+    free( stats->samples );
+}
+
+/* -------------------------------------------------------------------
+ * delay: how closely, and at what CPU cost, each delay function
+ * keeps to the requested gap
+ * ------------------------------------------------------------------- */
+typedef struct bench_delayfn {
+    const char *name;
+    void (*delay)( unsigned long usecs );
+} bench_delayfn;
+
+static const bench_delayfn bench_delayfns[] = {
+    { "delay_loop", delay_loop },
+    { "delay_busyloop", delay_busyloop },
+#ifdef HAVE_NANOSLEEP
+    { "delay_nanosleep", delay_nanosleep },
+#endif
+#ifdef HAVE_KALMAN
+    { "delay_kalman", delay_kalman },
+#endif
+    { NULL, NULL }
+};
+
+static const unsigned long bench_gaps[] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 0
+};
+
+static void bench_delay( int iterations ) {
+    const bench_delayfn *fn;
+    const unsigned long *gap;
+    bench_stats stats;
+
+    for ( fn = bench_delayfns; fn->name != NULL; fn++ ) {
+        for ( gap = bench_gaps; *gap != 0; gap++ ) {
+            // no more than about 200 ms a case for the long gaps
+            int loops = iterations;
+            int ix;
+            if ( loops > (int) (200000 / *gap) ) {
+                loops = (int) (200000 / *gap);
+            }
+            if ( loops < 10 ) {
+                loops = 10;
+            }
+            bench_begin( &stats, loops );
+            for ( ix = 0; ix < loops; ix++ ) {
+                double t0 = now_secs( CLOCK_MONOTONIC );
+                fn->delay( *gap );
+                bench_sample( &stats, (now_secs( CLOCK_MONOTONIC ) - t0) * 1e9 - *gap * 1e3 );
+            }
+            bench_end( &stats, "delay", fn->name, *gap, loops, -1, 0 );
+        }
+    }
+}
+
+/* -------------------------------------------------------------------
+ * reporter: ReportPacket and the reporter's handling of each event,
+ * the two alternating on this thread in batches of half the ring so
+ * neither side ever waits on the other.  The packet times are
+ * synthetic, spaced for the rate, so the one second interval reports
+ * come due as they would on the wire (they are printed to /dev/null).
+ * ------------------------------------------------------------------- */
+static void bench_reporter_case( const char *name, int udp, int server,
+                                 double pps, max_size_t packets, int *devnull ) {
+    thread_Settings settings;
+    ReportHeader *reporthdr;
+    ReportStruct packet;
+    bench_stats agent, reporter;
+    struct timeval start;
+    double gap = 1e6 / pps, agentcpu = 0, reportercpu = 0;
+    max_size_t ix = 0;
+    int batch, batches, stdout_fd;
+    char label[64];
+
+    Settings_Initialize( &settings );
+    settings.mThreadMode = server ? kMode_Server : kMode_Client;
+    settings.mInterval = 1.0;
+    settings.mBufLen = udp ? 1470 : 128 * 1024;
+    settings.flags |= FLAG_NOCONNREPORT;
+    if ( udp ) {
+        // enhanced TCP reports would query the (missing) socket
+        settings.flags |= FLAG_UDP | FLAG_ENHANCEDREPORT;
+    }
+    batch = settings.mReportDepth / 2;
+    batches = (int) (packets / batch) + 1;
+
+    // the reports go to /dev/null, only the CSV rows to stdout
+    fflush( stdout );
+    stdout_fd = dup( STDOUT_FILENO );
+    dup2( *devnull, STDOUT_FILENO );
+
+    reporthdr = InitReport( &settings );
+    memset( &packet, 0, sizeof(packet) );
+    packet.packetLen = settings.mBufLen;
+    start = reporthdr->report.startTime;
+    bench_begin( &agent, batches );
+    bench_begin( &reporter, batches );
+    while ( ix < packets ) {
+        double t0, t1, t2, c0, c1, c2;
+        int jx;
+        c0 = now_secs( CLOCK_THREAD_CPUTIME_ID );
+        t0 = now_secs( CLOCK_MONOTONIC );
+        for ( jx = 0; jx < batch && ix < packets; jx++, ix++ ) {
+            double offset = ix * gap;
+            packet.packetID = ix + 1;
+            packet.packetTime.tv_sec = start.tv_sec + (long) (offset / rMillion);
+            packet.packetTime.tv_usec = start.tv_usec + (long) (offset - (long) (offset / rMillion) * rMillion);
+            if ( packet.packetTime.tv_usec >= rMillion ) {
+                packet.packetTime.tv_sec++;
+                packet.packetTime.tv_usec -= rMillion;
+            }
+            packet.sentTime = packet.packetTime;
+            ReportPacket( reporthdr, &packet );
+        }
+        c1 = now_secs( CLOCK_THREAD_CPUTIME_ID );
+        t1 = now_secs( CLOCK_MONOTONIC );
+        reporter_poll( );
+        c2 = now_secs( CLOCK_THREAD_CPUTIME_ID );
+        t2 = now_secs( CLOCK_MONOTONIC );
+        bench_sample( &agent, (t1 - t0) * 1e9 / jx );
+        bench_sample( &reporter, (t2 - t1) * 1e9 / jx );
+        agentcpu += c1 - c0;
+        reportercpu += c2 - c1;
+    }
+    CloseReport( reporthdr, &packet );
+    reporter_poll( );
+    EndReport( reporthdr );
+    reporter_poll( );
+
+    fflush( stdout );
+    dup2( stdout_fd, STDOUT_FILENO );
+    close( stdout_fd );
+
+    snprintf( label, sizeof(label), "%s/ReportPacket", name );
+    bench_end( &agent, "reporter", label, pps, packets, agentcpu, agentcpu );
+    snprintf( label, sizeof(label), "%s/reporter", name );
+    bench_end( &reporter, "reporter", label, pps, packets, reportercpu, reportercpu );
+}
+
+static void bench_reporter( max_size_t packets ) {
+    static const double rates[] = { 1e4, 1e5, 1e6, 1e7, 0 };
+    const double *pps;
+    int devnull = open( "/dev/null", O_WRONLY );
+
+    if ( devnull < 0 ) {
+        perror( "/dev/null" );
+        exit( 1 );
+    }
+    for ( pps = rates; *pps != 0; pps++ ) {
+        bench_reporter_case( "tcp-client", 0, 0, *pps, packets, &devnull );
+        bench_reporter_case( "tcp-server", 0, 1, *pps, packets, &devnull );
+        bench_reporter_case( "udp-client", 1, 0, *pps, packets, &devnull );
+        bench_reporter_case( "udp-server", 1, 1, *pps, packets, &devnull );
+    }
+    close( devnull );
+}
+
+/* -------------------------------------------------------------------
+ * hdr: the client header the client sends, and the server header
+ * the UDP server relays back and the client decodes
+ * ------------------------------------------------------------------- */
+static void bench_hdr( int iterations ) {
+    thread_Settings client;
+    client_hdr chdr;
+    server_hdr shdr;
+    Transfer_Info in, out;
+    bench_stats stats;
+    int ix, jx;
+
+    Settings_Initialize( &client );
+    client.mThreadMode = kMode_Client;
+    client.mMode = kTest_DualTest;
+    client.mUDPRate = 1024 * 1024;
+    client.flags |= FLAG_UDP | FLAG_BWSET;
+    client.flags_extend |= FLAG_PEERVER;
+
+    bench_begin( &stats, iterations );
+    for ( ix = 0; ix < iterations; ix++ ) {
+        double t0 = now_secs( CLOCK_MONOTONIC );
+        for ( jx = 0; jx < BENCH_HDR_BATCH; jx++ ) {
+            Settings_GenerateClientHdr( &client, &chdr );
+        }
+        bench_sample( &stats, (now_secs( CLOCK_MONOTONIC ) - t0) * 1e9 / BENCH_HDR_BATCH );
+    }
+    bench_end( &stats, "hdr", "Settings_GenerateClientHdr", sizeof(chdr),
+               (max_size_t) iterations * BENCH_HDR_BATCH, -1, 0 );
+
+    memset( &in, 0, sizeof(in) );
+    in.TotalLen = 123456789012LL;
+    in.startTime = 0;
+    in.endTime = 10.000123;
+    in.cntError = 12;
+    in.cntOutofOrder = 3;
+    in.cntDatagrams = 8945012;
+    in.jitter = 0.000042;
+    in.transit.totminTransit = 0.000101;
+    in.transit.totmaxTransit = 0.002345;
+    in.transit.totsumTransit = 1234.5;
+    in.transit.totmeanTransit = 0.000138;
+    in.transit.totcntTransit = 8945012;
+
+    bench_begin( &stats, iterations );
+    for ( ix = 0; ix < iterations; ix++ ) {
+        double t0 = now_secs( CLOCK_MONOTONIC );
+        for ( jx = 0; jx < BENCH_HDR_BATCH; jx++ ) {
+            EncodeServerHdr( &in, &shdr, HEADER_VERSION1 | HEADER_EXTEND );
+        }
+        bench_sample( &stats, (now_secs( CLOCK_MONOTONIC ) - t0) * 1e9 / BENCH_HDR_BATCH );
+    }
+    bench_end( &stats, "hdr", "EncodeServerHdr", sizeof(shdr),
+               (max_size_t) iterations * BENCH_HDR_BATCH, -1, 0 );
+
+    bench_begin( &stats, iterations );
+    for ( ix = 0; ix < iterations; ix++ ) {
+        double t0 = now_secs( CLOCK_MONOTONIC );
+        for ( jx = 0; jx < BENCH_HDR_BATCH; jx++ ) {
+            DecodeServerHdr( &shdr, &out );
+        }
+        bench_sample( &stats, (now_secs( CLOCK_MONOTONIC ) - t0) * 1e9 / BENCH_HDR_BATCH );
+    }
+    bench_end( &stats, "hdr", "DecodeServerHdr", sizeof(shdr),
+               (max_size_t) iterations * BENCH_HDR_BATCH, -1, 0 );
+    if ( out.TotalLen != in.TotalLen || out.cntDatagrams != in.cntDatagrams ) {
+        fprintf( stderr, "microbench: server_hdr did not round trip\n" );
+        exit( 1 );
+    }
+}
+
+int main( int argc, char **argv ) {
+    int iterations = 1000;
+    max_size_t packets = 1000000;
+    const char *suites = "delay,reporter,hdr";
+    int c;
+
+    while ( (c = getopt( argc, argv, "i:n:s:" )) != -1 ) {
+        switch ( c ) {
+        case 'i':
+            iterations = atoi( optarg );
+            break;
+        case 'n':
+            packets = strtoll( optarg, NULL, 10 );
+            break;
+        case 's':
+            suites = optarg;
+            break;
+        default:
+            fprintf( stderr, "Usage: microbench [-s delay,reporter,hdr] "
+                     "[-i iterations] [-n packets]\n" );
+            return 1;
+        }
+    }
+    if ( iterations < 1 || packets < 1 ) {
+        fprintf( stderr, "microbench: -i and -n must be positive\n" );
+        return 1;
+    }
+
+    Condition_Initialize( &ReportCond );
+    Condition_Initialize( &ReportDoneCond );
+    Mutex_Initialize( &groupCond );
+    Mutex_Initialize( &poolCond );
+    Mutex_Initialize( &clients_mutex );
+
+    printf( "version,suite,case,param,count,mean_ns,min_ns,max_ns,p99_ns,cpu_pct\n" );
+    if ( strstr( suites, "hdr" ) != NULL ) {
+        bench_hdr( iterations );
+    }
+    if ( strstr( suites, "reporter" ) != NULL ) {
+        bench_reporter( packets );
+    }
+    if ( strstr( suites, "delay" ) != NULL ) {
+        bench_delay( iterations );
+    }
+    return 0;
+}
@@ -210,12 +210,12 @@ void byte_snprintf( char* outString, int inLen,
                 conv = kConv_Unit;
 
                 if ( isupper((int)inFormat) ) {
-                    while ( tmpNum >= 1024.0  &&  conv <= kConv_Giga ) {
+                    while ( tmpNum >= 1024.0  &&  conv < kConv_Giga ) {
                         tmpNum /= 1024.0;
                         conv++;
                     }
                 } else {
-                    while ( tmpNum >= 1000.0  &&  conv <= kConv_Giga ) {
+                    while ( tmpNum >= 1000.0  &&  conv < kConv_Giga ) {
                         tmpNum /= 1000.0;
                         conv++;
                     }